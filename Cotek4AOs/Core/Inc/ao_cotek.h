@@ -8,9 +8,10 @@
 extern "C" {
 #endif
 
-    extern QActive *AO_Cotek;
+    extern QActive *AO_Cotek;             // bay 0
     void CotekAO_ctor(void);
-    uint8_t Cotek_isPresent(void);
+    uint8_t Cotek_isPresent(void);        // bay 0
+    uint8_t Cotek_isPresentCh(uint8_t ch);
 
 #ifdef __cplusplus
 }
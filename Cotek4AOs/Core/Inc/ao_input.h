@@ -0,0 +1,28 @@
+#ifndef AO_INPUT_H
+#define AO_INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "qpc.h"
+#include "app_signals.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Board inputs: EXTI edges wake AO_Input, which samples them on the fast
+ * tick until they settle and turns them into button gestures. The e-stop
+ * trips from the edge ISR itself, straight to every Cotek AO. */
+extern QActive *const AO_Input;
+void InputAO_ctor(void);
+
+// called from HAL_GPIO_EXTI_Callback()
+void Input_onEdgeISR(uint16_t pin);
+
+bool     Input_estopActive(void);     /* latched until the loop closes again */
+uint32_t Input_estopCycles(void);     /* BSP_cycles() at the last trip */
+
+#ifdef __cplusplus
+}
+#endif
+#endif
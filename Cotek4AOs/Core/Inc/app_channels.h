@@ -0,0 +1,85 @@
+//
+// Multi-bay wiring: one BMS + Cotek + Controller AO triple per channel.
+//
+// APP_NUM_CHANNELS defaults to 1, which is the original single-bay build
+// (AO_Bms / AO_Cotek / AO_Controller are channel 0). Each channel owns a CAN
+// id partition and a PSU I2C address; the Nextion panel shows one channel at
+// a time and only that channel's Controller talks to it.
+//
+#ifndef APP_CHANNELS_H
+#define APP_CHANNELS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "qpc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef APP_NUM_CHANNELS
+#define APP_NUM_CHANNELS  1U
+#endif
+
+#ifdef APP_USE_QK
+/* QK (preemptive): priority is latency. BMS (safety) preempts everything,
+ * the PSUs preempt the Controllers, the HMI runs in whatever is left. */
+#define APP_PRIO_NEXTION     2U
+#define APP_PRIO_CTL(ch_)    (3U + (ch_))
+#define APP_PRIO_COTEK(ch_)  (3U + APP_NUM_CHANNELS + (ch_))
+#define APP_PRIO_BMS(ch_)    (3U + 2U * APP_NUM_CHANNELS + (ch_))
+#define APP_PRIO_INPUT       (3U + 3U * APP_NUM_CHANNELS)  /* short steps, never blocks */
+#define APP_KERNEL_NAME      "QK"
+#else
+/* QV (cooperative): priority only orders the ready queues. All PSU AOs
+ * below all BMS AOs below all Controllers; the HMI sits on top. With one
+ * channel this is the original 2/3/4/5 layout. */
+#define APP_PRIO_COTEK(ch_)  (2U + (ch_))
+#define APP_PRIO_BMS(ch_)    (2U + APP_NUM_CHANNELS + (ch_))
+#define APP_PRIO_CTL(ch_)    (2U + 2U * APP_NUM_CHANNELS + (ch_))
+#define APP_PRIO_NEXTION     (2U + 3U * APP_NUM_CHANNELS)
+#define APP_PRIO_INPUT       (3U + 3U * APP_NUM_CHANNELS)
+#define APP_KERNEL_NAME      "QV"
+#endif
+
+/* Resource shared by AOs up to priority ceil_ (e.g. I2C1 across the Cotek
+ * AOs). QV runs every AO to completion, so this is free; under QK it locks
+ * the scheduler up to the ceiling, higher AOs still preempt. */
+#ifdef APP_USE_QK
+#define APP_LOCK(ceil_)      QSchedStatus const app_lock_ = QK_schedLock((uint_fast8_t)(ceil_))
+#define APP_UNLOCK()         QK_schedUnlock(app_lock_)
+#else
+#define APP_LOCK(ceil_)      ((void)0)
+#define APP_UNLOCK()         ((void)0)
+#endif
+#define APP_CEIL_COTEK       APP_PRIO_COTEK(APP_NUM_CHANNELS - 1U)
+
+/* A bay owns the source addresses can_sa .. can_sa + can_sa_span - 1 (low id
+ * byte): the pack's master at can_sa, its slave nodes above it. */
+typedef struct {
+    uint8_t  can_sa;         /* J1939 source address of the pack master            */
+    uint8_t  can_sa_span;    /* 0 = accept everything (single-bay)                 */
+    uint16_t psu_i2c_addr;   /* 8-bit HAL address (7-bit << 1)                     */
+} AppChannelCfg;
+
+extern AppChannelCfg const g_appChannels[APP_NUM_CHANNELS];
+
+/* Per-channel AO handles (index = channel) */
+extern QActive *AO_BmsCh[APP_NUM_CHANNELS];
+extern QActive *AO_CotekCh[APP_NUM_CHANNELS];
+extern QActive *AO_ControllerCh[APP_NUM_CHANNELS];
+
+/* CAN id -> channel by source address; APP_NUM_CHANNELS when no bay claims
+ * it. *id gets the frame id with the bay's SA base taken off the low byte,
+ * so node 0 is the bay's master as in a single-bay setup (ISR-safe). */
+uint8_t App_routeCanId(uint32_t raw, uint32_t *id);
+
+/* HMI multiplexing */
+uint8_t  App_hmiChannel(void);
+QActive *App_hmiController(void);
+void     App_hmiSelect(uint8_t ch);   /* tells the new owner to repaint */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* APP_CHANNELS_H */
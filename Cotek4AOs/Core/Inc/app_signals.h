@@ -12,10 +12,10 @@
 /* Signals (publishable first; order matters for MAX_PUB_SIG) */
 enum AppSignals {
     /* ====== PUBLISHED signals (must be < MAX_PUB_SIG) ====== */
-    CAN_RX_SIG = Q_USER_SIG,   /* from CAN ISR -> publish; BMS subscribes   */
-    BMS_UPDATED_SIG,           /* BMS publishes telemetry snapshots         */
-    BMS_NO_BATTERY_SIG,        /* BMS publishes: no traffic yet             */
-    BMS_CONN_LOST_SIG,         /* BMS publishes: data stale                 */
+    CAN_RX_SIG = Q_USER_SIG,   /* CAN ISR -> owning bay's BMS (direct post) */
+    BMS_UPDATED_SIG,           /* BMS publishes telemetry; tagged with bay  */
+    BMS_NO_BATTERY_SIG,        /* BMS -> its Controller: no traffic yet     */
+    BMS_CONN_LOST_SIG,         /* BMS -> its Controller: data stale         */
 
 
 
@@ -39,6 +39,8 @@ enum AppSignals {
     NEX_REQ_UPDATE_LIVE_SIG,
     NEX_REQ_UPDATE_DETAILS_SIG,
     NEX_REQ_UPDATE_PSU_SIG,
+    NEX_REQ_UPDATE_CELLS_SIG,  /* Controller -> Nextion (pCells)             */
+    NEX_REQ_UPDATE_FAULTS_SIG, /* Controller -> Nextion (pFaults)            */
         /* PSU control/status (direct posts) */
     PSU_REQ_SETPOINT_SIG,      /* Controller -> Cotek                        */
     PSU_REQ_OFF_SIG,           /* Controller -> Cotek                        */
@@ -46,10 +48,22 @@ enum AppSignals {
     // ---- Cotek status broadcast (AO_Cotek -> AO_Controller) ----
     COTEK_STATUS_SIG,     // carries PSU presence, out state, and latest readings
     COTEK_TICK_SIG,
+    COTEK_RAMP_SIG,       // private: setpoint slew step
+    J1939_MSG_SIG,             /* CAN ISR -> BMS: reassembled TP / DM1 message */
 
     /* Board button (direct posts) */
     BUTTON_PRESSED_SIG,
     BUTTON_RELEASED_SIG,
+    BUTTON_LONG_PRESS_SIG,     /* Input -> HMI Controller: held INPUT_LONG_MS  */
+    INPUT_EDGE_SIG,            /* EXTI -> Input: start sampling              */
+    INPUT_SAMPLE_SIG,          /* private sampling tick of AO_Input          */
+    ESTOP_SIG,                 /* e-stop ISR -> every Cotek -> its Controller */
+    ESTOP_RELEASE_SIG,         /* Input -> every Cotek -> its Controller     */
+    HMI_SELECT_SIG,            /* panel switched to this Controller's bay    */
+    FAULT_HIST_CLEAR_SIG,      /* Nextion -> Controller: pFaults "clear"     */
+#ifdef ENABLE_NEX_EMU
+    NEX_EMU_TICK_SIG,          /* private report tick for the HMI emulator   */
+#endif
 };
 
 
@@ -60,6 +74,7 @@ typedef struct {
     uint8_t  dlc;
     uint8_t  data[8];
     uint8_t  isExt;     /* 0=std,1=ext */
+    uint32_t rx_cyc;    /* BSP_cycles() at ISR post, for AO_Bms latency */
 } CanFrameEvt;
 
 /* BMS telemetry (unified) */
@@ -87,11 +102,22 @@ typedef struct {
 
     uint16_t battery_type_code;  /* 0x400=400s, 0x500=500s, 0x600=600s */
     int16_t  current_dA;         /* deci-amps (+ charge, - discharge) */
+
+    uint8_t  nodes_seen;         /* BMS boards on the bus (400s master/slaves) */
+    uint8_t  nodes_fresh;        /* ... of which heard from recently          */
+
+    uint8_t  cell_count;         /* cells in the per-cell map (0 = hi/lo only) */
+    float    cell_avg_V;
+    float    cell_spread_V;      /* max - min over the map */
+
+    uint8_t  dtc_count;          /* active J1939 DTCs from the last DM1 */
 } BmsTelemetry;
 
-/* Published telemetry event */
+/* Published telemetry event: one block shared by every subscriber,
+ * which picks its own bay by ch */
 typedef struct {
     QEvt        super;
+    uint8_t     ch;
     BmsTelemetry data;
     uint8_t     _pad[8];   /* keep larger than CanFrameEvt */
 } BmsTelemetryEvt;
@@ -133,7 +159,7 @@ typedef struct {
 /* Nextion: change page */
 typedef struct {
     QEvt super;
-    uint8_t page;  /* 0=splash,1=wait,2=main,3=details */
+    uint8_t page;  /* 0=splash,1=wait,2=main,3=details,4=cells,5=faults */
 } NextionPageEvt;
 
 /* Nextion: summary payload for pMain */
@@ -185,12 +211,43 @@ typedef struct {
     uint16_t fan_speed_rpm;
 
     uint8_t soc_percent;
-    uint8_t soc2_percent;
+    uint8_t soc2_percent;       // coulomb-counted while charging, else = soc
+
+    float    charged_Ah;        // this / last charge session
+    float    charged_Wh;
+    uint16_t ttf_min;           // time to full, 0xFFFF = not charging / unknown
 
     char  bms_state_str[24];   // text for current state
     char  bms_fault_str[48];   // combined faults text
 } NextionDetailsEvt;
 
+// ----- per-cell view shown on pCells -----
+#define NEX_CELLS_SHOWN  16U
+typedef struct {
+    QEvt super;
+    uint8_t  count;                    // cells in the BMS map (can exceed shown)
+    uint8_t  shown;
+    uint8_t  nodes_seen, nodes_fresh;
+    uint8_t  spread_warn;              // spread above the recoverability limit
+    uint16_t min_mV, max_mV, avg_mV, spread_mV;
+    uint16_t cell_mV[NEX_CELLS_SHOWN];
+} NextionCellsEvt;
+
+// ----- fault history shown on pFaults (most recent first) -----
+#define NEX_FAULT_ROWS  6U
+typedef struct {
+    char     text[28];
+    uint16_t count;
+    uint8_t  active;
+    uint32_t first_age_s, last_age_s;
+} NextionFaultRow;
+typedef struct {
+    QEvt super;
+    uint8_t  total;                    // distinct faults in the history
+    uint8_t  shown;
+    NextionFaultRow row[NEX_FAULT_ROWS];
+} NextionFaultsEvt;
+
 typedef struct {
     QEvt super;
     // BMS
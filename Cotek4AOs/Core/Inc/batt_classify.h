@@ -1,12 +1,25 @@
 //
 // Created by sorin.mihai on 06/10/2025.
 //
+// Classification is table driven: each family has a const 256-bit map of
+// error codes that make a pack not recoverable, plus a threshold set that
+// lives in RAM and can be replaced at runtime (batt_classify_set_thresholds,
+// QSPY command BSP_QS_CMD_THRESHOLDS) without touching the logic. Inputs are
+// quantized to BATT_Q_MV towards the failing side of each gate and the last
+// few results are memoized, so repeated calls on steady telemetry are a lookup.
+//
 
 #pragma once
 #include <stdint.h>
 #include <stdbool.h>
 #include "bms_app.h"   // for BmsTelemetry (already in your project)
 
+/* Cell spread (max - min) above this blocks recovery. Starting value; applied
+ * only when the BMS reports individual cells (BmsTelemetry.cell_count >= 2). */
+#define BATT_SPREAD_MAX_V   0.30f
+
+#define BATT_Q_MV           10U     /* voltage quantum for evaluation + memo */
+
 /* Three classes (plus Unknown when inputs are insufficient or SIM active) */
 typedef enum {
     BATT_CLASS_UNKNOWN = 0,
@@ -15,13 +28,41 @@ typedef enum {
     BATT_CLASS_OPERATIONAL,
 } BattClass;
 
+/* Why the class was picked; batt_why_text() for a short UI/log string */
+typedef enum {
+    BATT_WHY_SIM = 0,           /* BMS SIM active */
+    BATT_WHY_NO_DATA,           /* type / cell voltages missing */
+    BATT_WHY_UNKNOWN_FAMILY,    /* no rule for battery_type_code */
+    BATT_WHY_NR_CODE,           /* last_error_code is in the family's NR map */
+    BATT_WHY_SPREAD,            /* cell spread > spread_max_mV */
+    BATT_WHY_IN_WINDOW,         /* min_mV <= vmin and vmax <= max_mV */
+    BATT_WHY_ABOVE_MAX,         /* vmax > max_mV */
+    BATT_WHY_BELOW_MIN,         /* vmin < min_mV */
+    BATT_WHY_COUNT
+} BattWhy;
+
+/* Per-family limits, all in mV */
+typedef struct {
+    uint16_t min_mV;            /* lowest cell still recoverable */
+    uint16_t max_mV;            /* highest cell still "needs recovery" */
+    uint16_t spread_max_mV;
+} BattThresholds;
+
 /* Result with UI-friendly decorations */
 typedef struct {
     BattClass   cls;
     const char *label;       // "Not Recoverable" / "Recoverable" / "Operational" / "Unknown"
-    const char *reason;      // short reason string (e.g., "NR error 0x05", "minV<2.5", "maxV>3.8")
+    BattWhy     why;
+    uint8_t     nr_code;     // offending error code when why == BATT_WHY_NR_CODE
     uint16_t    color565;    // recommended color for HMI (red/amber/green/grey)
 } BattClassResult;
 
 /* Evaluate class. If bms_sim_active==true, returns UNKNOWN by design. */
 BattClassResult batt_classify(const BmsTelemetry *t, bool bms_sim_active);
+
+const char *batt_why_text(BattWhy why);
+
+/* Runtime threshold table; false when the family has no rule */
+bool batt_classify_get_thresholds(uint16_t family, BattThresholds *out);
+/* false as well unless every limit is a multiple of BATT_Q_MV */
+bool batt_classify_set_thresholds(uint16_t family, BattThresholds const *th);
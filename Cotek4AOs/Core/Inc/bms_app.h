@@ -8,6 +8,8 @@
 #include "can_app.h"
 #include "app_signals.h"
 #include "qpc.h"
+#include "bms_cells.h"
+#include "j1939_tp.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,12 +19,26 @@ extern "C" {
     extern QActive *AO_Bms;
     void BmsAO_ctor(void);
 
-    /* helpers (also handy for tests) */
-    int  BMS_ParseFrame(const CanFrameEvt *f, BmsTelemetry *bms);
-    void BMS_GetSnapshot(BmsTelemetry *dst);
-    // ---- BMS sim/telemetry publish helper ------------------------------
-    // Posts one complete BmsTelemetry sample to the Controller AO.
-    void BMS_publish_telemetry(BmsTelemetry const *t);
+    /* snapshot readers */
+    void BMS_GetSnapshot(BmsTelemetry *dst);              /* bay 0 */
+    void BMS_GetSnapshotCh(uint8_t ch, BmsTelemetry *dst);   /* lock-free, ISR-safe */
+    /* bumped on every commit: unchanged value = nothing new to read */
+    uint32_t BMS_GetSnapshotSeqCh(uint8_t ch);
+
+    /* per-node view of a master/slave pack (400s cell pages) */
+    typedef struct {
+        uint8_t  id;          /* CAN node byte, 0x00 = master */
+        uint8_t  fresh;
+        float    hi_V, lo_V;
+        uint32_t age_ms;      /* since the node's last cell page */
+    } BmsNodeInfo;
+    uint8_t BMS_GetNodesCh(uint8_t ch, BmsNodeInfo *dst, uint8_t max);  /* returns count */
+
+    /* individual cells in map order (mV) + stats; returns cells copied */
+    uint8_t BMS_GetCellsCh(uint8_t ch, uint16_t *mv, uint8_t max, BmsCellStats *st);
+
+    /* active J1939 DTCs from the pack's last DM1 (500s); returns count */
+    uint8_t BMS_GetDtcsCh(uint8_t ch, J1939Dtc *dst, uint8_t max);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,43 @@
+//
+// Per-cell voltage map with running statistics.
+//
+// Cells are written one at a time as pages arrive; count / sum / min / max are
+// kept up to date on every write. A min or max owner moving inward only marks
+// the map dirty, and the O(cells) rescan runs when the stats are read.
+//
+// Pure C, no HAL.
+//
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "bms_nodes.h"
+
+#define BMS_CELLS_PER_PAGE  4U
+#define BMS_MAX_CELLS       (BMS_MAX_NODES * BMS_NODE_PAGES * BMS_CELLS_PER_PAGE)
+#define BMS_CELL_NONE       0xFFU
+
+/* 400s layout: node slot, page, position in page -> cell index */
+#define BMS_CELL_INDEX(slot_, page_, k_) \
+    ((uint8_t)(((slot_) * BMS_NODE_PAGES + (page_)) * BMS_CELLS_PER_PAGE + (k_)))
+
+typedef struct {
+    uint16_t mv[BMS_MAX_CELLS];   // 0 = not seen
+    uint8_t  count;               // cells with a reading
+    uint32_t sum_mv;
+    uint8_t  min_idx, max_idx;
+    uint8_t  dirty;
+    uint32_t rescans;
+} BmsCellMap;
+
+typedef struct {
+    uint8_t  count;
+    uint8_t  min_idx, max_idx;
+    uint16_t min_mv, max_mv;
+    uint16_t mean_mv;
+    uint16_t spread_mv;           // max - min (imbalance)
+} BmsCellStats;
+
+void bms_cells_reset(BmsCellMap *m);
+void bms_cells_set(BmsCellMap *m, uint8_t idx, uint16_t mv);   /* mv 0 = forget */
+void bms_cells_clear(BmsCellMap *m, uint8_t first, uint8_t n);
+bool bms_cells_stats(BmsCellMap *m, BmsCellStats *st);          /* false when empty */
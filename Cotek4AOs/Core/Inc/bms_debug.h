@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include "stm32f1xx_hal.h"   // for HAL_GetTick()
+#include "app_channels.h"
 
 /* ---- debug toggle guarded to satisfy -Wundef ---- */
 #if !defined(BMS_DEBUG)
@@ -18,8 +19,9 @@
 /* ---- time helpers / globals ---- */
 static inline uint32_t tick_ms(void) { return HAL_GetTick(); }
 
-/* Defined exactly once in bms_app.c, extern everywhere else */
-extern volatile uint32_t last_bms_ms;
+/* Defined exactly once in bms_app.c, extern everywhere else (one per bay) */
+extern volatile uint32_t last_bms_ms[APP_NUM_CHANNELS];
+bool bms_is_fresh(uint8_t ch);
 
 /* ---- common thresholds (used by controller/UI) ---- */
 #ifndef BMS_WATCH_MS
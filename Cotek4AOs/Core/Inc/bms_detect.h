@@ -0,0 +1,59 @@
+//
+// Battery-family detection: every parsed frame contributes a piece of evidence,
+// each candidate family keeps a score, and the detector locks as soon as the
+// leader clears BMS_DET_LOCK_SCORE with a BMS_DET_LOCK_MARGIN lead. Evidence
+// for one family slowly drains the others, so a swapped pack re-locks on its
+// own instead of needing a comms-lost wipe.
+//
+// Time-to-lock and misclassifications (re-locks, wrong first guesses) are
+// accumulated over all sessions of one detector, i.e. per bay, and printed on
+// each lock. Only the owning AO touches them, so they need no lock under QK.
+//
+// Pure C, no HAL: time comes in as now_ms.
+//
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BMS_DET_LOCK_SCORE   16U
+#define BMS_DET_LOCK_MARGIN   8U
+#define BMS_DET_SCORE_MAX    64U
+
+typedef enum {
+    BMS_EV_HYP500_ID = 0,   /* any 0x18FFxx00                         */
+    BMS_EV_600_SIG,         /* 0x10000010: 02 25 .. .. .. .. .. ..    */
+    BMS_EV_BMZ_SIG,         /* 0x10000010: 01 C0|C1 .. .. .. .. .. .. */
+    BMS_EV_400_ID,          /* 400s fault / pack / temps / SN / cells */
+    BMS_EV_400_SLAVE,       /* 400s cell page from node 0x01          */
+    BMS_EV_400_STEATITE,    /* 400s SN frame ending 00 20             */
+    BMS_EV_SERIES_16,       /* Vpack / Vcell ~ 16s (weak)             */
+    BMS_EV_SERIES_14,       /* Vpack / Vcell ~ 14s (weak)             */
+} BmsEvidence;
+
+enum { BMS_DET_600 = 0, BMS_DET_500HYP, BMS_DET_500BMZ, BMS_DET_400, BMS_DET_NCAND };
+
+typedef struct {
+    uint32_t locks;             /* sessions that reached a lock              */
+    uint32_t relocks;           /* lock replaced without a reset in between  */
+    uint32_t wrong_guess;       /* first provisional type != locked type     */
+    uint32_t ttl_sum_ms, ttl_min_ms, ttl_max_ms;
+} BmsDetectStats;
+
+typedef struct {
+    uint8_t  score[BMS_DET_NCAND];
+    uint8_t  dual, steatite;    /* 400s subtype markers              */
+    uint8_t  lock;              /* locked candidate + 1, 0 = unlocked */
+    uint8_t  first_guess;       /* first candidate shown + 1          */
+    uint32_t t0_ms;             /* first evidence since reset        */
+    uint16_t frames;            /* evidence fed since reset          */
+    BmsDetectStats stats;       /* kept across resets                */
+} BmsDetect;
+
+void bms_detect_init(BmsDetect *d);      /* evidence and stats */
+void bms_detect_reset(BmsDetect *d);     /* evidence only: a new session */
+
+/* Feed one piece of evidence; returns the type code to show (0 = none yet) */
+uint16_t bms_detect_feed(BmsDetect *d, BmsEvidence ev, uint32_t now_ms);
+
+uint16_t bms_detect_current(BmsDetect const *d);
+BmsDetectStats const *bms_detect_stats(BmsDetect const *d);
@@ -14,6 +14,9 @@
  *
  * This module converts raw bitfields/bytes into human-readable strings and a severity.
  * All functions are re-entrant and avoid static buffers; you provide the output buffer.
+ * Bit texts, severities and domains live in const per-family tables, so a decode
+ * only visits the bits that are set. BmsFaultCache keeps rendered results per
+ * (family, raw inputs) for callers that decode the same telemetry repeatedly.
  */
 #ifndef BMS_FAULT_DECODE_H
 #define BMS_FAULT_DECODE_H
@@ -112,6 +115,23 @@ typedef struct {
     /* You provide this buffer to the API call */
 } BmsDecodeResult;
 
+/* Rendered text + severity for one (family, raw inputs) key */
+#define BMS_FAULT_CACHE_SLOTS   4U      /* power of two */
+#define BMS_FAULT_TEXT_MAX     64U      /* UI fields are shorter than this */
+
+typedef struct {
+    uint32_t key;           /* caller-packed raw inputs */
+    uint16_t family;        /* battery_type_code */
+    uint8_t  valid;
+    uint8_t  sev;           /* BmsSeverity */
+    char     text[BMS_FAULT_TEXT_MAX];
+} BmsFaultCacheSlot;
+
+typedef struct {
+    BmsFaultCacheSlot slot[BMS_FAULT_CACHE_SLOTS];
+    uint32_t hits, misses;
+} BmsFaultCache;
+
 /*--------------------------- API ---------------------------*/
 
 /**
@@ -156,6 +176,13 @@ void bms_decode_any(const BmsDecodeInput *in,
                     BmsSeverity *out_sev,
                     BmsDomainMask *out_domains);
 
+/**
+ * Cache lookup (direct-mapped). On a hit *hit is true and text/sev are ready.
+ * On a miss the slot is claimed for (family, key) and cleared; the caller
+ * decodes into slot->text and sets slot->sev.
+ */
+BmsFaultCacheSlot *bms_fault_cache_slot(BmsFaultCache *c, uint16_t family, uint32_t key, bool *hit);
+
 /* Optional helpers for UI */
 const char* bms_severity_to_text(BmsSeverity sev);
 const char* bms_family_to_text(BmsBatteryFamily fam);
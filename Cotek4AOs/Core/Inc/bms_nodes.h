@@ -0,0 +1,59 @@
+//
+// Per-node cell tracking for packs whose master and slave BMS boards share the
+// bus (400s cell pages 0x18000800 / 0x18010800, node = id & 0xFF).
+//
+// Every node keeps its own hi/lo per cell page; the pack extremes are folded in
+// incrementally as frames arrive. Only when the node that owns an extreme moves
+// inward or goes stale is the table rescanned, and that happens lazily at tick
+// rate, so the per-frame cost stays O(1) however many nodes are on the bus.
+//
+// Pure C, no HAL: time comes in as now_ms.
+//
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BMS_MAX_NODES       8U
+#define BMS_NODE_PAGES      2U       /* cell page A / B */
+#define BMS_NODE_NONE       0xFFU
+#define BMS_NODE_STALE_MS   2000U    /* node silent this long drops out of the pack view */
+
+typedef struct {
+    uint8_t  id;                         // CAN node byte
+    uint8_t  fresh;
+    float    page_hi[BMS_NODE_PAGES];    // 0 = page not seen yet
+    float    page_lo[BMS_NODE_PAGES];
+    float    hi_V, lo_V;                 // over this node's pages
+    uint32_t last_ms;
+} BmsNode;
+
+typedef struct {
+    uint8_t  slot_of[256];   // node byte -> slot (BMS_NODE_NONE = unseen)
+    BmsNode  node[BMS_MAX_NODES];
+    uint8_t  count;
+    uint8_t  hi_slot, lo_slot;   // slots owning the pack extremes
+    uint8_t  dirty;              // an owner moved inward / went stale: rescan
+    uint16_t dropped;            // frames from nodes beyond BMS_MAX_NODES
+    uint32_t rescans;
+} BmsNodeTable;
+
+void bms_nodes_reset(BmsNodeTable *t);
+
+/* One cell page (0..BMS_NODE_PAGES-1) from node `id`, hi/lo of the valid cells
+ * in the frame. Returns false if the table is full and the frame was dropped. */
+bool bms_nodes_update(BmsNodeTable *t, uint8_t id, uint8_t page,
+                      float hi_V, float lo_V, uint32_t now_ms);
+
+/* Slot of a node byte, BMS_NODE_NONE if not tracked */
+static inline uint8_t bms_nodes_slot(BmsNodeTable const *t, uint8_t id) { return t->slot_of[id]; }
+
+/* Age nodes out (call at tick rate); returns a bitmask of slots that just went stale */
+uint32_t bms_nodes_age(BmsNodeTable *t, uint32_t now_ms);
+
+/* Pack extremes over fresh nodes without rescanning; false while dirty or empty */
+bool bms_nodes_peek(BmsNodeTable const *t, float *hi_V, float *lo_V);
+
+/* Same, rescanning first if needed; false when no node is fresh */
+bool bms_nodes_pack(BmsNodeTable *t, float *hi_V, float *lo_V);
+
+uint8_t bms_nodes_fresh_count(BmsNodeTable const *t);
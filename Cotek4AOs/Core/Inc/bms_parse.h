@@ -0,0 +1,44 @@
+//
+// CAN frame parsers of the pack families (400s / 500s Hyperdrive + BMZ / 600s).
+//
+// Every recognised frame updates the telemetry snapshot and hands its piece of
+// family evidence to the detector (bms_detect.h); when the detector changes its
+// answer, the snapshot is wiped for the new family. 400s cell pages go through
+// the per-node table and the cell map.
+//
+// Pure C, no HAL: time comes in as now_ms.
+//
+#pragma once
+#include <stdint.h>
+#include "app_signals.h"    /* BmsTelemetry */
+#include "bms_detect.h"
+#include "bms_nodes.h"
+#include "bms_cells.h"
+
+/* battery_type_code values */
+#define TYPE_600S               0x0600u
+#define TYPE_500S_HYP           0x0500u
+#define TYPE_500S_BMZ           0x0501u
+#define TYPE_400S_HYP           0x0400u
+#define TYPE_400S_DUAL          0x0401u
+#define TYPE_400S_STEATITE      0x0402u
+
+static inline const char *bms_type_str(uint16_t code) {
+    switch (code) {
+        case TYPE_600S:          return "600s";
+        case TYPE_500S_HYP:      return "500s Hyperdrive";
+        case TYPE_500S_BMZ:      return "500s BMZ";
+        case TYPE_400S_HYP:      return "400s Hyperdrive";
+        case TYPE_400S_DUAL:     return "400s Dual-Zone";
+        case TYPE_400S_STEATITE: return "400s Steatite";
+        default:                 return "Unknown";
+    }
+}
+
+/* 1 when the frame belongs to a known family (29-bit id) */
+int bms_parse_frame(BmsDetect *det, BmsNodeTable *nt, BmsCellMap *cm,
+                    uint32_t id, uint8_t dlc, const uint8_t *d, BmsTelemetry *b, uint32_t now_ms);
+
+/* Vpack / Vcell series count as weak evidence until the detector locks;
+ * 1 when the shown type changed */
+uint8_t bms_detect_by_voltage(BmsDetect *det, BmsTelemetry *b, uint32_t now_ms);
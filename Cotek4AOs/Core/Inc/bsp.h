@@ -8,6 +8,19 @@
 #include "main.h"
 #define BSP_TICKS_PER_SEC 100
 
+/* QF tick rates, all driven from the 1 kHz SysTick (bsp.c). Each rate has its
+ * own time-event list, so a tick only walks the timers that share its period. */
+#define BSP_RATE_BASE           0U      /* BSP_TICKS_PER_SEC: AO polls (BMS, Cotek) */
+#define BSP_RATE_FAST           1U      /* safety watchdogs, 1 ms resolution */
+#define BSP_RATE_SLOW           2U      /* UI refresh and housekeeping */
+#define BSP_NUM_RATES           3U
+#define BSP_FAST_TICKS_PER_SEC  1000U
+#define BSP_SLOW_TICKS_PER_SEC  10U
+
+#if (QF_MAX_TICK_RATE < BSP_NUM_RATES)
+#error "QF_MAX_TICK_RATE must cover BSP_NUM_RATES (set in CMakeLists.txt)"
+#endif
+
 bool POSTX_TRACE_TAG();
 
 void BSP_init(void);
@@ -22,6 +35,65 @@ void BSP_dumpIRQs(void);
 void BSP_ledOn(void);
 void BSP_ledOff(void);
 void BSP_delay(uint32_t ms);
+bool BSP_i2c1Recover(void);           // unstick SDA (9 clocks + STOP), re-init I2C1
+
+/* Kernel-aware ISR bracket: QK must be told when an ISR made a higher AO
+ * ready; QV needs nothing. Every ISR that may post goes through these. */
+#ifdef APP_USE_QK
+#define BSP_ISR_ENTRY()   QK_ISR_ENTRY()
+#define BSP_ISR_EXIT()    QK_ISR_EXIT()
+#else
+#define BSP_ISR_ENTRY()   ((void)0)
+#define BSP_ISR_EXIT()    ((void)0)
+#endif
+
+/* Digital inputs sampled by AO_Input (bit i of BSP_inputLevels(), 1 = active) */
+#define BSP_IN_B1       0U      /* PC13 user button, high when pressed */
+#define BSP_IN_ESTOP    1U      /* ENABLE_ESTOP: NC loop on ESTOP_Pin, high = open */
+#define BSP_NUM_INPUTS  2U
+uint32_t BSP_inputLevels(void);
+uint32_t BSP_inputForPin(uint16_t pin);         /* EXTI pin -> input mask */
+void     BSP_inputIrq(uint32_t mask, bool on);  /* (un)mask the inputs' EXTI lines */
+
+/* DWT cycle counter (started in QF_onStartup), for latency measurements */
+static inline uint32_t BSP_cycles(void) { return DWT->CYCCNT; }
+#define BSP_CYCLES_PER_US  (SystemCoreClock / 1000000U)
+
+/* Idle sleep (QV_onIdle / QK_onIdle). With BSP_TICKLESS the 1 ms SysTick is
+ * stretched up to the nearest armed QTimeEvt; CAN, UART and EXTI (buttons,
+ * e-stop) interrupts still wake the core and the tick count is repaired
+ * first. Nothing is polled any more, so the only limit is the 24-bit SysTick
+ * (262 ms at 64 MHz) and in practice the 100 ms BMS tick; BSP_TICKLESS_MAX_MS
+ * is left as a build-time override for debugging. */
+#ifndef BSP_TICKLESS_MAX_MS
+#define BSP_TICKLESS_MAX_MS  UINT32_MAX   /* no cap below the SysTick limit */
+#endif
+
+typedef struct {
+    uint32_t wakeups_per_s;
+    uint8_t  idle_pct;          /* share of time spent in WFI */
+    uint32_t max_sleep_ms;      /* longest SysTick stretch, 0 without BSP_TICKLESS */
+} BspIdleStats;
+
+/* Stats since the previous call (keep calls < 59 s apart: CYCCNT wraps) */
+void BSP_idleStats(BspIdleStats *out);
+
+#define BSP_NUM_POOLS  4U       /* QF_poolInit() calls in main(): CAN, BMS, TP, UI */
+
+/* QS software tracing (Q_SPY builds, USE_QSPY in CMake): binary records on
+ * USART2 by DMA, printf is dropped. Application records for QSPY: */
+#ifdef Q_SPY
+enum BspQsRecords {
+    BSP_QS_CAN_RX = QS_USER,    /* bay, id, dlc, data: every accepted frame */
+    BSP_QS_PSU_READ,            /* bay, ok mask, raw V / I / T, ctrl: each poll */
+};
+#define BSP_QS_ID_CAN  (QS_AP_ID + 0U)  /* local-filter ID of the CAN ISR */
+/* QSPY "command" ids, handled by QS_onCommand() */
+enum BspQsCommands {
+    BSP_QS_CMD_THRESHOLDS = 0,  /* family, min_mV | max_mV << 16, spread_max_mV */
+};
+void BSP_qsUart2Isr(void);
+#endif
 
 /* Active objects... */
 extern QActive *AO_Cotek;
@@ -28,6 +28,11 @@ extern "C" {
     void CANAPP_EnableRx(bool enable);
     /* NEW: drain all pending frames from FIFO0 (used before enabling) */
     void CANAPP_FlushRx(void);
+    /* Queue one extended-id frame; false when all TX mailboxes are busy */
+    bool CANAPP_Send(uint32_t id, const uint8_t *data, uint8_t dlc);
+    /* Ids whose reply somebody is waiting for: posted LIFO so they jump the
+     * BMS queue (see AO_Bms identity requests) */
+    bool CANAPP_IsPriorityId(uint32_t id);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,66 @@
+//
+// Table-driven CC/CV charge engine, keyed by BmsTelemetry.battery_type_code.
+//
+// Stages: PRECHARGE (deeply discharged / Recoverable packs) -> CC -> CV with
+// taper-current termination -> DONE. The Controller feeds it every BMS and
+// PSU update; it never blocks and only reports when the setpoint moved.
+//
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    CHG_STAGE_IDLE = 0,
+    CHG_STAGE_PRECHARGE,
+    CHG_STAGE_CC,
+    CHG_STAGE_CV,
+    CHG_STAGE_DONE,
+    CHG_STAGE_FAULT,
+} ChargeStage;
+
+/* One row per battery family */
+typedef struct {
+    uint16_t type_code;       // 0x0400..
+    float    pack_max_V;      // PSU voltage ceiling (hardware limit)
+    float    cell_pre_exit_V; // min cell above this -> leave PRECHARGE
+    float    cell_cv_V;       // max cell target: CC -> CV here
+    float    cell_abort_V;    // any cell above this -> FAULT
+    float    i_pre_A;
+    float    i_cc_A;
+    float    i_taper_A;       // CV ends when current stays below this
+    uint16_t taper_hold_s;
+    uint16_t pre_max_s;       // PRECHARGE must finish within this
+    uint16_t max_total_min;   // safety cap for the whole charge
+    uint16_t capacity_Ah;     // nominal, for coulomb SoC / time-to-full
+} ChargeProfile;
+
+/* Live inputs; NAN / 0 where not known yet */
+typedef struct {
+    float high_cell_V, low_cell_V;
+    float pack_V;             // BMS array voltage
+    float bms_I_A;            // BMS current (+ = charging), 0 if not reported
+    float psu_V, psu_I;       // Cotek readback
+    bool  psu_on;
+} ChargeInputs;
+
+typedef struct {
+    ChargeProfile const *p;
+    ChargeStage stage;
+    float    vset, iset;      // last setpoint handed to the PSU
+    float    trim_V;          // CV trim from cell feedback
+    uint8_t  cells;           // series count estimate
+    uint32_t t0_ms, stage_ms, below_ms;
+    char const *why;          // FAULT / DONE reason
+} ChargeEngine;
+
+/* NULL for a family without a profile row */
+ChargeProfile const *charge_profile_for(uint16_t type_code);
+
+/* recoverable: start in PRECHARGE regardless of the cell voltages.
+ * A family without a profile starts (and stays) in FAULT. */
+void charge_start(ChargeEngine *ce, uint16_t type_code, bool recoverable, uint32_t now_ms);
+
+/* Returns true when (vset, iset) changed enough to re-program the PSU */
+bool charge_step(ChargeEngine *ce, ChargeInputs const *in, uint32_t now_ms);
+
+char const *charge_stage_str(ChargeStage s);
@@ -0,0 +1,83 @@
+//
+// Cotek PSU emulator -- register map 0x60..0x7C behind the AO_Cotek I2C shim.
+//
+// Lets cotek_set_output_voltage(), cotek_commit_settings(), cotek_power_on()
+// and the presence monitor run without a real supply. Transactions can be
+// slowed down, NACKed or timed out on purpose, and the output follows a simple
+// battery + thermal model so readbacks move like the real thing.
+//
+// Pure C, no HAL: time and delays come in through the config callbacks.
+//
+#ifndef COTEK_EMU_H
+#define COTEK_EMU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COTEK_EMU_REG_FIRST  0x60U
+#define COTEK_EMU_REG_LAST   0x7CU
+
+typedef enum {
+    COTEK_EMU_OK = 0,
+    COTEK_EMU_NACK,        /* address or data NACK (fails immediately)     */
+    COTEK_EMU_TIMEOUT,     /* transaction stalled for the caller's timeout */
+    COTEK_EMU_BUSY,        /* bus wedged (SDA low) until CotekEmu_recover() */
+} CotekEmuStatus;
+
+typedef struct {
+    uint32_t (*now_ms)(void);
+    void     (*delay_ms)(uint32_t ms);   /* NULL = do not burn time */
+
+    uint32_t latency_ms;       /* added to every transaction               */
+    uint8_t  nack_pct;         /* 0..100 chance a transaction NACKs        */
+    uint8_t  timeout_pct;      /* 0..100 chance a transaction times out    */
+    bool     wedge_on_timeout; /* a timeout leaves SDA held low            */
+    bool     present;          /* false = unplugged, every address NACKs   */
+
+    /* output model */
+    float    batt_ocv_V;       /* battery open-circuit voltage             */
+    float    batt_r_ohm;       /* pack internal resistance                 */
+    float    v_slew_Vps;       /* output voltage slew (V/s)                */
+    float    i_slew_Aps;       /* output current slew (A/s)                */
+    float    ambient_C;
+    float    heat_CpWs;        /* temperature rise per joule dissipated    */
+    float    cool_per_s;       /* Newton cooling coefficient               */
+    float    efficiency;       /* 0..1, losses heat the supply             */
+} CotekEmuCfg;
+
+typedef struct {
+    uint32_t xfers;            /* transactions attempted */
+    uint32_t bytes;
+    uint32_t nacks;
+    uint32_t timeouts;
+    uint32_t commits;          /* 0x7C bit2 updates       */
+    uint32_t on_cmds, off_cmds;
+    uint32_t busy_ms;          /* time callers spent blocked in the shim */
+    uint32_t probes;           /* address-only transactions */
+    uint32_t recoveries;
+} CotekEmuStats;
+
+void CotekEmu_defaults(CotekEmuCfg *cfg);
+void CotekEmu_init(CotekEmuCfg const *cfg);
+CotekEmuCfg *CotekEmu_cfg(void);     /* live tweaks (fault injection, unplug) */
+
+/* Shim entry points: same shape as the HAL master calls they replace */
+CotekEmuStatus CotekEmu_write(uint8_t const *buf, uint16_t len, uint32_t timeout_ms);
+CotekEmuStatus CotekEmu_memRead(uint8_t reg, uint8_t *buf, uint16_t len, uint32_t timeout_ms);
+CotekEmuStatus CotekEmu_probe(void);          /* address + ACK only, never burns latency */
+void           CotekEmu_recover(void);        /* clock-out + STOP: releases a wedged bus */
+
+/* Advance the output model (also done implicitly on every transaction) */
+void CotekEmu_step(void);
+
+CotekEmuStats const *CotekEmu_stats(void);
+void CotekEmu_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* COTEK_EMU_H */
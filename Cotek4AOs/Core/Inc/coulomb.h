@@ -0,0 +1,41 @@
+//
+// Coulomb counter + energy integrator for a charge session.
+//
+// Every current / voltage sample closes the interval since the previous one
+// (the previous reading is held over it), all in integer mA / mV / ms. The
+// pack charge estimate starts from the BMS SoC and is pulled towards it only
+// when the reported BMS SoC changes: a 1 % step marks the boundary between
+// the two values, which is the one moment the integer SoC says more than
+// "somewhere in this percent". 1/COULOMB_CORR_DIV of the error is removed per
+// step, so counting errors cannot build up while the count still resolves
+// the charge between steps (a 2 Hz report would otherwise pin it to the BMS).
+//
+// Pure C, no HAL: time comes in as now_ms.
+//
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define COULOMB_MAX_GAP_MS   2000U   /* longer silences integrate this much only */
+#define COULOMB_CORR_DIV        4    /* drift correction gain = 1/4 per BMS SoC step */
+
+typedef struct {
+    uint32_t cap_mAh;           /* pack capacity, 0 = unknown (no SoC / TTF) */
+    int64_t  pack_mAms;         /* estimated charge in the pack */
+    int64_t  sess_mAms;         /* delivered this session (signed) */
+    int64_t  sess_mWms;
+    int32_t  i_mA, v_mV;        /* held since last_ms */
+    uint32_t last_ms, t0_ms;
+    uint8_t  have;              /* a sample has been seen */
+    uint8_t  bms_pct;           /* last BMS SoC, steps trigger the correction */
+} Coulomb;
+
+void coulomb_start(Coulomb *c, uint32_t cap_mAh, uint8_t bms_soc_pct, uint32_t now_ms);
+void coulomb_sample(Coulomb *c, int32_t i_mA, int32_t v_mV, uint32_t now_ms);
+void coulomb_correct(Coulomb *c, uint8_t bms_soc_pct);
+
+uint8_t  coulomb_soc_pct(Coulomb const *c);
+int32_t  coulomb_session_mAh(Coulomb const *c);
+int32_t  coulomb_session_mWh(Coulomb const *c);
+/* minutes to 100 % at the held current; 0xFFFF when not charging / unknown */
+uint16_t coulomb_ttf_min(Coulomb const *c);
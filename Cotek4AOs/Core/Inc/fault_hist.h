@@ -0,0 +1,55 @@
+//
+// Fault history: every distinct fault a pack has raised, keyed by
+// (battery family, domain, code), with an occurrence count and the first /
+// last time it was seen. Survives comms-lost so intermittent faults are still
+// there when the technician looks.
+//
+// Each telemetry sample is bracketed by fault_hist_begin() / fault_hist_end();
+// a fault noted in a sample after being absent in the previous one counts as a
+// new occurrence. Lookup is a small chained hash, so a note is O(1); when the
+// table is full the least recently seen inactive entry is recycled.
+//
+// Pure C, no HAL: time comes in as now_ms.
+//
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FAULT_HIST_SIZE      16U
+#define FAULT_HIST_BUCKETS   32U      /* power of two */
+#define FAULT_HIST_NONE      0xFFU
+
+typedef enum {
+    FH_DOM_RAW = 0,     /* bit of the family's raw fault byte (code = bit, 0xFF = flag only) */
+    FH_DOM_ERROR,       /* error message: code = class << 8 | code */
+    FH_DOM_DTC,         /* J1939 DM1: code = SPN << 5 | FMI */
+} FaultHistDomain;
+
+typedef struct {
+    uint16_t family;    /* battery_type_code */
+    uint8_t  domain;
+    uint8_t  active;    /* present in the latest sample */
+    uint32_t code;
+    uint16_t count;     /* occurrences (inactive -> active edges) */
+    uint8_t  next;      /* bucket chain */
+    uint8_t  seen;      /* sample generation it was last noted in */
+    uint32_t first_ms, last_ms;
+} FaultHistEntry;
+
+typedef struct {
+    FaultHistEntry e[FAULT_HIST_SIZE];
+    uint8_t  head[FAULT_HIST_BUCKETS];
+    uint8_t  used;
+    uint8_t  gen;
+    uint16_t evicted;
+} FaultHist;
+
+void fault_hist_reset(FaultHist *h);
+
+void fault_hist_begin(FaultHist *h);
+/* true when this is a new occurrence (fault was not active in the last sample) */
+bool fault_hist_note(FaultHist *h, uint16_t family, uint8_t domain, uint32_t code, uint32_t now_ms);
+void fault_hist_end(FaultHist *h);
+
+/* entry indices, most recently seen first; returns how many were written */
+uint8_t fault_hist_recent(FaultHist const *h, uint8_t *idx, uint8_t max);
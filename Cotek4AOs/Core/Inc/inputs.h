@@ -0,0 +1,59 @@
+//
+// Debounce + gesture recognition for a handful of digital inputs.
+//
+// The caller feeds one sample of every input at a time (bit i = input i
+// active) and gets back what happened: debounced DOWN / UP for every input,
+// plus CLICK / DOUBLE / LONG for inputs that have gestures enabled. A single
+// click is only reported once INPUT_DOUBLE_MS has passed without a second
+// press, so a double press never also counts as two clicks.
+//
+// Sampling is only needed while inputs_busy(); in between, an edge interrupt
+// is enough to know when to start again.
+//
+// Pure C, no HAL: time comes in as now_ms.
+//
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+#define INPUTS_MAX          8U
+#define INPUT_DEBOUNCE_MS   20U     /* level must hold this long */
+#define INPUT_LONG_MS     1000U     /* held this long -> LONG (once, while held) */
+#define INPUT_DOUBLE_MS    350U     /* release -> next press window for DOUBLE */
+
+typedef enum {
+    INPUT_EV_DOWN = 1,
+    INPUT_EV_UP,
+    INPUT_EV_CLICK,
+    INPUT_EV_DOUBLE,
+    INPUT_EV_LONG,
+} InputEvKind;
+
+typedef struct {
+    uint8_t input;
+    uint8_t kind;               /* InputEvKind */
+} InputEv;
+
+typedef struct {
+    uint32_t edge_ms;           /* raw level last changed */
+    uint32_t down_ms;           /* debounced press start */
+    uint32_t up_ms;             /* release of a click waiting for its pair */
+    uint8_t  raw, stable;       /* 1 = active */
+    uint8_t  clicks;            /* 0/1: a click is waiting for INPUT_DOUBLE_MS */
+    uint8_t  long_sent;
+} InputState;
+
+typedef struct {
+    InputState in[INPUTS_MAX];
+    uint32_t   gestures;        /* bit i: input i gets CLICK / DOUBLE / LONG */
+    uint8_t    n;
+} Inputs;
+
+/* levels = current state, taken as already debounced (no events at boot) */
+void    inputs_init(Inputs *s, uint8_t n, uint32_t gestures, uint32_t levels, uint32_t now_ms);
+/* returns the number of events written to out (at most max) */
+uint8_t inputs_sample(Inputs *s, uint32_t levels, uint32_t now_ms, InputEv *out, uint8_t max);
+/* true while a level is settling or a gesture still depends on time */
+bool    inputs_busy(Inputs const *s);
+/* debounced levels, bit i = input i */
+uint32_t inputs_levels(Inputs const *s);
@@ -0,0 +1,61 @@
+//
+// J1939 transport protocol (TP.CM / TP.DT) reassembly for the 500s Hyperdrive
+// diagnostics: DM1 fault lists and identity strings longer than one frame.
+//
+// Runs in the CAN RX ISR. Each session reassembles straight into a pooled
+// J1939MsgEvt, so a completed message is posted to AO_Bms without another
+// copy. At most J1939_TP_MAX_SESSIONS senders are reassembled at once; a
+// session that misses its next packet for J1939_TP_T1_MS is dropped (checked
+// whenever TP traffic arrives) and its event goes back to the pool.
+//
+// Only BAM (broadcast) is handled: RTS/CTS needs us to answer with CTS, and
+// the packs broadcast their diagnostics anyway. A single-frame DM1 is wrapped
+// into the same event so the AO sees one shape either way.
+//
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "qpc.h"
+
+#define J1939_TP_MAX_SESSIONS   2U
+#define J1939_TP_MAX_LEN      105U      /* 15 packets: DM1 with 25 DTCs */
+#define J1939_TP_T1_MS        750U      /* J1939-21 T1, BAM inter-packet */
+
+#define J1939_PGN_DM1         0x00FECAu /* active diagnostic trouble codes */
+#define J1939_PGN_SOFT_ID     0x00FEDAu /* software identification, '*' separated */
+#define J1939_PGN_COMP_ID     0x00FEEBu /* component identification */
+
+typedef struct {
+    QEvt     super;             /* J1939_MSG_SIG */
+    uint32_t pgn;
+    uint16_t len;
+    uint8_t  sa;                /* sender source address */
+    uint8_t  data[J1939_TP_MAX_LEN];
+} J1939MsgEvt;
+
+typedef struct {
+    uint32_t spn;               /* suspect parameter number (19 bits) */
+    uint8_t  fmi;               /* failure mode identifier */
+    uint8_t  oc;                /* occurrence count */
+} J1939Dtc;
+
+typedef struct {
+    uint32_t done;              /* messages handed out            */
+    uint32_t timeouts;          /* T1 expired mid-message         */
+    uint32_t bad_seq;           /* out-of-order / restarted BAM   */
+    uint32_t too_long;          /* announced size > MAX_LEN       */
+    uint32_t no_mem;            /* pool empty at BAM              */
+    uint32_t busy;              /* all sessions in use            */
+} J1939TpStats;
+
+/* Frames this module consumes (TP.CM, TP.DT, single-frame DM1) */
+bool j1939_tp_claims(uint32_t id);
+
+/* CAN ISR: feed one claimed extended frame (raw id, source address intact).
+ * Returns a completed message for the caller to post, or NULL. */
+J1939MsgEvt *j1939_tp_rx(uint32_t id, uint8_t const *d, uint8_t dlc, uint32_t now_ms);
+
+/* DM1 payload -> DTC list (lamp bytes skipped, empty slots dropped) */
+uint8_t j1939_dm1_decode(uint8_t const *d, uint16_t len, J1939Dtc *out, uint8_t max);
+
+J1939TpStats const *j1939_tp_stats(void);
@@ -41,6 +41,11 @@ extern CAN_HandleTypeDef  hcan;
 #define USER_BTN_GPIO_Port GPIOC
 #define USER_BTN_Pin       GPIO_PIN_13
 
+/* E-stop loop (ENABLE_ESTOP): NC contact to GND, pull-up, so a pressed
+ * mushroom or a cut wire both read high */
+#define ESTOP_GPIO_Port    GPIOB
+#define ESTOP_Pin          GPIO_PIN_12
+
 
 /* Exported functions prototypes ---------------------------------------------*/
 void Error_Handler(void);
@@ -0,0 +1,72 @@
+//
+// Nextion HMI emulator -- consumes the exact byte stream produced by nex_send3()
+// and keeps a model of pages/components so the UI path can be measured off-target.
+//
+// Pure C, no HAL: the firmware feeds it from ao_nextion.c when ENABLE_NEX_EMU is
+// defined, and the same file links into a host harness unchanged.
+//
+#ifndef NEX_EMU_H
+#define NEX_EMU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef NEX_EMU_MAX_COMPS
+#define NEX_EMU_MAX_COMPS   96U     /* distinct page.component objects tracked */
+#endif
+#ifndef NEX_EMU_TXT_MAX
+#define NEX_EMU_TXT_MAX     48U     /* longest .txt value kept in the model */
+#endif
+#ifndef NEX_EMU_SENDME
+#define NEX_EMU_SENDME      1       /* panel-side page changes report 0x66 */
+#endif
+
+/* RX hook the emulator uses to talk back (normally Nextion_OnRx) */
+typedef void (*NexEmuRxFn)(uint8_t const *buf, uint16_t len);
+
+typedef struct {
+    uint32_t bytes;          /* total bytes consumed                          */
+    uint32_t cmds;           /* complete commands (0xFF 0xFF 0xFF terminated) */
+    uint32_t writes;         /* attribute assignments                         */
+    uint32_t redundant;      /* assignments that did not change the screen    */
+    uint32_t offpage;        /* writes to a page that is not shown            */
+    uint32_t refs;           /* "ref" commands                                */
+    uint32_t unknown;        /* commands the model did not understand         */
+    uint32_t page_changes;
+    uint32_t settle_last_ms; /* page change -> all required objects written   */
+    uint32_t settle_max_ms;
+    uint32_t unsettled;      /* page changes left before the screen settled   */
+} NexEmuStats;
+
+void NexEmu_init(NexEmuRxFn rx);
+void NexEmu_reset(void);
+
+/* Consume raw UART bytes exactly as they leave nex_send_raw() */
+void NexEmu_feed(uint8_t const *buf, uint16_t len, uint32_t now_ms);
+
+/* Generate a touch event (0x65 page comp press) back through the RX hook */
+void NexEmu_touch(uint8_t page, uint8_t comp, bool press);
+
+/* Page change made on the panel itself (touch navigation, not "page X"):
+ * reports it back as a 0x66 page event when NEX_EMU_SENDME is set */
+void NexEmu_gotoPage(uint8_t page);
+
+/* Model queries */
+uint8_t     NexEmu_page(void);
+bool        NexEmu_isConsistent(void);
+char const *NexEmu_getTxt(char const *obj);          /* "pMain.tVolt" */
+int32_t     NexEmu_getVal(char const *obj, char const *attr);
+
+NexEmuStats const *NexEmu_stats(void);
+
+/* Print rates since the previous report (bytes/s, cmds/s) plus totals */
+void NexEmu_report(uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* NEX_EMU_H */
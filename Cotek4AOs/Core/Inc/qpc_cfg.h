@@ -5,8 +5,9 @@
 #define QPC_CFG_H_
 
 #ifndef QF_MAX_TICK_RATE
-    // You’re only using one tick rate in this project
-    #define QF_MAX_TICK_RATE 1U
+    // base / fast / slow, see BSP_RATE_* in bsp.h. CMake passes the same value
+    // so the QP sources size QTimeEvt_timeEvtHead_[] identically.
+    #define QF_MAX_TICK_RATE 3U
 #endif
 
 // Make the QP port unambiguously use "aware == 5" on STM32F1 (4 prio bits)
@@ -13,15 +13,16 @@
 #include "batt_classify.h"
 #include "bms_fault_decode.h"
 #include "bms_debug.h"
+#include "charge_profile.h"
+#include "app_channels.h"
+#include "fault_hist.h"
+#include "coulomb.h"
+#include "ao_input.h"
 
-static uint32_t s_last_sum_ms;
-static uint32_t s_last_det_ms;
-static uint32_t s_last_sum_hash, s_last_det_hash;
 /* Monotonic tick accessor (HAL_GetTick or BSP tick) */
 uint32_t tick_ms(void);
 /* Local mirrors to detect transitions and de-spam logs */
-static uint8_t  s_prev_fresh = 255U;    /* 255 = unknown first run */
-static uint32_t s_prev_age_bucket = 999999U;
+static uint8_t  s_prev_fresh[APP_NUM_CHANNELS];    /* 255 = unknown first run */
 // Use the mapper from bms_app.c
 extern const char *BMS_state_to_text(uint16_t batt_type, uint8_t raw_state);
 
@@ -37,8 +38,10 @@ typedef enum
 
 typedef struct {
     QActive  super;
+    uint8_t  ch;        /* bay index */
+    QActive *psu;       /* this bay's Cotek */
     QTimeEvt ui2s;      /* periodic UI refresh (2s) */
-    QTimeEvt tCharge;   /* charging timeout (60s) */
+    QTimeEvt tCharge;   /* charge safety cap (profile max_total_min) */
     QTimeEvt tPsuOff;    // short watchdog while waiting for OFF confirm
     QTimeEvt tLostHold;  // 10 s “stay on pMain” after comms lost
     uint8_t page;
@@ -50,10 +53,19 @@ typedef struct {
     ctl_state_t state;
     uint8_t psu_present, psu_out_on;
     float   psu_v_out, psu_i_out, psu_temp;
+    ChargeEngine chg;
+    FaultHist faults;   /* every fault this bay has seen, kept over comms-lost */
+    Coulomb   cc;       /* charge / energy of the current (or last) session */
+    BmsFaultCache ftext;  /* rendered fault text, summary/details/history share it */
+    /* HMI de-spam, per bay so preempting Controllers (QK) never share it */
+    uint32_t  ui_sum_ms, ui_det_ms;
+    uint32_t  ui_sum_hash, ui_det_hash;
+    uint32_t  age_bucket;   /* last logged BMS age, 100 ms units */
+    uint8_t   cc_on;    /* session running */
 } ControllerAO;
 
 static void post_page_ex(ControllerAO *me, uint8_t page);
-static void make_summary(NextionSummaryEvt *se, const BmsTelemetry *t);
+static void make_summary(NextionSummaryEvt *se, const BmsTelemetry *t, BmsFaultCache *fc);
 extern volatile uint16_t g_lastSig;
 extern volatile uint8_t  g_lastTag;
 //static uint32_t s_last_ui_ms;
@@ -69,9 +81,9 @@ static BmsBatteryFamily fam_from_code(uint16_t code) {
     }
 }
 
-static void decode_faults_for_ui(const BmsTelemetry *t,
-                                 char *out_text, size_t out_len,
-                                 BmsSeverity *out_sev) {
+static void decode_faults(const BmsTelemetry *t,
+                          char *out_text, size_t out_len,
+                          BmsSeverity *out_sev) {
     if (!t || !out_text || out_len == 0) return;
     out_text[0] = '\0';
     if (out_sev) *out_sev = BMS_SEV_NONE;
@@ -115,7 +127,7 @@ static void decode_faults_for_ui(const BmsTelemetry *t,
             in.uv = in.ov = in.ot = in.ut = false;
             in.dchg_oc = in.chg_oc = false;
             in.therm_warning = false;
-            in.imbalance = false;
+            in.imbalance = (t->cell_count >= 2U && t->cell_spread_V > BATT_SPREAD_MAX_V);
 
             bms_decode_cp400(&in, out_text, out_len, &sev, &dom);
         } break;
@@ -158,14 +170,42 @@ static void decode_faults_for_ui(const BmsTelemetry *t,
     }
 }
 
+/* Fault text for the UI, rendered once per distinct (family, raw inputs) */
+static char const *decode_faults_for_ui(BmsFaultCache *fc, const BmsTelemetry *t,
+                                        BmsSeverity *out_sev) {
+    const uint16_t fam = t->battery_type_code;
+    const bool     imb = ((fam & 0xFF00U) == 0x0400U)
+                      && t->cell_count >= 2U && t->cell_spread_V > BATT_SPREAD_MAX_V;
+    const uint32_t key = (uint32_t)t->bms_fault_raw
+                       | ((uint32_t)t->last_error_class << 8)
+                       | ((uint32_t)t->last_error_code  << 16)
+                       | ((t->bms_fault != 0U) ? (1UL << 24) : 0U)
+                       | (imb ? (1UL << 25) : 0U);
+    bool hit;
+    BmsFaultCacheSlot *s = bms_fault_cache_slot(fc, fam, key, &hit);
+    if (!hit) {
+        BmsSeverity sev;
+        decode_faults(t, s->text, sizeof(s->text), &sev);
+        s->sev = (uint8_t)sev;
+    }
+    if (out_sev) *out_sev = (BmsSeverity)s->sev;
+    return s->text;
+}
+
 static QState Ctl_initial (ControllerAO *me, void const *e);
 static QState Ctl_run     (ControllerAO *me, QEvt const *e);
 static QState Ctl_wait    (ControllerAO *me, QEvt const *e);
 static QState Ctl_detect  (ControllerAO *me, QEvt const *e);
 static QState Ctl_charge  (ControllerAO *me, QEvt const *e);
 static QState Ctl_poweringDown(ControllerAO * me, QEvt const * e);
-static ControllerAO l_ctl;
-QActive *AO_Controller = &l_ctl.super;
+static ControllerAO l_ctl[APP_NUM_CHANNELS];
+QActive *AO_ControllerCh[APP_NUM_CHANNELS];
+QActive *AO_Controller = &l_ctl[0].super;
+
+/* Only the bay shown on the panel may paint it */
+static inline bool hmi_owner(ControllerAO const *me) {
+    return App_hmiChannel() == me->ch;
+}
 
 // quantizers (avoid UI spam from tiny jitter)
 static inline int qV005(float v) {     // 0.05 V steps
@@ -212,17 +252,17 @@ static uint32_t hash_details(const BmsTelemetry *t) {
     return h;
 }
 
-static inline bool ui_ok_now_sum(void) {
+static inline bool ui_ok_now_sum(ControllerAO *me) {
     uint32_t now = HAL_GetTick();
-    if ((now - s_last_sum_ms) < 120U) return false;  // ~8 Hz max
-    s_last_sum_ms = now; return true;
+    if ((now - me->ui_sum_ms) < 120U) return false;  // ~8 Hz max
+    me->ui_sum_ms = now; return true;
 }
-static inline bool ui_ok_now_det(void) {
+static inline bool ui_ok_now_det(ControllerAO *me) {
     uint32_t now = HAL_GetTick();
-    if ((now - s_last_det_ms) < 250U) return false;  // ~4 Hz max
-    s_last_det_ms = now; return true;
+    if ((now - me->ui_det_ms) < 250U) return false;  // ~4 Hz max
+    me->ui_det_ms = now; return true;
 }
-static void make_summary(NextionSummaryEvt *se, const BmsTelemetry *t) {
+static void make_summary(NextionSummaryEvt *se, const BmsTelemetry *t, BmsFaultCache *fc) {
     // pack voltage
     se->packV = t->array_voltage_V;
 
@@ -295,9 +335,8 @@ static void make_summary(NextionSummaryEvt *se, const BmsTelemetry *t) {
 #endif
 
     // errors/warnings (you only have bms_fault bitfield right now)
-    char faults[128];
     BmsSeverity sev;
-    decode_faults_for_ui(t, faults, sizeof(faults), &sev);
+    char const *faults = decode_faults_for_ui(fc, t, &sev);
 
     // Put the text into the one-line errors field for pMain.
     // Keep it short if you want: you can clip or pick the first item.
@@ -315,14 +354,14 @@ static void make_summary(NextionSummaryEvt *se, const BmsTelemetry *t) {
     se->reason[0] = '\0';
 }
 
-static void make_details(NextionDetailsEvt *de, const BmsTelemetry *t) {
+static void make_details(NextionDetailsEvt *de, const BmsTelemetry *t, BmsFaultCache *fc) {
     // Voltages
     if (t->high_cell_V >= 2.0f && t->high_cell_V <= 4.6f)
         de->high_voltage_V = t->high_cell_V;
     if (t->low_cell_V >= 2.0f && t->low_cell_V <= 4.6f)
         de->low_voltage_V  = t->low_cell_V;
-    // For "avg", we don't have per-cell average; use array voltage as a coarse overall indicator
-    de->avg_voltage_V  = t->array_voltage_V;
+    // mean of the per-cell map; 0 (shown as "--") for families that only report hi/lo
+    de->avg_voltage_V  = (t->cell_count != 0U) ? t->cell_avg_V : 0.0f;
 
     // Temps
     de->high_temp_C      = t->sys_temp_high_C;
@@ -337,7 +376,7 @@ static void make_details(NextionDetailsEvt *de, const BmsTelemetry *t) {
     // Fan + SoC
     de->fan_speed_rpm = t->fan_rpm;
     de->soc_percent   = t->soc_percent;
-    de->soc2_percent  = t->soc_percent; // you don't have a second SoC; mirror main SoC
+    de->soc2_percent  = t->soc_percent; // coulomb estimate replaces this while charging
 
     // State + Fault text
     strncpy(de->bms_state_str,
@@ -348,25 +387,154 @@ static void make_details(NextionDetailsEvt *de, const BmsTelemetry *t) {
     if (t->bms_fault == 0U) {
         strcpy(de->bms_fault_str, "None");
     } else {
-        char reasons[128];
-        BmsSeverity sev;
-        decode_faults_for_ui(t, reasons, sizeof(reasons), &sev);
         snprintf(de->bms_fault_str, sizeof(de->bms_fault_str),
-                 "%s (0x%02X)", reasons, t->bms_fault);
+                 "%s (0x%02X)", decode_faults_for_ui(fc, t, NULL), t->bms_fault);
         }
     printf("CTL: posting details to HMI\n");
 }
 
+/* ===== Fault history (pFaults) ===== */
+
+/* one history entry back into text through the same decoders as pMain */
+static void fault_text(BmsFaultCache *fc, FaultHistEntry const *x, char *out, size_t len) {
+    BmsTelemetry t;
+    memset(&t, 0, sizeof(t));
+    t.battery_type_code = x->family;
+    switch (x->domain) {
+        case FH_DOM_RAW:
+            t.bms_fault     = 1U;
+            t.bms_fault_raw = (uint8_t)(1U << x->code);
+            break;
+        case FH_DOM_ERROR:
+            t.bms_fault        = 1U;
+            t.last_error_class = (uint8_t)(x->code >> 8);
+            t.last_error_code  = (uint8_t)x->code;
+            break;
+        default:
+            snprintf(out, len, "SPN %lu FMI %u",
+                     (unsigned long)(x->code >> 5), (unsigned)(x->code & 0x1FU));
+            return;
+    }
+    snprintf(out, len, "%s", decode_faults_for_ui(fc, &t, NULL));
+}
+
+static void post_faults(ControllerAO *me) {
+    if (!hmi_owner(me)) return;
+    NextionFaultsEvt *fe = Q_NEW(NextionFaultsEvt, NEX_REQ_UPDATE_FAULTS_SIG);
+    uint8_t idx[NEX_FAULT_ROWS];
+    const uint32_t now = tick_ms();
+    fe->total = me->faults.used;
+    fe->shown = fault_hist_recent(&me->faults, idx, NEX_FAULT_ROWS);
+    for (uint8_t k = 0U; k < fe->shown; ++k) {
+        FaultHistEntry const *x = &me->faults.e[idx[k]];
+        NextionFaultRow *r = &fe->row[k];
+        fault_text(&me->ftext, x, r->text, sizeof(r->text));
+        r->count       = x->count;
+        r->active      = x->active;
+        r->first_age_s = (now - x->first_ms) / 1000U;
+        r->last_age_s  = (now - x->last_ms) / 1000U;
+    }
+    if (!QACTIVE_POST_X(AO_Nextion, &fe->super, QF_NO_MARGIN, &me->super)) {
+        QF_gc(&fe->super);
+    }
+}
+
+/* Fold one telemetry sample into the history. 500s / 600s raw bytes are
+ * bitfields (one entry per bit); the 400s byte is a fault code. */
+static void record_faults(ControllerAO *me) {
+    BmsTelemetry const *t = &me->last;
+    const uint16_t fam = t->battery_type_code;
+    const uint32_t now = tick_ms();
+    bool fresh = false;
+
+    fault_hist_begin(&me->faults);
+    if ((fam & 0xFF00u) == 0x0400u) {
+        if (t->bms_fault_raw != 0U) {
+            fresh |= fault_hist_note(&me->faults, fam, FH_DOM_ERROR, (uint32_t)t->bms_fault_raw << 8, now);
+        }
+    } else {
+        for (uint8_t b = 0U; b < 8U; ++b) {
+            if (t->bms_fault_raw & (1U << b)) {
+                fresh |= fault_hist_note(&me->faults, fam, FH_DOM_RAW, b, now);
+            }
+        }
+    }
+    if (t->last_error_class != 0U || t->last_error_code != 0U) {
+        fresh |= fault_hist_note(&me->faults, fam, FH_DOM_ERROR,
+                                 ((uint32_t)t->last_error_class << 8) | t->last_error_code, now);
+    }
+    if (t->dtc_count != 0U) {
+        J1939Dtc dtc[8];
+        const uint8_t n = BMS_GetDtcsCh(me->ch, dtc, 8U);
+        for (uint8_t k = 0U; k < n; ++k) {
+            fresh |= fault_hist_note(&me->faults, fam, FH_DOM_DTC, (dtc[k].spn << 5) | dtc[k].fmi, now);
+        }
+    }
+    fault_hist_end(&me->faults);
+
+    if (fresh) {
+        printf("CTL%u: fault history %u entries\r\n", (unsigned)me->ch, (unsigned)me->faults.used);
+        if (me->page == 5U) post_faults(me);
+    }
+}
+
+/* ===== Charge accounting ===== */
+
+/* PSU readback while its output is on (that is what goes in), else the BMS */
+static void cc_sample(ControllerAO *me) {
+    if (!me->cc_on) return;
+    int32_t i_mA, v_mV;
+    if (me->psu_present && me->psu_out_on) {
+        i_mA = (int32_t)lrintf(me->psu_i_out * 1000.0f);
+        v_mV = (int32_t)lrintf(me->psu_v_out * 1000.0f);
+    } else {
+        i_mA = (int32_t)me->last.current_dA * 100;
+        v_mV = (int32_t)lrintf(me->last.array_voltage_V * 1000.0f);
+    }
+    coulomb_sample(&me->cc, i_mA, v_mV, tick_ms());
+}
+
+static void fill_energy(ControllerAO const *me, NextionDetailsEvt *de) {
+    de->charged_Ah = (float)coulomb_session_mAh(&me->cc) * 0.001f;
+    de->charged_Wh = (float)coulomb_session_mWh(&me->cc) * 0.001f;
+    de->ttf_min    = me->cc_on ? coulomb_ttf_min(&me->cc) : 0xFFFFU;
+    if (me->cc_on && me->cc.cap_mAh != 0U) {
+        de->soc2_percent = coulomb_soc_pct(&me->cc);
+    }
+}
+
+/* pDetails and its per-cell sub-page share refresh / comms-lost handling */
+static inline bool is_details_page(uint8_t page) {
+    return page == 3U || page == 4U;
+}
+
+static void post_cells(ControllerAO *me) {
+    NextionCellsEvt *ce = Q_NEW(NextionCellsEvt, NEX_REQ_UPDATE_CELLS_SIG);
+    BmsCellStats st;
+    ce->shown       = BMS_GetCellsCh(me->ch, ce->cell_mV, NEX_CELLS_SHOWN, &st);
+    ce->count       = st.count;
+    ce->min_mV      = st.min_mv;
+    ce->max_mV      = st.max_mv;
+    ce->avg_mV      = st.mean_mv;
+    ce->spread_mV   = st.spread_mv;
+    ce->spread_warn = (st.count >= 2U && (float)st.spread_mv * 0.001f > BATT_SPREAD_MAX_V) ? 1U : 0U;
+    ce->nodes_seen  = me->last.nodes_seen;
+    ce->nodes_fresh = me->last.nodes_fresh;
+    if (!QACTIVE_POST_X(AO_Nextion, &ce->super, QF_NO_MARGIN, &me->super)) {
+        QF_gc(&ce->super);
+    }
+}
+
 /* Build & send compact summary only if it changed  */
 static void post_summary(ControllerAO *me, bool charging, char const *reason) {
-    if (!ui_ok_now_sum()) return;
+    if (!hmi_owner(me) || !ui_ok_now_sum(me)) return;
 
     uint32_t h = hash_summary(&me->last, charging, reason);
-    if (h == s_last_sum_hash) return;
-    s_last_sum_hash = h;
+    if (h == me->ui_sum_hash) return;
+    me->ui_sum_hash = h;
 
     NextionSummaryEvt *se = Q_NEW(NextionSummaryEvt, NEX_REQ_UPDATE_SUMMARY_SIG);
-    make_summary(se, &me->last);
+    make_summary(se, &me->last, &me->ftext);
     se->charging = charging ? 1U : 0U;
     if (reason && reason[0]) {
         strncpy(se->reason, reason, sizeof(se->reason)-1);
@@ -381,14 +549,18 @@ static void post_summary(ControllerAO *me, bool charging, char const *reason) {
 }
 
 static void post_details(ControllerAO *me) {
-    if (!ui_ok_now_det()) return;
+    if (!hmi_owner(me) || !ui_ok_now_det(me)) return;
+    if (me->page == 4U) { post_cells(me); return; }   // cells move below the hash quantum
 
-    uint32_t h = hash_details(&me->last);
-    if (h == s_last_det_hash) return;
-    s_last_det_hash = h;
+    uint32_t h = hash_details(&me->last)
+               ^ rotl32((uint32_t)(coulomb_session_mAh(&me->cc) / 10), 11)   // 0.01 Ah steps
+               ^ rotl32((uint32_t)coulomb_ttf_min(&me->cc), 23);
+    if (h == me->ui_det_hash) return;
+    me->ui_det_hash = h;
 
     NextionDetailsEvt *de = Q_NEW(NextionDetailsEvt, NEX_REQ_UPDATE_DETAILS_SIG);
-    make_details(de, &me->last);
+    make_details(de, &me->last, &me->ftext);
+    fill_energy(me, de);
     if (!QACTIVE_POST_X(AO_Nextion, &de->super, QF_NO_MARGIN, &me->super)) {
         QF_gc(&de->super);
     }
@@ -396,9 +568,10 @@ static void post_details(ControllerAO *me) {
 
 // --- FORCE versions: ignore rate limits & de-dupe hashes ---
 static void post_summary_force(ControllerAO *me, bool charging, char const *reason) {
+    if (!hmi_owner(me)) return;
     // build (no ui_ok_now_sum, no hash compare)
     NextionSummaryEvt *se = Q_NEW(NextionSummaryEvt, NEX_REQ_UPDATE_SUMMARY_SIG);
-    make_summary(se, &me->last);
+    make_summary(se, &me->last, &me->ftext);
     se->charging = charging ? 1U : 0U;
     if (reason && reason[0]) {
         strncpy(se->reason, reason, sizeof(se->reason)-1);
@@ -412,16 +585,20 @@ static void post_summary_force(ControllerAO *me, bool charging, char const *reas
 }
 
 static void post_details_force(ControllerAO *me) {
+    if (!hmi_owner(me)) return;
+    if (me->page == 4U) { post_cells(me); return; }
     NextionDetailsEvt *de = Q_NEW(NextionDetailsEvt, NEX_REQ_UPDATE_DETAILS_SIG);
-    make_details(de, &me->last);
+    make_details(de, &me->last, &me->ftext);
+    fill_energy(me, de);
     if (!QACTIVE_POST_X(AO_Nextion, &de->super, QF_NO_MARGIN, &me->super)) {
         QF_gc(&de->super);
     }
 }
 
 // --- HMI: PSU widget helper (same style as post_summary/post_details) ---
-static void post_psu_to_hmi(uint8_t present, uint8_t output_on,
+static void post_psu_to_hmi(ControllerAO const *me, uint8_t present, uint8_t output_on,
                             float v_out, float i_out, float temp_C) {
+    if (!hmi_owner(me)) return;
     NextionPsuEvt *pe = Q_NEW(NextionPsuEvt, NEX_REQ_UPDATE_PSU_SIG);
     pe->present   = present;
     pe->output_on = output_on;   // matches NextionPsuEvt field name
@@ -434,11 +611,91 @@ static void post_psu_to_hmi(uint8_t present, uint8_t output_on,
     }
 }
 
-static bool in_charge;
+static void cache_psu_status(ControllerAO *me, CotekStatusEvt const *se) {
+    me->psu_present = se->present;
+    me->psu_out_on  = se->out_on ? 1U : 0U;
+    me->psu_v_out   = se->v_out;
+    me->psu_i_out   = se->i_out;
+    me->psu_temp    = se->t_out;
+
+    // if we're on pMain, repaint immediately
+    if (me->page == 2U) {
+        post_psu_to_hmi(me, me->psu_present, me->psu_out_on,
+                        me->psu_v_out, me->psu_i_out, me->psu_temp);
+    }
+}
+
+static void post_psu_setpoint(ControllerAO *me, float v_set, float i_set) {
+    PsuSetEvt *se = Q_NEW(PsuSetEvt, PSU_REQ_SETPOINT_SIG);
+    se->voltSet = v_set;
+    se->currSet = i_set;
+    if (!QACTIVE_POST_X(me->psu, &se->super, QF_NO_MARGIN, &me->super)) {
+        QF_gc(&se->super);
+    }
+}
+
+/* PSU_REQ_OFF_SIG carries nothing: one immutable event serves every post,
+ * so stopping never depends on a free pool block. QF_NO_MARGIN asserts on a
+ * full queue; margin 1 is for the retries, which may be dropped. */
+static void post_psu_off(ControllerAO *me, uint_fast16_t margin) {
+    static QEvt const offEvt = QEVT_INITIALIZER(PSU_REQ_OFF_SIG);
+    (void)QACTIVE_POST_X(me->psu, &offEvt, margin, &me->super);
+}
+
+static void charge_inputs(ControllerAO const *me, ChargeInputs *in) {
+    in->high_cell_V = me->last.high_cell_V;
+    in->low_cell_V  = me->last.low_cell_V;
+    in->pack_V      = me->last.array_voltage_V;
+    in->bms_I_A     = (float)me->last.current_dA / 10.0f;
+    in->psu_V       = me->psu_v_out;
+    in->psu_I       = me->psu_i_out;
+    in->psu_on      = (me->psu_out_on != 0U);
+}
+
+#if !defined(ENABLE_BMS_SIM)
+/* Start the engine on the latest BMS view and take its first step without
+ * touching the PSU. Runs before the transition to Ctl_charge (an entry action
+ * cannot transition back out); false when the pack has no profile or is
+ * already DONE/FAULT, with the reason in me->chg.why. */
+static bool charge_begin(ControllerAO *me, bool recoverable) {
+    ChargeProfile const *prof = charge_profile_for(me->last.battery_type_code);
+    bool const pre = recoverable
+                  || (prof != NULL && me->last.low_cell_V < prof->cell_pre_exit_V);
+    ChargeInputs in;
+    charge_inputs(me, &in);
+    charge_start(&me->chg, me->last.battery_type_code, pre, tick_ms());
+    (void)charge_step(&me->chg, &in, tick_ms());
+    return me->chg.stage != CHG_STAGE_DONE && me->chg.stage != CHG_STAGE_FAULT;
+}
+#endif
+
+/* Step the charge engine with the latest BMS + PSU view. Re-programs the PSU
+ * only when the setpoint moved; returns false once the charge has ended
+ * (DONE or FAULT) and the caller should power down. */
+static bool charge_update(ControllerAO *me) {
+    ChargeInputs in;
+    charge_inputs(me, &in);
+
+    if (!charge_step(&me->chg, &in, tick_ms())) {
+        return true;
+    }
+    if (me->chg.stage == CHG_STAGE_DONE || me->chg.stage == CHG_STAGE_FAULT) {
+        printf("CTL: %s (%s)\r\n", charge_stage_str(me->chg.stage), me->chg.why);
+        post_psu_off(me, QF_NO_MARGIN);
+        post_summary(me, false, me->chg.why);
+        return false;
+    }
+    printf("CTL: %s V=%.2f I=%.2f\r\n", charge_stage_str(me->chg.stage),
+           (double)me->chg.vset, (double)me->chg.iset);
+    post_psu_setpoint(me, me->chg.vset, me->chg.iset);
+    post_summary(me, true, charge_stage_str(me->chg.stage));
+    return true;
+}
 
 static void post_page_ex(ControllerAO *me, uint8_t page) {
     // keep our own notion of the current page in sync
     me->page = page;
+    if (!hmi_owner(me)) return;   // repainted when the panel switches to us
 
     // tell Nextion to change page
     NextionPageEvt *pg = Q_NEW(NextionPageEvt, NEX_REQ_SHOW_PAGE_SIG);
@@ -448,8 +705,8 @@ static void post_page_ex(ControllerAO *me, uint8_t page) {
     }
 
     // force next UI publish to repaint (reset de-dupe hashes)
-    s_last_sum_hash = 0U;
-    s_last_det_hash = 0U;
+    me->ui_sum_hash = 0U;
+    me->ui_det_hash = 0U;
 
     // repaint immediately if we already have data
     if (me->haveData) {
@@ -458,21 +715,23 @@ static void post_page_ex(ControllerAO *me, uint8_t page) {
                 (me->state == CTL_STATE_CHARGE || me->state == CTL_STATE_DETECT),
                 NULL);
             // also push last-known PSU snapshot right away
-            post_psu_to_hmi(me->psu_present, me->psu_out_on,
+            post_psu_to_hmi(me, me->psu_present, me->psu_out_on,
                             me->psu_v_out, me->psu_i_out, me->psu_temp);
-        } else if (page == 3U) {   // pDetails
+        } else if (is_details_page(page)) {   // pDetails / pCells
             post_details_force(me);
         }
     }
+    if (page == 5U) post_faults(me);          // history stays readable without a pack
 }
 
-static void post_comms_lost(const ControllerAO *me) {
+static void post_comms_lost(ControllerAO *me) {
+    if (!hmi_owner(me)) return;
     // ensure next summary pushes through no matter what
-    s_last_sum_hash = 0U;
-    s_last_det_hash = 0U;
+    me->ui_sum_hash = 0U;
+    me->ui_det_hash = 0U;
 
     NextionSummaryEvt *se = Q_NEW(NextionSummaryEvt, NEX_REQ_UPDATE_SUMMARY_SIG);
-    make_summary(se, &me->last);
+    make_summary(se, &me->last, &me->ftext);
 
     strncpy(se->classStr, "Comms Lost!", sizeof(se->classStr)-1);
     se->classStr[sizeof(se->classStr)-1] = '\0';
@@ -489,48 +748,66 @@ static void post_comms_lost(const ControllerAO *me) {
     }
 }
 
-static inline uint32_t bms_age_ms(void) {
-    return tick_ms() - last_bms_ms;
+static inline uint32_t bms_age_ms(uint8_t ch) {
+    return tick_ms() - last_bms_ms[ch];
 }
 /* coarsen an age to 100 ms buckets so we don’t spam */
 static inline uint32_t age_bucket_100ms(uint32_t age_ms){
     return age_ms / 100U;
 }
 /* Example freshness checker used by UI + controller */
-bool bms_is_fresh(void){
-    uint32_t age = bms_age_ms();
+bool bms_is_fresh(uint8_t ch){
+    uint32_t age = bms_age_ms(ch);
     bool fresh = (age < BMS_WATCH_MS);  /* or whatever threshold you use for 'fresh' */
 
 #if BMS_DEBUG
-    if (s_prev_fresh == 255U) {
+    if (s_prev_fresh[ch] == 255U) {
         BMS_DBG("BMSDBG: init freshness fresh=%u age=%lu ms (th=%lu)\r\n",
                 (unsigned)fresh, (unsigned long)age, (unsigned long)BMS_WATCH_MS);
-    } else if ((bool)s_prev_fresh != fresh) {
+    } else if ((bool)s_prev_fresh[ch] != fresh) {
         BMS_DBG("BMSDBG: freshness transition %s → %s at age=%lu ms\r\n",
-                s_prev_fresh ? "FRESH" : "STALE",
+                s_prev_fresh[ch] ? "FRESH" : "STALE",
                 fresh ? "FRESH" : "STALE",
                 (unsigned long)age);
     }
-    s_prev_fresh = (uint8_t)fresh;
+    s_prev_fresh[ch] = (uint8_t)fresh;
 #endif
     return fresh;
 }
 
 /* ctor */
 void ControllerAO_ctor(void) {
+    for (uint8_t ch = 0U; ch < APP_NUM_CHANNELS; ++ch) {
+        ControllerAO *me = &l_ctl[ch];
 #ifdef ENABLE_BMS_SIM
-    QTimeEvt_ctorX(&l_ctl.simTick, &l_ctl.super, SIM_TICK_SIG, 0U);
+        QTimeEvt_ctorX(&me->simTick, &me->super, SIM_TICK_SIG, BSP_RATE_SLOW);
 #endif
-    QActive_ctor(&l_ctl.super, Q_STATE_CAST(&Ctl_initial));
-    QTimeEvt_ctorX(&l_ctl.ui2s,   &l_ctl.super, TIMEOUT_SIG, 0U);
-    QTimeEvt_ctorX(&l_ctl.tCharge, &l_ctl.super, CHARGE_TIMEOUT_SIG, 0U);
-    QTimeEvt_ctorX(&l_ctl.tPsuOff, &l_ctl.super, PSU_OFF_WAIT_TO_SIG, 0U);
-    QTimeEvt_ctorX(&l_ctl.tLostHold, &l_ctl.super, LOST_HOLD_TO_SIG, 0U);
+        QActive_ctor(&me->super, Q_STATE_CAST(&Ctl_initial));
+        QTimeEvt_ctorX(&me->ui2s,   &me->super, TIMEOUT_SIG, BSP_RATE_SLOW);
+        QTimeEvt_ctorX(&me->tCharge, &me->super, CHARGE_TIMEOUT_SIG, BSP_RATE_SLOW);
+        QTimeEvt_ctorX(&me->tPsuOff, &me->super, PSU_OFF_WAIT_TO_SIG, BSP_RATE_FAST);
+        QTimeEvt_ctorX(&me->tLostHold, &me->super, LOST_HOLD_TO_SIG, BSP_RATE_SLOW);
+        me->ch = ch;
+        me->age_bucket = UINT32_MAX;
+        AO_ControllerCh[ch] = &me->super;
+        s_prev_fresh[ch] = 255U;
+    }
 }
 
 /* states */
 static QState Ctl_initial(ControllerAO * const me, void const *const e) {
     (void)e;
+    me->psu      = AO_CotekCh[me->ch];   // peers exist once every ctor has run
+    QS_OBJ_ARR_DICTIONARY(&l_ctl[me->ch], me->ch);
+    QS_OBJ_ARR_DICTIONARY(&l_ctl[me->ch].ui2s, me->ch);
+    QS_OBJ_ARR_DICTIONARY(&l_ctl[me->ch].tCharge, me->ch);
+    QS_OBJ_ARR_DICTIONARY(&l_ctl[me->ch].tPsuOff, me->ch);
+    QS_OBJ_ARR_DICTIONARY(&l_ctl[me->ch].tLostHold, me->ch);
+    QS_FUN_DICTIONARY(&Ctl_run);
+    QS_FUN_DICTIONARY(&Ctl_wait);
+    QS_FUN_DICTIONARY(&Ctl_detect);
+    QS_FUN_DICTIONARY(&Ctl_charge);
+    QS_FUN_DICTIONARY(&Ctl_poweringDown);
     me->page     = 1U;   // start at pWait after splash
     me->haveData = 0U;
     memset(&me->last, 0, sizeof(me->last));
@@ -539,15 +816,19 @@ static QState Ctl_initial(ControllerAO * const me, void const *const e) {
     me->psu_v_out   = 0.0f;
     me->psu_i_out   = 0.0f;
     me->psu_temp    = 0.0f;
+    fault_hist_reset(&me->faults);
+    memset(&me->cc, 0, sizeof(me->cc));
+    memset(&me->ftext, 0, sizeof(me->ftext));
+    me->cc_on = 0U;
     //QTimeEvt_disarm(&me->tBmsWatch);
     /* subscribe AFTER we’re started */
     QActive_subscribe(&me->super, BMS_UPDATED_SIG);
-    QActive_subscribe(&me->super, BMS_NO_BATTERY_SIG);
-    QActive_subscribe(&me->super, BMS_CONN_LOST_SIG);
 
 #ifdef ENABLE_BMS_SIM
-    // every 500 ms (adjust as you like)
-    QTimeEvt_armX(&me->simTick, BSP_TICKS_PER_SEC/2, BSP_TICKS_PER_SEC/2);
+    // every 500 ms (adjust as you like); the simulator feeds bay 0 only
+    if (me->ch == 0U) {
+        QTimeEvt_armX(&me->simTick, BSP_SLOW_TICKS_PER_SEC/2, BSP_SLOW_TICKS_PER_SEC/2);
+    }
 #endif
     return Q_TRAN(&Ctl_run);
 }
@@ -585,26 +866,28 @@ static QState Ctl_run(ControllerAO * const me, QEvt const * const e) {
         }
     }
     case PSU_RSP_STATUS_SIG: {
-        CotekStatusEvt const *se = (CotekStatusEvt const *)e;
-
-        // cache
-        me->psu_present = se->present;
-        me->psu_out_on  = se->out_on ? 1U : 0U;
-        me->psu_v_out   = se->v_out;
-        me->psu_i_out   = se->i_out;
-        me->psu_temp    = se->t_out;
-
-        // if we're on pMain, repaint immediately
-        if (me->page == 2U) {
-            post_psu_to_hmi(me->psu_present, me->psu_out_on,
-                            me->psu_v_out, me->psu_i_out, me->psu_temp);
-        }
+        cache_psu_status(me, (CotekStatusEvt const *)e);
+        return Q_HANDLED();
+    }
+    case HMI_SELECT_SIG: {
+        // panel switched to this bay: show our page with everything on it
+        post_page_ex(me, me->page);
+        return Q_HANDLED();
+    }
+    case ESTOP_SIG: {               // the PSU already switched off before telling us
+        post_summary(me, false, "E-STOP: PSU off");
+        return Q_HANDLED();
+    }
+    case ESTOP_RELEASE_SIG: {
+        post_summary(me, false, "E-STOP released");
         return Q_HANDLED();
     }
     case BMS_UPDATED_SIG: {
         BmsTelemetryEvt const *be = Q_EVT_CAST(BmsTelemetryEvt);
+        if (be->ch != me->ch) return Q_HANDLED();   /* another bay's */
         me->haveData = 1U;
         me->last     = be->data;
+        record_faults(me);
 
         // page transition like you have
         if (me->page == 1U) { // pWait -> pMain
@@ -622,27 +905,29 @@ static QState Ctl_run(ControllerAO * const me, QEvt const * const e) {
         return Q_HANDLED();
     }
     case TIMEOUT_SIG: {
-        uint32_t age = bms_age_ms();
+        uint32_t age = bms_age_ms(me->ch);
         uint32_t bucket = age_bucket_100ms(age);
-        if (bucket != s_prev_age_bucket) {
-            s_prev_age_bucket = bucket;
+        if (bucket != me->age_bucket) {
+            me->age_bucket = bucket;
             BMS_DBG("BMSDBG: HB age=%lu ms fresh=%u haveData=%u state=%u page=%u\r\n",
-                    (unsigned long)age, (unsigned)bms_is_fresh(),
+                    (unsigned long)age, (unsigned)bms_is_fresh(me->ch),
                     (unsigned)me->haveData, (unsigned)me->state,
                     (unsigned)me->page);
         }
         if (!me->haveData) { return Q_HANDLED(); }  // nothing fresh → don’t overwrite banner
 
-        if (me->page == 3U) {
+        if (is_details_page(me->page)) {
             post_details(me);
         } else if (me->page == 2U) {
             post_summary(me, false, 0);
+        } else if (me->page == 5U) {
+            post_faults(me);
         }
         return Q_HANDLED();
     }
     // case BUTTON_PRESSED_SIG: {
     //     /* Only act if we have a battery detected */
-    //     if (me->haveData && bms_is_fresh()) {
+    //     if (me->haveData && bms_is_fresh(me->ch)) {
     //         return Q_TRAN(&Ctl_charge);   /* logic lives in the charge state's entry */
     //     }
     //     /* stale or missing: refuse cleanly */
@@ -652,41 +937,44 @@ static QState Ctl_run(ControllerAO * const me, QEvt const * const e) {
     case NEX_REQ_SHOW_PAGE_SIG: {  // coming FROM Nextion via Nextion_OnRx()
         NextionPageEvt const *pe = (NextionPageEvt const*)e;
         me->page = pe->page;
-        s_last_sum_hash = 0U; s_last_det_hash = 0U;   // force repaint
+        me->ui_sum_hash = 0U; me->ui_det_hash = 0U;   // force repaint
         if (me->haveData) {
             if (me->page == 2U) {
                 post_summary_force(me,
                     (me->state==CTL_STATE_CHARGE || me->state==CTL_STATE_DETECT), "");
-                post_psu_to_hmi(me->psu_present, me->psu_out_on,
+                post_psu_to_hmi(me, me->psu_present, me->psu_out_on,
                                 me->psu_v_out, me->psu_i_out, me->psu_temp);
-            } else if (me->page == 3U) {
+            } else if (is_details_page(me->page)) {
                 post_details_force(me);
             }
         }
+        if (me->page == 5U) post_faults(me);
         return Q_HANDLED();
         }
+    case FAULT_HIST_CLEAR_SIG: {
+        fault_hist_reset(&me->faults);
+        printf("CTL%u: fault history cleared\r\n", (unsigned)me->ch);
+        post_faults(me);
+        return Q_HANDLED();
+    }
     case BMS_CONN_LOST_SIG: {
         me->haveData = 0U;
         /* NEW: wipe last-known telemetry so UI can’t reuse stale numbers */
         memset(&me->last, 0, sizeof(me->last));
 
-        // If user is on pDetails, switch to pMain
-        if (me->page == 3U) {
+        // If user is on pDetails / pCells, switch to pMain
+        if (is_details_page(me->page)) {
             post_page_ex(me, 2U);   // pMain
         }
 
         // If user is on pMain, or we just switched to it, post comms-lost banner
         if (me->page == 2U) {
             post_comms_lost(me);
-            QTimeEvt_armX(&me->tLostHold, 10U * BSP_TICKS_PER_SEC, 0U);
+            QTimeEvt_armX(&me->tLostHold, 10U * BSP_SLOW_TICKS_PER_SEC, 0U);
         }
 
         /* 1) ask PSU to turn OFF */
-        QEvt *off = Q_NEW(QEvt, PSU_REQ_OFF_SIG);
-        // UI/PSU requests are “best effort”: use margin 0U and GC if it can’t be queued right now
-        if (!QACTIVE_POST_X(AO_Cotek, off, QF_NO_MARGIN, 0U)) {
-            QF_gc(off);
-        }
+        post_psu_off(me, QF_NO_MARGIN);
         // /* 2) start short timeout (e.g., 500 ms) as a guard */
         // QTimeEvt_armX(&me->tPsuOff, 50U, 0U);   /* assuming your tick is 10ms */
         /* 3) go wait for OFF confirmation, timer will be armed in the entry case */
@@ -720,8 +1008,10 @@ static QState Ctl_wait(ControllerAO * const me, QEvt const * const e) {
     //     }
     case BMS_UPDATED_SIG: {
             BmsTelemetryEvt const *be = Q_EVT_CAST(BmsTelemetryEvt);
+            if (be->ch != me->ch) return Q_HANDLED();   /* another bay's */
             me->haveData = 1U;
             me->last     = be->data;
+            record_faults(me);
 
             // page transition like you have
             if (me->page == 1U) { // pWait -> pMain
@@ -760,7 +1050,7 @@ static QState Ctl_detect(ControllerAO * const me, QEvt const * const e) {
         me->state = CTL_STATE_DETECT;
         printf("Ctl_detect -> ENTRY");
         /* 2s UI refresh, in case we want periodic updates anyway */
-        QTimeEvt_armX(&me->ui2s, BSP_TICKS_PER_SEC*2U, BSP_TICKS_PER_SEC*2U);
+        QTimeEvt_armX(&me->ui2s, BSP_SLOW_TICKS_PER_SEC*2U, BSP_SLOW_TICKS_PER_SEC*2U);
         return Q_HANDLED();
     }
     case Q_EXIT_SIG: {
@@ -770,13 +1060,15 @@ static QState Ctl_detect(ControllerAO * const me, QEvt const * const e) {
     case TIMEOUT_SIG: { /* periodic UI refresh */
         if (!me->haveData) { return Q_HANDLED(); }  // nothing fresh → don’t overwrite banner
 
-        if (me->page == 3U) {
+        if (me->page == 5U) {
+            post_faults(me);
+        } else if (is_details_page(me->page)) {
             post_details(me);
         } else if (me->page == 2U) {
-            if (!bms_is_fresh()) {
+            if (!bms_is_fresh(me->ch)) {
                 char why[64];
                 // show age with one decimal (e.g. "No fresh BMS for 1.7 s")
-                float age_s = bms_age_ms() / 1000.0f;
+                float age_s = bms_age_ms(me->ch) / 1000.0f;
                 snprintf(why, sizeof(why), "No fresh BMS for %.1f s", (double)age_s);
                 post_summary(me, false, why);
             } else {
@@ -794,7 +1086,9 @@ static QState Ctl_detect(ControllerAO * const me, QEvt const * const e) {
     }
     case BMS_UPDATED_SIG: {
         BmsTelemetryEvt const *be = Q_EVT_CAST(BmsTelemetryEvt);
+        if (be->ch != me->ch) return Q_HANDLED();   /* another bay's */
         me->last = be->data; me->haveData = 1U;
+        record_faults(me);
         post_summary(me, false, "ready to charge");
         post_details(me);
         return Q_HANDLED();
@@ -804,15 +1098,15 @@ static QState Ctl_detect(ControllerAO * const me, QEvt const * const e) {
         /* NEW: wipe last-known telemetry so UI can’t reuse stale numbers */
         memset(&me->last, 0, sizeof(me->last));
 
-        // If user is on pDetails, switch to pMain
-        if (me->page == 3U) {
+        // If user is on pDetails / pCells, switch to pMain
+        if (is_details_page(me->page)) {
             post_page_ex(me, 2U);   // pMain
         }
 
         // If user is on pMain, or we just switched to it, post comms-lost banner
         if (me->page == 2U) {
             post_comms_lost(me);
-            QTimeEvt_armX(&me->tLostHold, 10U * BSP_TICKS_PER_SEC, 0U);
+            QTimeEvt_armX(&me->tLostHold, 10U * BSP_SLOW_TICKS_PER_SEC, 0U);
         }
         return Q_HANDLED();
     }
@@ -820,11 +1114,16 @@ static QState Ctl_detect(ControllerAO * const me, QEvt const * const e) {
     case BUTTON_PRESSED_SIG: {
     printf("Ctl_detect-BTN: PC13 pressed\r\n");
 
-    if (!Cotek_isPresent()) {
+    if (Input_estopActive()) {
+        post_summary(me, false, "E-STOP active");
+        return Q_HANDLED();
+    }
+
+    if (!Cotek_isPresentCh(me->ch)) {
         post_summary(me, false, "PSU not present/error");
         return Q_HANDLED();
     }
-    if (!me->haveData || !bms_is_fresh()) {
+    if (!me->haveData || !bms_is_fresh(me->ch)) {
         post_summary(me, false, "No recent BMS data");
         return Q_HANDLED();
     }
@@ -835,6 +1134,12 @@ static QState Ctl_detect(ControllerAO * const me, QEvt const * const e) {
         post_summary(me, false, "Not Recoverable – charging blocked");
         return Q_HANDLED();
     } else if (cr.cls == BATT_CLASS_RECOVERABLE || cr.cls == BATT_CLASS_OPERATIONAL) {
+        // first engine step here: a full or faulted pack never enters Ctl_charge
+        if (!charge_begin(me, cr.cls == BATT_CLASS_RECOVERABLE)) {
+            printf("CTL: not charging (%s)\r\n", me->chg.why);
+            post_summary(me, false, me->chg.why);
+            return Q_HANDLED();
+        }
         printf("Ctl_detect transition to Ctl_charge\r\n");
         return Q_TRAN(&Ctl_charge);
     } else {
@@ -863,69 +1168,77 @@ static QState Ctl_charge(ControllerAO * const me, QEvt const * const e) {
     switch (e->sig) {
     case Q_ENTRY_SIG: {
         me->state = CTL_STATE_CHARGE;
-        in_charge = true;
         printf("Ctl_charge: entry\r\n");
 #if !defined(ENABLE_BMS_SIM)
         // === REAL BATTERIES ONLY ===
-        BattClassResult cr = batt_classify(&me->last, /*bms_sim_active=*/false);
-
-        float v_set = 48.0f;
-        float i_set = 0.0f;
-
-        if (cr.cls == BATT_CLASS_NOT_RECOVERABLE) {
-            post_summary(me, false, "Blocked: Not Recoverable");
-            return Q_TRAN(&Ctl_detect);  // do not arm timer, do not command PSU
-        } else if (cr.cls == BATT_CLASS_RECOVERABLE) {
-            i_set = 1.0f;  // 48V / 1A
-        } else if (cr.cls == BATT_CLASS_OPERATIONAL) {
-            i_set = 3.0f;  // 48V / 3A
-        } else {
-            post_summary(me, false, "Unknown class – cannot charge");
-            return Q_TRAN(&Ctl_detect);
-        }
+        // Ctl_detect classified the pack and ran charge_begin(): the engine
+        // holds a live PRECHARGE/CC setpoint, so only program the PSU here
+        ChargeProfile const *prof = me->chg.p;
+        coulomb_start(&me->cc, (uint32_t)prof->capacity_Ah * 1000U, me->last.soc_percent, tick_ms());
+        me->cc_on = 1U;
+        cc_sample(me);
+        printf("CTL: start charging profile 0x%04X (cap %u min) %s V=%.2f I=%.2f\r\n",
+               (unsigned)prof->type_code, (unsigned)prof->max_total_min,
+               charge_stage_str(me->chg.stage), (double)me->chg.vset, (double)me->chg.iset);
+        post_psu_setpoint(me, me->chg.vset, me->chg.iset);
+        post_summary(me, true, charge_stage_str(me->chg.stage));
+        QTimeEvt_armX(&me->tCharge, (uint32_t)prof->max_total_min * 60U * BSP_SLOW_TICKS_PER_SEC, 0U);
 #else
-        // === SIM BUILD === (previous default used in your code)
+        // === SIM BUILD === fixed setpoint, engine stays idle
         float v_set = 12.0f;
         float i_set = 1.0f;
-#endif
+        memset(&me->chg, 0, sizeof(me->chg));
 
         printf("CTL: start charging V=%.1f I=%.1f (30s)\r\n", (double)v_set, (double)i_set);
-
-        PsuSetEvt *se = Q_NEW(PsuSetEvt, PSU_REQ_SETPOINT_SIG);
-        se->voltSet = v_set;
-        se->currSet = i_set;
-        if (!QACTIVE_POST_X(AO_Cotek, &se->super, QF_NO_MARGIN, 0U)) {
-            QF_gc(&se->super);
-        }
+        post_psu_setpoint(me, v_set, i_set);
         post_summary(me, true, "charging");
-        QTimeEvt_armX(&me->tCharge, 30U * BSP_TICKS_PER_SEC, 0U);
+        QTimeEvt_armX(&me->tCharge, 30U * BSP_SLOW_TICKS_PER_SEC, 0U);
+#endif
         return Q_HANDLED();
     }
     case Q_EXIT_SIG: {
-        in_charge = false;
         printf("Ctl_charge: exit\r\n");
+        if (me->cc_on) {
+            cc_sample(me);   /* close the last interval */
+            me->cc_on = 0U;
+            printf("CTL%u: session %ld mAh / %ld mWh in %lu s\r\n", (unsigned)me->ch,
+                   (long)coulomb_session_mAh(&me->cc), (long)coulomb_session_mWh(&me->cc),
+                   (unsigned long)((tick_ms() - me->cc.t0_ms) / 1000U));
+        }
         QTimeEvt_disarm(&me->tCharge);
         return Q_HANDLED();
     }
     case BMS_UPDATED_SIG: {
         BmsTelemetryEvt const *be = Q_EVT_CAST(BmsTelemetryEvt);
+        if (be->ch != me->ch) return Q_HANDLED();   /* another bay's */
         me->last = be->data; me->haveData = 1U;
+        record_faults(me);
+        cc_sample(me);
+        if (me->last.soc_percent != 0U) coulomb_correct(&me->cc, me->last.soc_percent);
 
         /* guard: temp < 35C and no new errors */
         if (me->last.sys_temp_high_C > 35.0f || me->last.last_error_class) {
-            QEvt *off = Q_NEW(QEvt, PSU_REQ_OFF_SIG);
-            // UI/PSU requests are “best effort”: use margin 0U and GC if it can’t be queued right now
-            if (!QACTIVE_POST_X(AO_Cotek, off, QF_NO_MARGIN, 0U)) {
-                QF_gc(off);
-            }
+            post_psu_off(me, QF_NO_MARGIN);
             post_summary(me, false,
                 (me->last.sys_temp_high_C > 35.0f) ? "Stopped: temp > 35C"
                                                    : "Stopped: new error");
             printf("Ctl_charge: BMS_UPDATE_SIG - High temp or error detected\r\n");
             return Q_TRAN(&Ctl_detect);
         }
+        if (!charge_update(me)) {
+            return Q_TRAN(&Ctl_poweringDown);
+        }
         /* refresh UI while charging */
-        post_summary(me, true, "charging");
+        post_summary(me, true, (me->chg.stage != CHG_STAGE_IDLE) ? charge_stage_str(me->chg.stage)
+                                                                : "charging");
+        return Q_HANDLED();
+    }
+    case PSU_RSP_STATUS_SIG: {
+        cache_psu_status(me, (CotekStatusEvt const *)e);
+        cc_sample(me);
+        if (!charge_update(me)) {
+            return Q_TRAN(&Ctl_poweringDown);
+        }
         return Q_HANDLED();
     }
     case BMS_CONN_LOST_SIG: {
@@ -934,15 +1247,11 @@ static QState Ctl_charge(ControllerAO * const me, QEvt const * const e) {
 
         post_summary(me, false, "Stopped: BMS lost");
         // ensure page and comms-lost banner + warn icon
-        if (me->page == 3U) { post_page_ex(me, 2U); }
+        if (is_details_page(me->page)) { post_page_ex(me, 2U); }
         post_comms_lost(me);
-        QTimeEvt_armX(&me->tLostHold, 10U * BSP_TICKS_PER_SEC, 0U);
+        QTimeEvt_armX(&me->tLostHold, 10U * BSP_SLOW_TICKS_PER_SEC, 0U);
         /* 1) ask PSU to turn OFF */
-        QEvt *off = Q_NEW(QEvt, PSU_REQ_OFF_SIG);
-        // UI/PSU requests are “best effort”: use margin 0U and GC if it can’t be queued right now
-        if (!QACTIVE_POST_X(AO_Cotek, off, QF_NO_MARGIN, 0U)) {
-            QF_gc(off);
-        }
+        post_psu_off(me, QF_NO_MARGIN);
         // /* 2) start short timeout (e.g., 500 ms) as a guard */
         // QTimeEvt_armX(&me->tPsuOff, 50U, 0U);   /* assuming your tick is 10ms */
         /* 3) go wait for OFF confirmation */
@@ -951,22 +1260,19 @@ static QState Ctl_charge(ControllerAO * const me, QEvt const * const e) {
     case CHARGE_TIMEOUT_SIG: {
             printf("Ctl_charge: Charge_timeout_sig\r\n");
             // Ask PSU to turn OFF, then wait for confirmation in the substate
-            QEvt *off = Q_NEW(QEvt, PSU_REQ_OFF_SIG);
-            if (!QACTIVE_POST_X(AO_Cotek, off, QF_NO_MARGIN, 0U)) {
-                QF_gc(off);
-            }
-            post_summary(me, false, "Stopped: 30s timeout");
+            post_psu_off(me, QF_NO_MARGIN);
+            post_summary(me, false, "Stopped: charge time limit");
             return Q_TRAN(&Ctl_poweringDown);
     }
+    case ESTOP_SIG:
+        post_summary(me, false, "Stopped: E-STOP");
+        return Q_TRAN(&Ctl_poweringDown);
+    case BUTTON_LONG_PRESS_SIG:  // hold stops as well: works even mid double-press window
     case BUTTON_PRESSED_SIG:     // or BUTTON_RELEASED_SIG if you prefer
 
         post_summary(me, false, "Stopped: user");
         /* 1) ask PSU to turn OFF */
-        QEvt *off = Q_NEW(QEvt, PSU_REQ_OFF_SIG);
-        // UI/PSU requests are “best effort”: use margin 0U and GC if it can’t be queued right now
-        if (!QACTIVE_POST_X(AO_Cotek, off, QF_NO_MARGIN, 0U)) {
-            QF_gc(off);
-        }
+        post_psu_off(me, QF_NO_MARGIN);
         /* 3) go wait for confirmation */
         return Q_TRAN(&Ctl_poweringDown);
 
@@ -980,16 +1286,12 @@ static QState Ctl_poweringDown(ControllerAO * const me, QEvt const * const e) {
     switch (e->sig) {
     case Q_ENTRY_SIG: {
             // Ask PSU to turn OFF
-        QEvt *off = Q_NEW(QEvt, PSU_REQ_OFF_SIG);
-            // UI/PSU requests are “best effort”: use margin 0U and GC if it can’t be queued right now
-        if (!QACTIVE_POST_X(AO_Cotek, off, 1U, 0U)) {
-                QF_gc(off);
-            }
+        post_psu_off(me, 1U);
 
             // Start a short watchdog while waiting for confirmation.
             // 200ms is typical; tune as you like.
         QTimeEvt_disarm(&me->tPsuOff);
-        QTimeEvt_armX(&me->tPsuOff, BSP_TICKS_PER_SEC / 5U, 0U);
+        QTimeEvt_armX(&me->tPsuOff, BSP_FAST_TICKS_PER_SEC / 5U, 0U);
             // psuoff_start(me,20U);
             // Optional: tell UI we’re stopping (don’t say OFF yet)
         post_summary(me, false, "stopping...");
@@ -1005,7 +1307,7 @@ static QState Ctl_poweringDown(ControllerAO * const me, QEvt const * const e) {
             if (!output_is_on) {
                 // OFF confirmed → now safe to say OFF and leave the substate
                 /* cancel the wait timer */
-                post_psu_to_hmi(/*present=*/1U, /*output_on=*/0U,
+                post_psu_to_hmi(me, /*present=*/1U, /*output_on=*/0U,
                 se->v_out, se->i_out, se->t_out);
                 QTimeEvt_disarm(&me->tPsuOff);
                 post_summary(me, false, "power off confirmed");
@@ -1017,8 +1319,8 @@ static QState Ctl_poweringDown(ControllerAO * const me, QEvt const * const e) {
     }
     case PSU_OFF_WAIT_TO_SIG: {
             // Didn’t see OFF yet; re-issue OFF and keep waiting.
-            (void)QACTIVE_POST_X(AO_Cotek, Q_NEW(QEvt, PSU_REQ_OFF_SIG), 1U, 0U);
-            QTimeEvt_rearm(&me->tPsuOff, BSP_TICKS_PER_SEC / 5U);
+            post_psu_off(me, 1U);
+            QTimeEvt_rearm(&me->tPsuOff, BSP_FAST_TICKS_PER_SEC / 5U);
             return Q_HANDLED();
     }
     case Q_EXIT_SIG: {
@@ -15,45 +15,98 @@
 #include "stm32f1xx_hal_i2c.h"
 #include "main.h"
 #include <math.h>
+#include "app_channels.h"
+#include "ao_input.h"
+#ifdef ENABLE_COTEK_EMU
+#include "cotek_emu.h"
+#endif
 
 Q_DEFINE_THIS_FILE
 
-#define COTEK_I2C_ADDR ((0x50) << 1)  // STM32 expects 8-bit address (shifted left)
-#define I2C_TIMEOUT_MS 100
-static uint8_t tx_data[2];
-static uint8_t rx_data[2];
+// per-bay address comes from g_appChannels[].psu_i2c_addr (bay 0: 0x50 << 1)
+/* A Cotek transfer is at most ~12 bytes, ~1.2 ms at 100 kHz: 10 ms covers
+ * clock stretching and bounds how long one transfer can hold an e-stop OFF. */
+#define I2C_TIMEOUT_MS 10U
+#define COTEK_PROBE_TIMEOUT_MS  2U    /* address-only presence probe */
+#define COTEK_POLL_MS         500U    /* COTEK_TICK_SIG period */
+#define COTEK_STALE_MS       1000U    /* no reply for this long -> not present */
+
+/* Setpoint ramp: targets are approached at these rates, one step per
+ * COTEK_RAMP_MS. Override per build if a pack family needs gentler starts. */
+#ifndef COTEK_RAMP_MS
+#define COTEK_RAMP_MS         100U
+#endif
+#ifndef COTEK_RAMP_V_PER_S
+#define COTEK_RAMP_V_PER_S    2.0f
+#endif
+#ifndef COTEK_RAMP_A_PER_S
+#define COTEK_RAMP_A_PER_S    0.5f
+#endif
+#define COTEK_RAW_UNKNOWN     0xFFFFU  /* register content not known -> must write */
+
+/* Telemetry registers (little-endian words) */
+#define COTEK_REG_VOUT   0x60U   /* V*100 */
+#define COTEK_REG_IOUT   0x62U   /* A*100 */
+#define COTEK_REG_TEMP   0x68U   /* degC  */
+#define COTEK_REG_CTRL   0x7CU   /* bit7=remote, bit2=update, bit0=ON */
+
+/* Contiguous status window fetched in one repeated-start read (0x60..0x68).
+ * Registers outside it (the control byte) are still read individually. */
+#ifndef COTEK_STATUS_WIN_FIRST
+#define COTEK_STATUS_WIN_FIRST  COTEK_REG_VOUT
+#endif
+#ifndef COTEK_STATUS_WIN_LAST
+#define COTEK_STATUS_WIN_LAST   COTEK_REG_TEMP
+#endif
+#define COTEK_STATUS_WIN_LEN    (COTEK_STATUS_WIN_LAST - COTEK_STATUS_WIN_FIRST + 1U)
+
+#ifdef ENABLE_COTEK_EMU
+#define COTEK_EMU_REPORT_TICKS  10U   /* emulator stats every 10 polls (5 s) */
+#endif
 extern volatile uint16_t g_lastSig;
 extern volatile uint8_t  g_lastTag;
 
 static void Scan_I2C_Bus(I2C_HandleTypeDef *hi2c);
-/* local helper prototypes (file-local linkage) */
-static void  cotek_set_remote_mode(void);
-static void  cotek_set_output_voltage(float voltage);
-static void  cotek_set_output_current(float current);
-static void  cotek_commit_settings(void);
-static void  cotek_power_on(void);
-static void  cotek_power_off(void);
-static float cotek_read_voltage(void);
-static float cotek_read_current(void);
-static float cotek_read_temperature(void);
 
 
 typedef struct {
     QActive super;
+    uint8_t  ch;          // bay index
+    uint16_t i2c_addr;    // 8-bit HAL address of this bay's supply
+    QActive *ctl;         // this bay's Controller
     uint8_t on;
     float   vset, iset;
     // --- presence monitor ---
-    QTimeEvt tick;        // 200 ms tick
+    QTimeEvt tick;        // COTEK_POLL_MS tick
     uint32_t alive_ms;    // ms since last valid reply
+    uint16_t bus_recoveries;
     // last known status (what we publish)
     uint8_t present;
     uint8_t out_on;
     float   v_out, i_out, t_out;
+    // last status actually sent out (change detection)
+    uint8_t last_present, last_out_on;
+    float   last_v, last_i, last_t;
     /* --- startup policy --- */
     uint8_t startup_sync;   /* 1 = we are confirming OFF at boot */
     uint8_t off_acks;       /* consecutive reads showing output OFF */
+    /* --- setpoint ramp --- */
+    QTimeEvt ramp;
+    float    tgt_v, tgt_i;   /* latest request (later requests overwrite) */
+    float    cur_v, cur_i;   /* ramp position actually programmed         */
+    uint16_t wr_v, wr_i;     /* raw values last written to 0x70 / 0x72    */
+    uint8_t  ramping;
+    uint8_t  estop;          /* latched by ESTOP_SIG: no setpoints until release */
 } CotekAO;
 
+/* local helper prototypes (file-local linkage) */
+static void  cotek_set_remote_mode(CotekAO const *me);
+static void  cotek_set_output_voltage(CotekAO const *me, uint16_t raw);
+static void  cotek_set_output_current(CotekAO const *me, uint16_t raw);
+static void  cotek_commit_settings(CotekAO const *me, uint8_t on);
+static void  cotek_power_on(CotekAO const *me);
+static void  cotek_power_off(CotekAO const *me);
+
 static void publish_status(CotekAO *me) {
     CotekStatusEvt *se = Q_NEW(CotekStatusEvt, PSU_RSP_STATUS_SIG);
     se->present = me->present;
@@ -61,7 +114,7 @@ static void publish_status(CotekAO *me) {
     se->v_out   = me->v_out;
     se->i_out   = me->i_out;
     se->t_out  = me->t_out;
-    if (!QACTIVE_POST_X(AO_Controller, &se->super, 0U, &me->super)) {
+    if (!QACTIVE_POST_X(me->ctl, &se->super, 0U, &me->super)) {
         QF_gc(&se->super);
     }
 }
@@ -71,7 +124,9 @@ static void post_psu(const CotekAO *me,
                      uint8_t present, uint8_t output_on,
                      float v_out, float i_out, float temp_C)
 {
-    (void)me;
+    if (App_hmiChannel() != me->ch) {   // panel is showing another bay
+        return;
+    }
     NextionPsuEvt *pe = Q_NEW(NextionPsuEvt, NEX_REQ_UPDATE_PSU_SIG);
     pe->present   = present;
     pe->output_on = output_on;
@@ -87,60 +142,260 @@ static void post_psu(const CotekAO *me,
 static QState Cotek_initial(CotekAO *me, void const *par);
 static QState Cotek_active (CotekAO *me, QEvt const *e);
 
-static CotekAO l_psu;
-QActive *AO_Cotek = &l_psu.super;
+static CotekAO l_psu[APP_NUM_CHANNELS];
+QActive *AO_CotekCh[APP_NUM_CHANNELS];
+QActive *AO_Cotek = &l_psu[0].super;
+
+#ifdef ENABLE_COTEK_EMU
+static void cotek_emu_delay(uint32_t ms) { HAL_Delay(ms); }
+#endif
 
 void CotekAO_ctor(void) {
-    QActive_ctor(&l_psu.super, Q_STATE_CAST(&Cotek_initial));
+    for (uint8_t ch = 0U; ch < APP_NUM_CHANNELS; ++ch) {
+        CotekAO *me = &l_psu[ch];
+        QActive_ctor(&me->super, Q_STATE_CAST(&Cotek_initial));
+        QTimeEvt_ctorX(&me->ramp, &me->super, COTEK_RAMP_SIG, BSP_RATE_BASE);
+        me->ch       = ch;
+        me->i2c_addr = g_appChannels[ch].psu_i2c_addr;
+        AO_CotekCh[ch] = &me->super;
+    }
+#ifdef ENABLE_COTEK_EMU
+    CotekEmuCfg cfg;
+    CotekEmu_defaults(&cfg);
+    cfg.now_ms   = &HAL_GetTick;
+    cfg.delay_ms = &cotek_emu_delay;
+    CotekEmu_init(&cfg);
+#endif
 }
-static uint8_t cotek_read_control(uint8_t *ctrl) {
-    uint8_t reg = 0x7C;
-    if (HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, &reg, 1, I2C_TIMEOUT_MS) != HAL_OK) {
-        return 0U;
+
+/* ===== I2C shim: every transaction to the supply goes through these two ===== */
+#ifdef ENABLE_COTEK_EMU
+/* the emulator models one supply: it answers for bay 0, other bays are absent */
+#define EMU_ABSENT(me_)  ((me_)->ch != 0U)
+static HAL_StatusTypeDef emu_status(CotekEmuStatus st) {
+    return (st == COTEK_EMU_OK)      ? HAL_OK
+         : (st == COTEK_EMU_TIMEOUT) ? HAL_TIMEOUT
+         : (st == COTEK_EMU_BUSY)    ? HAL_BUSY : HAL_ERROR;
+}
+#endif
+
+/* Tripped but ESTOP_SIG not handled yet (it is queued LIFO, so it is this
+ * AO's next event): the step that is running drops its remaining transfers
+ * instead of holding the OFF behind them. */
+static bool cotek_estop_pending(CotekAO const *me) {
+    return Input_estopActive() && (me->estop == 0U);
+}
+
+/* I2C1 is shared by every bay's Cotek AO: under QK a transaction holds the
+ * scheduler up to the highest Cotek priority (BMS still preempts). */
+static HAL_StatusTypeDef cotek_i2c_write(CotekAO const *me, uint8_t *buf, uint16_t len) {
+#ifdef ENABLE_COTEK_EMU
+    if (EMU_ABSENT(me)) return HAL_ERROR;
+#endif
+    if (cotek_estop_pending(me)
+        && !(len == 2U && buf[0] == 0x7CU && (buf[1] & 0x01U) == 0U)) {  /* OFF goes out */
+        return HAL_ERROR;
     }
-    if (HAL_I2C_Master_Receive(&hi2c1, COTEK_I2C_ADDR, rx_data, 1, I2C_TIMEOUT_MS) != HAL_OK) {
-        return 0U;
+    HAL_StatusTypeDef st;
+    APP_LOCK(APP_CEIL_COTEK);
+#ifdef ENABLE_COTEK_EMU
+    st = emu_status(CotekEmu_write(buf, len, I2C_TIMEOUT_MS));
+#else
+    st = HAL_I2C_Master_Transmit(&hi2c1, me->i2c_addr, buf, len, I2C_TIMEOUT_MS);
+#endif
+    APP_UNLOCK();
+    return st;
+}
+
+static HAL_StatusTypeDef cotek_i2c_mem_read(CotekAO const *me, uint8_t reg, uint8_t *buf, uint16_t len) {
+#ifdef ENABLE_COTEK_EMU
+    if (EMU_ABSENT(me)) return HAL_ERROR;
+#endif
+    if (cotek_estop_pending(me)) return HAL_ERROR;
+    HAL_StatusTypeDef st;
+    APP_LOCK(APP_CEIL_COTEK);
+#ifdef ENABLE_COTEK_EMU
+    st = emu_status(CotekEmu_memRead(reg, buf, len, I2C_TIMEOUT_MS));
+#else
+    st = HAL_I2C_Mem_Read(&hi2c1, me->i2c_addr, reg, I2C_MEMADD_SIZE_8BIT,
+                          buf, len, I2C_TIMEOUT_MS);
+#endif
+    APP_UNLOCK();
+    return st;
+}
+
+/* Address + ACK only. HAL_BUSY means the bus is wedged and needs recovery;
+ * a missing supply NACKs within one byte time instead of I2C_TIMEOUT_MS. */
+static HAL_StatusTypeDef cotek_i2c_probe(CotekAO const *me) {
+#ifdef ENABLE_COTEK_EMU
+    if (EMU_ABSENT(me)) return HAL_ERROR;
+#endif
+    if (cotek_estop_pending(me)) return HAL_ERROR;
+    HAL_StatusTypeDef st;
+    APP_LOCK(APP_CEIL_COTEK);
+#ifdef ENABLE_COTEK_EMU
+    CotekEmuStatus const es = CotekEmu_probe();
+    st = (es == COTEK_EMU_BUSY) ? HAL_BUSY : emu_status(es);
+#else
+    if (__HAL_I2C_GET_FLAG(&hi2c1, I2C_FLAG_BUSY)) {
+        st = HAL_BUSY;
+    } else {
+        st = HAL_I2C_IsDeviceReady(&hi2c1, me->i2c_addr, 1U, COTEK_PROBE_TIMEOUT_MS);
     }
-    *ctrl = rx_data[0];
-    return 1U;
+#endif
+    APP_UNLOCK();
+    return st;
 }
-static uint8_t i2c_read_u16(uint8_t reg, uint16_t *out) {
+
+static uint8_t cotek_i2c_recover(void) {
+    uint8_t ok;
+    APP_LOCK(APP_CEIL_COTEK);
+#ifdef ENABLE_COTEK_EMU
+    CotekEmu_recover();
+    ok = 1U;
+#else
+    ok = BSP_i2c1Recover() ? 1U : 0U;
+#endif
+    APP_UNLOCK();
+    return ok;
+}
+
+/* Register pointer write + read of len bytes with a repeated START between them */
+static uint8_t i2c_read_block(CotekAO const *me, uint8_t reg, uint8_t *buf, uint16_t len) {
+    return (cotek_i2c_mem_read(me, reg, buf, len) == HAL_OK) ? 1U : 0U;
+}
+static uint8_t i2c_read_u16(CotekAO const *me, uint8_t reg, uint16_t *out) {
+    uint8_t rx[2];      /* on the stack: Cotek AOs of other bays preempt under QK */
     *out = 0;
-    if (HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, &reg, 1, I2C_TIMEOUT_MS) != HAL_OK) {
+    if (!i2c_read_block(me, reg, rx, 2U)) {
         return 0U;
     }
-    if (HAL_I2C_Master_Receive(&hi2c1, COTEK_I2C_ADDR, rx_data, 2, I2C_TIMEOUT_MS) != HAL_OK) {
+    *out = (uint16_t)((rx[1] << 8) | rx[0]);
+    return 1U;
+}
+static uint8_t i2c_read_u8(CotekAO const *me, uint8_t reg, uint8_t *out) {
+    uint8_t rx;
+    if (!i2c_read_block(me, reg, &rx, 1U)) {
         return 0U;
     }
-    *out = (uint16_t)((rx_data[1] << 8) | rx_data[0]);
+    *out = rx;
     return 1U;
 }
-static uint8_t i2c_read_u8(uint8_t reg, uint8_t *out) {
-    if (HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, &reg, 1, I2C_TIMEOUT_MS) != HAL_OK) {
-        return 0U;
+static uint8_t cotek_read_control(CotekAO const *me, uint8_t *ctrl) {
+    return i2c_read_u8(me, COTEK_REG_CTRL, ctrl);
+}
+
+/* One poll worth of raw telemetry */
+typedef struct {
+    uint16_t rawV, rawI;
+    uint8_t  rawT, ctrl;
+    uint8_t  okV, okI, okT, okC;
+} CotekPoll;
+
+static inline uint8_t in_status_win(uint8_t reg, uint8_t width) {
+    return (reg >= COTEK_STATUS_WIN_FIRST) &&
+           ((uint16_t)reg + width - 1U <= COTEK_STATUS_WIN_LAST);
+}
+
+/* Fetch the status window in one transfer and decode every field from that
+ * buffer; only registers outside the window cost their own transaction. */
+static void cotek_poll(CotekAO const *me, CotekPoll *p) {
+    uint8_t win[COTEK_STATUS_WIN_LEN];
+    memset(p, 0, sizeof(*p));
+    uint8_t const okWin = i2c_read_block(me, COTEK_STATUS_WIN_FIRST, win, (uint16_t)sizeof(win));
+
+#define WIN_AT(reg_) (&win[(reg_) - COTEK_STATUS_WIN_FIRST])
+    if (in_status_win(COTEK_REG_VOUT, 2U)) {
+        if (okWin) { p->rawV = (uint16_t)((WIN_AT(COTEK_REG_VOUT)[1] << 8) | WIN_AT(COTEK_REG_VOUT)[0]); p->okV = 1U; }
+    } else {
+        p->okV = i2c_read_u16(me, COTEK_REG_VOUT, &p->rawV);
     }
-    if (HAL_I2C_Master_Receive(&hi2c1, COTEK_I2C_ADDR, rx_data, 1, I2C_TIMEOUT_MS) != HAL_OK) {
-        return 0U;
+    if (in_status_win(COTEK_REG_IOUT, 2U)) {
+        if (okWin) { p->rawI = (uint16_t)((WIN_AT(COTEK_REG_IOUT)[1] << 8) | WIN_AT(COTEK_REG_IOUT)[0]); p->okI = 1U; }
+    } else {
+        p->okI = i2c_read_u16(me, COTEK_REG_IOUT, &p->rawI);
+    }
+    if (in_status_win(COTEK_REG_TEMP, 1U)) {
+        if (okWin) { p->rawT = *WIN_AT(COTEK_REG_TEMP); p->okT = 1U; }
+    } else {
+        p->okT = i2c_read_u8(me, COTEK_REG_TEMP, &p->rawT);
+    }
+    if (in_status_win(COTEK_REG_CTRL, 1U)) {
+        if (okWin) { p->ctrl = *WIN_AT(COTEK_REG_CTRL); p->okC = 1U; }
+    } else {
+        p->okC = cotek_read_control(me, &p->ctrl);
+    }
+#undef WIN_AT
+}
+
+static inline uint16_t to_raw(float x) {
+    return (x <= 0.0f) ? 0U : (uint16_t)(x * 100.0f + 0.5f);
+}
+
+static inline float step_toward(float cur, float tgt, float max_step) {
+    if (tgt > cur + max_step) return cur + max_step;
+    if (tgt < cur - max_step) return cur - max_step;
+    return tgt;
+}
+
+/* Program (cur_v, cur_i): only registers whose raw value changed are written,
+ * and one commit covers both. Returns 1 if anything went out on the bus. */
+static uint8_t ramp_program(CotekAO * const me) {
+    uint16_t const rv = to_raw(me->cur_v);
+    uint16_t const ri = to_raw(me->cur_i);
+    uint8_t dirty = 0U;
+    if (rv != me->wr_v) { cotek_set_output_voltage(me, rv); me->wr_v = rv; dirty = 1U; }
+    if (ri != me->wr_i) { cotek_set_output_current(me, ri); me->wr_i = ri; dirty = 1U; }
+    if (dirty) {
+        cotek_commit_settings(me, me->on);
+    }
+    return dirty;
+}
+
+/* One slew step toward the latest targets; stops the timer on arrival */
+static void ramp_step(CotekAO * const me) {
+    float const dt = (float)COTEK_RAMP_MS / 1000.0f;
+    me->cur_v = step_toward(me->cur_v, me->tgt_v, COTEK_RAMP_V_PER_S * dt);
+    me->cur_i = step_toward(me->cur_i, me->tgt_i, COTEK_RAMP_A_PER_S * dt);
+    (void)ramp_program(me);
+    if (me->cur_v == me->tgt_v && me->cur_i == me->tgt_i) {
+        QTimeEvt_disarm(&me->ramp);
+        me->ramping = 0U;
     }
-    *out = rx_data[0];
-    return 1U;
+}
+
+static void ramp_reset(CotekAO * const me) {
+    QTimeEvt_disarm(&me->ramp);
+    me->ramping = 0U;
+    me->tgt_v = me->tgt_i = 0.0f;
+    me->cur_v = me->cur_i = 0.0f;
+    me->wr_v  = me->wr_i  = COTEK_RAW_UNKNOWN;
 }
 
 static QState Cotek_initial(CotekAO * const me, void const *par) {
     (void)par;
-    cotek_set_remote_mode();
-    cotek_power_off();
+    me->ctl = AO_ControllerCh[me->ch];   // peers exist once every ctor has run
+    QS_OBJ_ARR_DICTIONARY(&l_psu[me->ch], me->ch);
+    QS_OBJ_ARR_DICTIONARY(&l_psu[me->ch].tick, me->ch);
+    QS_OBJ_ARR_DICTIONARY(&l_psu[me->ch].ramp, me->ch);
+    QS_FUN_DICTIONARY(&Cotek_active);
+    cotek_set_remote_mode(me);
+    cotek_power_off(me);
     me->on = 0U; me->vset = 0.f; me->iset = 0.f;
-    QTimeEvt_ctorX(&me->tick, &me->super, COTEK_TICK_SIG, 0U);
-    // start periodic every 500ms
-    QTimeEvt_armX(&me->tick, 50U, 50U); // assuming 1 tick = 10 ms (adjust to your BSP tick)
-    me->alive_ms = 1000U;   // start as stale
+    QTimeEvt_ctorX(&me->tick, &me->super, COTEK_TICK_SIG, BSP_RATE_BASE);
+    QTimeEvt_armX(&me->tick, (COTEK_POLL_MS * BSP_TICKS_PER_SEC) / 1000U,
+                             (COTEK_POLL_MS * BSP_TICKS_PER_SEC) / 1000U);
+    me->alive_ms = COTEK_STALE_MS;   // start as stale
+    me->bus_recoveries = 0U;
     me->present = 0U;
     me->out_on  = 0U;
     me->v_out = me->i_out = me->t_out = 0.0f;
+    me->last_present = me->last_out_on = 0xFFU;   // first poll always publishes
+    me->last_v = me->last_i = me->last_t = -999.0f;
     /* start in "startup sync": confirm real OFF before we publish “OFF” */
     me->startup_sync = 1U;
     me->off_acks     = 0U;
+    ramp_reset(me);
     return Q_TRAN(&Cotek_active);
 }
 
@@ -149,46 +404,90 @@ static QState Cotek_active(CotekAO * const me, QEvt const * const e)
     switch (e->sig)
     {
             case COTEK_TICK_SIG: {
-                uint16_t rawV = 0, rawI = 0;   uint8_t rawT = 0, ctrl = 0;
-                uint8_t okV = i2c_read_u16(0x60, &rawV);          // V*100
-                uint8_t okI = i2c_read_u16(0x62, &rawI);          // A*100
-                uint8_t okT = i2c_read_u8 (0x68, &rawT);          // °C
-                uint8_t okC = cotek_read_control(&ctrl);          // bit0=ON
+                CotekPoll p;
+                HAL_StatusTypeDef pr = cotek_i2c_probe(me);
+                if (pr == HAL_BUSY) {                             // SDA stuck low
+                    uint8_t const ok = cotek_i2c_recover();
+                    ++me->bus_recoveries;
+                    printf("COTEK: I2C bus recovery #%u %s\r\n",
+                           (unsigned)me->bus_recoveries, ok ? "ok" : "FAILED");
+                    pr = cotek_i2c_probe(me);
+                }
+                if (pr == HAL_OK) {
+                    cotek_poll(me, &p);                               // 0x60..0x68 burst + 0x7C
+                } else {
+                    memset(&p, 0, sizeof(p));                     // absent: no 100 ms reads
+                }
 
-                uint8_t okAny = (okV || okI || okT || okC);
+                QS_BEGIN_ID(BSP_QS_PSU_READ, me->super.prio)
+                    QS_U8(0, me->ch);
+                    QS_U8(QS_HEX_FMT, (uint8_t)(p.okV | (p.okI << 1) | (p.okT << 2) | (p.okC << 3)));
+                    QS_U16(0, p.rawV);                            // 10 mV
+                    QS_U16(0, p.rawI);                            // 10 mA
+                    QS_U8(0, p.rawT);
+                    QS_U8(QS_HEX_FMT, p.ctrl);
+                QS_END()
+                uint8_t okAny = (p.okV || p.okI || p.okT || p.okC);
                 if (okAny) {
                     me->alive_ms = 0U;
-                    if (okV) me->v_out = (float)rawV / 100.0f;
-                    if (okI) me->i_out = (float)rawI / 100.0f;
-                    if (okT) me->t_out = (float)rawT;
-                    if (okC) me->out_on = ((ctrl & 0x01U) != 0U);  // bit0 = output enable
+                    if (p.okV) me->v_out = (float)p.rawV / 100.0f;
+                    if (p.okI) me->i_out = (float)p.rawI / 100.0f;
+                    if (p.okT) me->t_out = (float)p.rawT;
+                    if (p.okC) me->out_on = ((p.ctrl & 0x01U) != 0U);  // bit0 = output enable
                 } else {
-                    if (me->alive_ms < 5000U) { me->alive_ms += 200U; } // 200 ms tick
+                    if (me->alive_ms < 5000U) { me->alive_ms += COTEK_POLL_MS; }
                 }
-                uint8_t new_present = (me->alive_ms <= 1000U) ? 1U : 0U;
+                uint8_t new_present = (me->alive_ms < COTEK_STALE_MS) ? 1U : 0U;
                 me->present = new_present;
 
-                static uint8_t last_present = 0xFFU, last_out_on = 0xFFU;
-                static float   last_v = -999.0f, last_i = -999.0f, last_t = -999.0f;
-
-                if (   (new_present != last_present)
-                    || (me->out_on   != last_out_on)
-                    || (fabsf(last_v - me->v_out) > 0.05f)
-                    || (fabsf(last_i - me->i_out) > 0.05f)
-                    || (fabsf(last_t - me->t_out) > 0.5f)) {
+                if (   (new_present != me->last_present)
+                    || (me->out_on   != me->last_out_on)
+                    || (fabsf(me->last_v - me->v_out) > 0.05f)
+                    || (fabsf(me->last_i - me->i_out) > 0.05f)
+                    || (fabsf(me->last_t - me->t_out) > 0.5f)) {
 
-                    last_present = new_present;
-                    last_out_on  = me->out_on;
-                    last_v       = me->v_out;
-                    last_i       = me->i_out;
-                    last_t       = me->t_out;
+                    me->last_present = new_present;
+                    me->last_out_on  = me->out_on;
+                    me->last_v       = me->v_out;
+                    me->last_i       = me->i_out;
+                    me->last_t       = me->t_out;
 
                     post_psu(me, new_present, me->out_on, me->v_out, me->i_out, me->t_out);
                     publish_status(me);
     }
+#ifdef ENABLE_COTEK_EMU
+                static uint8_t emu_div;
+                if (me->ch == 0U && ++emu_div >= COTEK_EMU_REPORT_TICKS) { emu_div = 0U; CotekEmu_report(); }
+#endif
+                    return Q_HANDLED();
+            }
+            case ESTOP_SIG: {
+                    /* OFF first, bookkeeping after: this is the latency that counts */
+                    cotek_power_off(me);
+                    uint32_t const us = (BSP_cycles() - Input_estopCycles()) / BSP_CYCLES_PER_US;
+                    me->estop = 1U;
+                    me->on = 0U;
+                    ramp_reset(me);
+                    me->startup_sync = 1U;
+                    me->off_acks = 0U;
+                    printf("COTEK%u: E-STOP -> OFF in %lu us\r\n", (unsigned)me->ch, (unsigned long)us);
+                    (void)QACTIVE_POST_X(me->ctl, e, 1U, &me->super);
+                    return Q_HANDLED();
+            }
+            case ESTOP_RELEASE_SIG: {
+                    if (Input_estopActive()) {      /* tripped again meanwhile */
+                        return Q_HANDLED();
+                    }
+                    me->estop = 0U;
+                    printf("COTEK%u: E-STOP released, output stays OFF\r\n", (unsigned)me->ch);
+                    (void)QACTIVE_POST_X(me->ctl, e, 1U, &me->super);
                     return Q_HANDLED();
             }
             case PSU_REQ_SETPOINT_SIG: {
+                    if (me->estop) {
+                        printf("COTEK: IGNORE setpoint (E-STOP)\r\n");
+                        return Q_HANDLED();
+                    }
                     // refuse if not present (prevents programming into a bus error)
                     if (me->present == 0U) {
                         printf("COTEK: IGNORE setpoint (PSU not present)\r\n");
@@ -197,17 +496,33 @@ static QState Cotek_active(CotekAO * const me, QEvt const * const e)
                     PsuSetEvt const *se = Q_EVT_CAST(PsuSetEvt);
                     me->vset = se->voltSet;
                     me->iset = se->currSet;
-                    me->on = 1U;
-                    /* Program the supply over I2C */
-                    cotek_set_remote_mode();
-                    cotek_set_output_voltage(me->vset);
-                    cotek_set_output_current(me->iset);
-                    cotek_commit_settings();
-                    cotek_power_on();
+                    /* Only the targets move here; the ramp tick walks the
+                     * programmed values there, so a burst of requests ends in
+                     * one commit of the latest one. */
+                    me->tgt_v = me->vset;
+                    me->tgt_i = me->iset;
+                    if (me->on) {
+                        if (!me->ramping) {
+                            me->ramping = 1U;
+                            QTimeEvt_armX(&me->ramp, (COTEK_RAMP_MS * BSP_TICKS_PER_SEC) / 1000U,
+                                                     (COTEK_RAMP_MS * BSP_TICKS_PER_SEC) / 1000U);
+                        }
+                        return Q_HANDLED();
+                    }
+                    /* OFF -> ON: start at the pack voltage with zero current
+                     * so there is no inrush, then ramp */
+                    me->on    = 1U;
+                    me->cur_v = (me->v_out > 0.0f && me->v_out < me->tgt_v) ? me->v_out : me->tgt_v;
+                    me->cur_i = 0.0f;
+                    cotek_set_remote_mode(me);
+                    if (!ramp_program(me)) {     // the commit already carries bit0
+                        cotek_power_on(me);
+                    }
                     me->out_on = 1U;
+                    me->ramping = 1U;
+                    QTimeEvt_armX(&me->ramp, (COTEK_RAMP_MS * BSP_TICKS_PER_SEC) / 1000U,
+                                             (COTEK_RAMP_MS * BSP_TICKS_PER_SEC) / 1000U);
 
-
-            printf("COTEK: ON V=%.2f I=%.2f\r\n", me->vset, me->iset);
                     /* Push an immediate UI update so pMain shows PSU group “live” */
                     post_psu(me,
                              /*present=*/1U,
@@ -219,10 +534,15 @@ static QState Cotek_active(CotekAO * const me, QEvt const * const e)
                     printf("COTEK: ON V=%.2f I=%.2f\r\n", me->vset, me->iset);
                     return Q_HANDLED();
             }
+            case COTEK_RAMP_SIG: {
+                    ramp_step(me);
+                    return Q_HANDLED();
+            }
             case PSU_REQ_OFF_SIG: {
                     me->on = 0U;
-                    cotek_set_remote_mode();
-                    cotek_power_off();   /* actively command OFF */
+                    ramp_reset(me);
+                    cotek_set_remote_mode(me);
+                    cotek_power_off(me);   /* actively command OFF */
                     printf("COTEK: OFF\r\n");
                     me->startup_sync = 1U;
                     me->off_acks = 0U;
@@ -235,68 +555,50 @@ static QState Cotek_active(CotekAO * const me, QEvt const * const e)
     }
 
 
-void cotek_set_remote_mode(void) {
+void cotek_set_remote_mode(CotekAO const *me) {
     // Write 0x80 to 0x7C (bit 7 = 1 ? Remote mode)
     uint8_t cmd[2] = {0x7C, 0x80};
-    HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, cmd, 2, I2C_TIMEOUT_MS);
+    (void)cotek_i2c_write(me, cmd, 2);
 }
 
-void cotek_set_output_voltage(float voltage) {
+void cotek_set_output_voltage(CotekAO const *me, uint16_t val) {
     // Voltage * 100 -> hex ? write to 0x70 (LSB), 0x71 (MSB)
-    uint16_t val = (uint16_t)(voltage * 100); // e.g. 24.25 * 100 = 2425 = 0x979
+    // e.g. 24.25 * 100 = 2425 = 0x979
     uint8_t cmd[3] = {0x70, val & 0xFF, (val >> 8)};
-    HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, cmd, 3, I2C_TIMEOUT_MS);
+    (void)cotek_i2c_write(me, cmd, 3);
 }
 
-void cotek_set_output_current(float current) {
+void cotek_set_output_current(CotekAO const *me, uint16_t val) {
     // Current * 100 -> hex ? write to 0x72 (LSB), 0x73 (MSB)
-    uint16_t val = (uint16_t)(current * 100); // e.g. 45.75 * 100 = 4575 = 0x11DF
+    // e.g. 45.75 * 100 = 4575 = 0x11DF
     uint8_t cmd[3] = {0x72, val & 0xFF, (val >> 8)};
-    HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, cmd, 3, I2C_TIMEOUT_MS);
+    (void)cotek_i2c_write(me, cmd, 3);
 }
 
-void cotek_commit_settings() {
+void cotek_commit_settings(CotekAO const *me, uint8_t on) {
     // Write 0x04 to 0x7C (bit 2 = 1 ? update settings)
-    uint8_t cmd[2] = {0x7C, 0x84};  // Bit 7 still set for remote + bit 2 for update
-    HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, cmd, 2, I2C_TIMEOUT_MS);
+    // Bit 7 still set for remote + bit 2 for update; keep bit0 so a commit
+    // while running does not drop the output
+    uint8_t cmd[2] = {0x7C, (uint8_t)(0x84U | (on ? 0x01U : 0x00U))};
+    (void)cotek_i2c_write(me, cmd, 2);
 }
 
-void cotek_power_on() {
+void cotek_power_on(CotekAO const *me) {
     // Write 0x85 to 0x7C (bit 7 = 1 ? remote, bit 0 = 1 ? power ON)
     uint8_t cmd[2] = {0x7C, 0x85};  // Bit7 = Remote, Bit0 = Power ON
-    HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, cmd, 2, I2C_TIMEOUT_MS);
+    (void)cotek_i2c_write(me, cmd, 2);
 }
 
-void cotek_power_off(void) {
+void cotek_power_off(CotekAO const *me) {
     // Remote mode bit set (bit7 = 1), Power bit cleared (bit0 = 0) -> 0x80
     uint8_t cmd[2] = {0x7C, 0x80};
-    HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, cmd, 2, I2C_TIMEOUT_MS);
-}
-
-float cotek_read_voltage() {
-    uint8_t reg = 0x60;
-    HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, &reg, 1, I2C_TIMEOUT_MS);
-    HAL_I2C_Master_Receive(&hi2c1, COTEK_I2C_ADDR, rx_data, 2, I2C_TIMEOUT_MS);
-    uint16_t raw = rx_data[1] << 8 | rx_data[0];
-    return raw / 100.0f;
-}
-
-float cotek_read_current() {
-    uint8_t reg = 0x62;
-    HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, &reg, 1, I2C_TIMEOUT_MS);
-    HAL_I2C_Master_Receive(&hi2c1, COTEK_I2C_ADDR, rx_data, 2, I2C_TIMEOUT_MS);
-    uint16_t raw = rx_data[1] << 8 | rx_data[0];
-    return raw / 100.0f;
-}
-
-float cotek_read_temperature() {
-    uint8_t reg = 0x68;
-    HAL_I2C_Master_Transmit(&hi2c1, COTEK_I2C_ADDR, &reg, 1, I2C_TIMEOUT_MS);
-    HAL_I2C_Master_Receive(&hi2c1, COTEK_I2C_ADDR, rx_data, 1, I2C_TIMEOUT_MS);
-    return rx_data[0];
+    (void)cotek_i2c_write(me, cmd, 2);
 }
 
 // simple health accessor for the controller
+uint8_t Cotek_isPresentCh(uint8_t ch) {
+    return l_psu[ch].present;    // alive in the last ~1s
+}
 uint8_t Cotek_isPresent(void) {
-    return l_psu.present;    // alive in the last ~1s
+    return Cotek_isPresentCh(0U);
 }
@@ -0,0 +1,171 @@
+#include "ao_input.h"
+#include "qpc_cfg.h"
+#include "qpc.h"
+#include "bsp.h"
+#include "inputs.h"
+#include "app_channels.h"
+#include "debug_trace.h"
+#include <stdio.h>
+
+Q_DEFINE_THIS_FILE
+
+extern volatile uint8_t g_lastTag;
+
+#define INPUT_SAMPLE_MS  5U         /* fast-rate ticks between samples */
+
+typedef struct {
+    QActive  super;
+    QTimeEvt sample;
+    Inputs   in;
+    uint8_t  sampling;
+} InputAO;
+
+static QState Input_initial(InputAO * const me, void const * const par);
+static QState Input_active (InputAO * const me, QEvt const * const e);
+
+static InputAO l_input;
+QActive * const AO_Input = &l_input.super;
+
+static volatile uint8_t  s_ready;       /* AO_Input (and every Cotek) started */
+static volatile uint8_t  s_estop;
+static volatile uint32_t s_estop_cyc;
+
+bool     Input_estopActive(void) { return s_estop != 0U; }
+uint32_t Input_estopCycles(void) { return s_estop_cyc; }
+
+/* ========= e-stop ========= */
+/* ISR or AO context. Every Cotek gets the same immutable event at the front
+ * of its queue (LIFO): it is the next thing each Cotek does, ahead of any
+ * queued ticks, ramp steps or setpoints. A full queue asserts. */
+static void estop_trip(void) {
+    static QEvt const estopEvt = QEVT_INITIALIZER(ESTOP_SIG);
+    QF_CRIT_STAT;
+    QF_CRIT_ENTRY();
+    const bool fresh = (s_estop == 0U);
+    s_estop = 1U;
+    QF_CRIT_EXIT();
+    if (!fresh) return;
+    s_estop_cyc = BSP_cycles();
+    for (uint8_t ch = 0U; ch < APP_NUM_CHANNELS; ++ch) {
+        QACTIVE_POST_LIFO(AO_CotekCh[ch], &estopEvt);
+    }
+}
+
+/* A trip from the ISR between the clear and these posts queues ESTOP ahead
+ * of the release; the Cotek then sees Input_estopActive() and ignores it. */
+static void estop_release(void) {
+    static QEvt const relEvt = QEVT_INITIALIZER(ESTOP_RELEASE_SIG);
+    if (s_estop == 0U) return;
+    s_estop = 0U;
+    for (uint8_t ch = 0U; ch < APP_NUM_CHANNELS; ++ch) {
+        (void)QACTIVE_POST_X(AO_CotekCh[ch], &relEvt, 1U, &l_input.super);
+    }
+}
+
+/* ========= ISR side ========= */
+void Input_onEdgeISR(uint16_t pin) {
+    static QEvt const edgeEvt = QEVT_INITIALIZER(INPUT_EDGE_SIG);
+    const uint32_t mask = BSP_inputForPin(pin);
+    if (mask == 0U || !s_ready) return;
+    BSP_inputIrq(mask, false);          /* bounces are the sampler's job now */
+    if ((mask & (1U << BSP_IN_ESTOP)) != 0U &&
+        (BSP_inputLevels() & (1U << BSP_IN_ESTOP)) != 0U) {
+        estop_trip();
+    }
+    (void)QACTIVE_POST_X(AO_Input, &edgeEvt, 1U, 0U);
+}
+
+/* ========= gestures ========= */
+static void on_input(InputEv const *ev) {
+    static QEvt const pressEvt   = QEVT_INITIALIZER(BUTTON_PRESSED_SIG);
+    static QEvt const releaseEvt = QEVT_INITIALIZER(BUTTON_RELEASED_SIG);
+    static QEvt const longEvt    = QEVT_INITIALIZER(BUTTON_LONG_PRESS_SIG);
+
+    if (ev->input == BSP_IN_ESTOP) {
+        if (ev->kind == INPUT_EV_DOWN) estop_trip();    /* missed by the edge ISR */
+        if (ev->kind == INPUT_EV_UP)   estop_release();
+        return;
+    }
+    switch (ev->kind) {                 /* BSP_IN_B1 acts on the bay shown */
+    case INPUT_EV_CLICK:
+        g_lastSig = BUTTON_PRESSED_SIG;  g_lastTag = 1;
+        printf("BTN: PC13 pressed\r\n");
+        (void)QACTIVE_POST_X(App_hmiController(), &pressEvt, 3U, &l_input.super);
+        break;
+    case INPUT_EV_UP:
+        g_lastSig = BUTTON_RELEASED_SIG; g_lastTag = 2;
+        (void)QACTIVE_POST_X(App_hmiController(), &releaseEvt, 3U, &l_input.super);
+        break;
+    case INPUT_EV_LONG:
+        printf("BTN: PC13 long press\r\n");
+        (void)QACTIVE_POST_X(App_hmiController(), &longEvt, 3U, &l_input.super);
+        break;
+    case INPUT_EV_DOUBLE:
+        printf("BTN: PC13 double press\r\n");
+#if APP_NUM_CHANNELS > 1
+        App_hmiSelect((uint8_t)((App_hmiChannel() + 1U) % APP_NUM_CHANNELS));
+#endif
+        break;
+    default:
+        break;
+    }
+}
+
+static void sample_start(InputAO * const me) {
+    if (!me->sampling) {
+        me->sampling = 1U;
+        QTimeEvt_armX(&me->sample, INPUT_SAMPLE_MS, INPUT_SAMPLE_MS);
+    }
+}
+
+/* ========= ctor/state ========= */
+void InputAO_ctor(void) {
+    QActive_ctor(&l_input.super, Q_STATE_CAST(&Input_initial));
+    QTimeEvt_ctorX(&l_input.sample, &l_input.super, INPUT_SAMPLE_SIG, BSP_RATE_FAST);
+}
+
+static QState Input_initial(InputAO * const me, void const * const par) {
+    (void)par;
+    const uint32_t lv = BSP_inputLevels();
+    QS_OBJ_DICTIONARY(&l_input);
+    QS_OBJ_DICTIONARY(&l_input.sample);
+    QS_FUN_DICTIONARY(&Input_active);
+    inputs_init(&me->in, BSP_NUM_INPUTS, 1U << BSP_IN_B1, lv, HAL_GetTick());
+    me->sampling = 0U;
+    if ((lv & (1U << BSP_IN_ESTOP)) != 0U) {
+        printf("INPUT: e-stop open at boot\r\n");
+        estop_trip();
+    }
+    s_ready = 1U;
+    BSP_inputIrq((1U << BSP_NUM_INPUTS) - 1U, true);
+    return Q_TRAN(&Input_active);
+}
+
+static QState Input_active(InputAO * const me, QEvt const * const e) {
+    switch (e->sig) {
+    case INPUT_EDGE_SIG: {
+        sample_start(me);
+        return Q_HANDLED();
+    }
+    case INPUT_SAMPLE_SIG: {
+        InputEv ev[2U * BSP_NUM_INPUTS];
+        const uint8_t n = inputs_sample(&me->in, BSP_inputLevels(), HAL_GetTick(), ev, (uint8_t)Q_DIM(ev));
+        for (uint8_t i = 0U; i < n; ++i) {
+            on_input(&ev[i]);
+        }
+        if (!inputs_busy(&me->in)) {
+            /* settled: back to edges. A change that slipped in while the
+             * lines were masked shows up as raw != stable next sample. */
+            BSP_inputIrq((1U << BSP_NUM_INPUTS) - 1U, true);
+            if ((BSP_inputLevels() ^ inputs_levels(&me->in)) == 0U) {
+                QTimeEvt_disarm(&me->sample);
+                me->sampling = 0U;
+            }
+        }
+        return Q_HANDLED();
+    }
+    default:
+        break;
+    }
+    return Q_SUPER(&QHsm_top);
+}
@@ -3,19 +3,36 @@
 #include "qpc_cfg.h"
 #include "qpc.h"
 #include "stm32f1xx_hal.h"
+#include "bsp.h"
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "app_channels.h"
+#ifdef ENABLE_NEX_EMU
+#include "nex_emu.h"
+#endif
 
 Q_DEFINE_THIS_FILE
 
 extern UART_HandleTypeDef huart3;
-extern QActive * const AO_Controller;
+
+#if APP_NUM_CHANNELS > 1
+#define NEX_BAY_BTN_ID  20U         /* "bBay" touch component (same id on every page) */
+#endif
+
+#define NEX_FAULTS_CLR_BTN_ID  21U  /* "bClear" on pFaults */
+
+#ifdef ENABLE_NEX_EMU
+#define NEX_EMU_REPORT_SEC  5U      /* print emulator counters every 5 s */
+#endif
 
 typedef struct {
     QActive super;
+#ifdef ENABLE_NEX_EMU
+    QTimeEvt emuTick;
+#endif
 } NextionAO;
 
 static QState Nex_initial(NextionAO * const me, QEvt const * const e);
@@ -26,6 +43,9 @@ QActive * const AO_Nextion = &l_nex.super;
 
 /* ========= UART helpers ========= */
 static void nex_send_raw(uint8_t const *buf, uint16_t len) {
+#ifdef ENABLE_NEX_EMU
+    NexEmu_feed(buf, len, HAL_GetTick());   /* same bytes the panel would see */
+#endif
     (void)HAL_UART_Transmit(&huart3, (uint8_t*)buf, len, 20);
 }
 static void nex_send3(char const *s) {
@@ -67,9 +87,23 @@ void Nextion_OnRx(uint8_t const *buf, uint16_t len) {
         uint8_t pid = buf[1];
         NextionPageEvt *pg = Q_NEW(NextionPageEvt, NEX_REQ_SHOW_PAGE_SIG);
         pg->page = pid;
-        (void)QACTIVE_POST_X(AO_Controller, &pg->super, 1U, 0U);
+        if (!QACTIVE_POST_X(App_hmiController(), &pg->super, 1U, 0U)) {
+            QF_gc(&pg->super);
+        }
         return;
     }
+    if (len >= 4 && buf[0] == 0x65 && buf[2] == NEX_FAULTS_CLR_BTN_ID && buf[3] == 0x01) {
+        static QEvt const clrEvt = QEVT_INITIALIZER(FAULT_HIST_CLEAR_SIG);
+        (void)QACTIVE_POST_X(App_hmiController(), &clrEvt, 1U, 0U);
+        return;
+    }
+#if APP_NUM_CHANNELS > 1
+    /* 0x65 page, component, event(1=press): the bay button cycles channels */
+    if (len >= 4 && buf[0] == 0x65 && buf[2] == NEX_BAY_BTN_ID && buf[3] == 0x01) {
+        App_hmiSelect((uint8_t)((App_hmiChannel() + 1U) % APP_NUM_CHANNELS));
+        return;
+    }
+#endif
     if (len >= 5 && buf[0] == 0x71) {
         uint32_t val = (uint32_t)buf[1] | ((uint32_t)buf[2]<<8) |
                        ((uint32_t)buf[3]<<16) | ((uint32_t)buf[4]<<24);
@@ -105,16 +139,31 @@ static uint16_t nex_batt_color(uint16_t code) {
 /* ========= ctor/state ========= */
 void NextionAO_ctor(void) {
     QActive_ctor(&l_nex.super, Q_STATE_CAST(&Nex_initial));
+#ifdef ENABLE_NEX_EMU
+    QTimeEvt_ctorX(&l_nex.emuTick, &l_nex.super, NEX_EMU_TICK_SIG, BSP_RATE_SLOW);
+    NexEmu_init(&Nextion_OnRx);   /* page/touch events come back like real RX */
+#endif
 }
 static QState Nex_initial(NextionAO * const me, QEvt const * const e) {
     (void)me; (void)e;
+    QS_OBJ_DICTIONARY(&l_nex);
+    QS_FUN_DICTIONARY(&Nex_active);
+#ifdef ENABLE_NEX_EMU
+    QS_OBJ_DICTIONARY(&l_nex.emuTick);
+    QTimeEvt_armX(&me->emuTick, NEX_EMU_REPORT_SEC * BSP_SLOW_TICKS_PER_SEC,
+                  NEX_EMU_REPORT_SEC * BSP_SLOW_TICKS_PER_SEC);
+#endif
     return Q_TRAN(&Nex_active);
 }
 static QState Nex_active(NextionAO * const me, QEvt const * const e) {
     (void)me;
     switch (e->sig) {
     case Q_ENTRY_SIG: {
-        if (!QACTIVE_POST_X(AO_Controller, Q_NEW(QEvt, NEX_READY_SIG), 1U, 0U)) { }
+        /* every bay picks its first page; only the shown one paints it */
+        static QEvt const readyEvt = QEVT_INITIALIZER(NEX_READY_SIG);
+        for (uint8_t ch = 0U; ch < APP_NUM_CHANNELS; ++ch) {
+            (void)QACTIVE_POST_X(AO_ControllerCh[ch], &readyEvt, 1U, &me->super);
+        }
         return Q_HANDLED();
     }
     case NEX_REQ_SHOW_PAGE_SIG: {
@@ -128,6 +177,8 @@ static QState Nex_active(NextionAO * const me, QEvt const * const e) {
                 nex_send3("ref pMain.pWarn");
                 break;
             case 3: nex_send3("page pDetails"); break;
+            case 4: nex_send3("page pCells");   break;
+            case 5: nex_send3("page pFaults");  break;
             default: break;
         }
         return Q_HANDLED();
@@ -189,7 +240,8 @@ static QState Nex_active(NextionAO * const me, QEvt const * const e) {
 
         nex_send_textf("pDetails.tHVolt.txt=\"%.2f\"", de->high_voltage_V);
         nex_send_textf("pDetails.tLVolt.txt=\"%.2f\"", de->low_voltage_V);
-        nex_send_textf("pDetails.tAVolt.txt=\"%.2f\"", de->avg_voltage_V);
+        if (de->avg_voltage_V > 0.0f) nex_send_textf("pDetails.tAVolt.txt=\"%.2f\"", de->avg_voltage_V);
+        else                          nex_send_textf("pDetails.tAVolt.txt=\"--\"");
 
         nex_send_textf("pDetails.tHTemp.txt=\"%.1f\"", de->high_temp_C);
         nex_send_textf("pDetails.tLTemp.txt=\"%.1f\"", de->low_temp_C);
@@ -202,12 +254,78 @@ static QState Nex_active(NextionAO * const me, QEvt const * const e) {
         nex_sendf("pDetails.tFanSpeed.txt=\"%u\"", (unsigned)de->fan_speed_rpm);
         nex_sendf("pDetails.tSoC.txt=\"%u%%\"",    (unsigned)de->soc_percent);
         nex_sendf("pDetails.tSoC2.txt=\"%u%%\"",   (unsigned)de->soc2_percent);
+        nex_send_textf("pDetails.tCharged.txt=\"%.2f Ah / %.1f Wh\"",
+                       (double)de->charged_Ah, (double)de->charged_Wh);
+        if (de->ttf_min == 0xFFFFU) {
+            nex_send_textf("pDetails.tTtf.txt=\"--\"");
+        } else {
+            nex_send_textf("pDetails.tTtf.txt=\"%uh%02u\"",
+                           (unsigned)(de->ttf_min / 60U), (unsigned)(de->ttf_min % 60U));
+        }
 
         nex_send_textf("pDetails.tBmsState.txt=\"%s\"", de->bms_state_str);
         nex_send_textf("pDetails.tBmsFault.txt=\"BMS_fault: %s\"", de->bms_fault_str);
         return Q_HANDLED();
     }
 
+    case NEX_REQ_UPDATE_CELLS_SIG: {
+        NextionCellsEvt const *ce = Q_EVT_CAST(NextionCellsEvt);
+
+        nex_send_textf("pCells.tCount.txt=\"%u cells, nodes %u/%u\"",
+                       (unsigned)ce->count, (unsigned)ce->nodes_fresh, (unsigned)ce->nodes_seen);
+        if (ce->count == 0U) {
+            nex_send_textf("pCells.tMin.txt=\"--\"");
+            nex_send_textf("pCells.tMax.txt=\"--\"");
+            nex_send_textf("pCells.tAvg.txt=\"--\"");
+            nex_send_textf("pCells.tSpread.txt=\"--\"");
+        } else {
+            nex_send_textf("pCells.tMin.txt=\"%.3f\"", ce->min_mV / 1000.0);
+            nex_send_textf("pCells.tMax.txt=\"%.3f\"", ce->max_mV / 1000.0);
+            nex_send_textf("pCells.tAvg.txt=\"%.3f\"", ce->avg_mV / 1000.0);
+            nex_send_textf("pCells.tSpread.txt=\"%u mV\"", (unsigned)ce->spread_mV);
+        }
+        nex_sendf("pCells.tSpread.bco=%u", ce->spread_warn ? 63488U : 2016U);
+
+        /* min cell red, max cell amber, the rest black */
+        for (uint8_t k = 0U; k < NEX_CELLS_SHOWN; ++k) {
+            if (k < ce->shown) {
+                const uint16_t mv = ce->cell_mV[k];
+                nex_send_textf("pCells.c%u.txt=\"%.3f\"", (unsigned)k, mv / 1000.0);
+                nex_sendf("pCells.c%u.pco=%u", (unsigned)k,
+                          (mv == ce->min_mV) ? 63488U : (mv == ce->max_mV) ? 64800U : 0U);
+            } else {
+                nex_send_textf("pCells.c%u.txt=\"\"", (unsigned)k);
+            }
+        }
+        return Q_HANDLED();
+    }
+
+    case NEX_REQ_UPDATE_FAULTS_SIG: {
+        NextionFaultsEvt const *fe = Q_EVT_CAST(NextionFaultsEvt);
+
+        nex_send_textf("pFaults.tTotal.txt=\"%u faults seen\"", (unsigned)fe->total);
+        /* row: text, count, first / last seen; active rows red */
+        for (uint8_t k = 0U; k < NEX_FAULT_ROWS; ++k) {
+            if (k < fe->shown) {
+                NextionFaultRow const *r = &fe->row[k];
+                nex_send_textf("pFaults.f%u.txt=\"%s x%u %lum/%lum ago\"", (unsigned)k,
+                               r->text, (unsigned)r->count,
+                               (unsigned long)(r->first_age_s / 60U), (unsigned long)(r->last_age_s / 60U));
+                nex_sendf("pFaults.f%u.pco=%u", (unsigned)k, r->active ? 63488U : 0U);
+            } else {
+                nex_send_textf("pFaults.f%u.txt=\"\"", (unsigned)k);
+            }
+        }
+        return Q_HANDLED();
+    }
+
+#ifdef ENABLE_NEX_EMU
+    case NEX_EMU_TICK_SIG: {
+        NexEmu_report(HAL_GetTick());
+        return Q_HANDLED();
+    }
+#endif
+
     default: break;
     }
     return Q_SUPER(&QHsm_top);
@@ -0,0 +1,59 @@
+// app_channels.c
+#include "app_channels.h"
+#include "app_signals.h"
+#include <stdio.h>
+
+/* Bay table. Single-bay: everything on the bus belongs to channel 0 and the
+ * supply sits at 0x50. For more bays give every pack its own block of J1939
+ * source addresses, wide enough for its slave nodes (400s cell pages carry the
+ * node in the SA byte), and every Cotek its own address. The defaults below
+ * follow that scheme (SA block 0x10 * channel, PSU = 0x50 + channel). */
+#define APP_SA_SPAN  0x10U
+AppChannelCfg const g_appChannels[APP_NUM_CHANNELS] = {
+#if (APP_NUM_CHANNELS == 1U)
+    { 0x00U, 0U,          (0x50U << 1) },
+#else
+    { 0x00U, APP_SA_SPAN, (0x50U << 1) },
+    { 0x10U, APP_SA_SPAN, (0x51U << 1) },
+#if (APP_NUM_CHANNELS > 2U)
+    { 0x20U, APP_SA_SPAN, (0x52U << 1) },
+#endif
+#if (APP_NUM_CHANNELS > 3U)
+    { 0x30U, APP_SA_SPAN, (0x53U << 1) },
+#endif
+#if (APP_NUM_CHANNELS > 4U)
+#error "extend g_appChannels[] for more than 4 bays"
+#endif
+#endif
+};
+
+static volatile uint8_t s_hmiCh = 0U;
+
+uint8_t App_routeCanId(uint32_t raw, uint32_t *id) {
+    const uint8_t sa = (uint8_t)raw;
+    for (uint8_t ch = 0U; ch < APP_NUM_CHANNELS; ++ch) {
+        AppChannelCfg const *c = &g_appChannels[ch];
+        if (c->can_sa_span == 0U) {
+            *id = raw;
+            return ch;
+        }
+        const uint8_t node = (uint8_t)(sa - c->can_sa);
+        if (node < c->can_sa_span) {
+            *id = (raw & ~0xFFu) | node;
+            return ch;
+        }
+    }
+    return APP_NUM_CHANNELS;
+}
+
+uint8_t App_hmiChannel(void) { return s_hmiCh; }
+
+QActive *App_hmiController(void) { return AO_ControllerCh[s_hmiCh]; }
+
+void App_hmiSelect(uint8_t ch) {
+    if (ch >= APP_NUM_CHANNELS || ch == s_hmiCh) return;
+    s_hmiCh = ch;
+    printf("HMI: showing bay %u\r\n", (unsigned)ch);
+    static QEvt const selEvt = QEVT_INITIALIZER(HMI_SELECT_SIG);
+    (void)QACTIVE_POST_X(AO_ControllerCh[ch], &selEvt, 1U, 0U);
+}
@@ -1,6 +1,6 @@
 // batt_classify.c
 #include "batt_classify.h"
-#include <stdio.h>
+#include <math.h>
 #include <string.h>
 #include <stdbool.h>
 
@@ -10,120 +10,185 @@
 #define COL_GREEN   0x07E0u
 #define COL_GREY    0xC618u
 
-static inline float upper_recovery_maxV(void) { return 3.8f; }
-static inline float low_thresh_minV(uint16_t code) {
-    switch (code) {
-    case 0x0600: return 2.0f;
-    case 0x0501: return 2.5f;
-    case 0x0500: return 2.8f;
-    case 0x0402: return 2.5f;
-    case 0x0401: return 2.5f;
-    case 0x0400: return 2.7f;
-    default:     return 0.0f;
-    }
-}
+#define MEMO_SLOTS  4U      /* power of two */
 
-/* NR code tables (sparse; extend as needed) */
-static bool nr_code_600s(uint8_t code) {
-    switch (code) {
-        case 0x01: case 0x02: case 0x03: case 0x04:
-        case 0x05: case 0x06: case 0x07: case 0x08:
-        case 0x09: case 0x0A: case 0x0C: case 0x0D:
-        case 0x11: case 0x12: case 0x25: case 0x30:
-            return true;
-        default: return false;
-    }
-}
-static bool nr_code_500s_BMZ(uint8_t code) {
-    switch (code) {
-        case 0x01: case 0x0C:
-        case 0x05: case 0x34:
-        case 0x06: case 0x32:
-        case 0x08: case 0x2F: case 0x0A: case 0x21:
-        case 0x11: case 0x12: case 0x19:
-            return true;
-        default: return false;
+/* ===== Rules ===== */
+
+/* Not-recoverable error codes, one bit per code (word = code / 32) */
+typedef struct {
+    uint16_t family;        /* battery_type_code */
+    uint32_t nr[8];
+} BattRule;
+
+static const BattRule k_rules[] = {
+    /* 600s: 01-0A, 0C, 0D, 11, 12, 25, 30 */
+    { 0x0600, { [0] = 0x000637FEu, [1] = 0x00010020u } },
+    /* 500s BMZ: 01, 05, 06, 08, 0A, 0C, 11, 12, 19, 21, 2F, 32, 34 */
+    { 0x0501, { [0] = 0x02061562u, [1] = 0x00148002u } },
+    /* 500s Hyperdrive: 01, 02, 05-09, 0C, 0D, 20-22 */
+    { 0x0500, { [0] = 0x000033E6u, [1] = 0x00000007u } },
+    /* 400s: no NR codes known yet */
+    { 0x0402, { 0 } },
+    { 0x0401, { 0 } },
+    { 0x0400, { 0 } },
+};
+#define N_RULES  (sizeof(k_rules) / sizeof(k_rules[0]))
+
+/* Runtime thresholds, same order as k_rules; defaults are the bench values */
+#define SPREAD_MV  ((uint16_t)(BATT_SPREAD_MAX_V * 1000.0f + 0.5f))
+static BattThresholds s_th[N_RULES] = {
+    { 2000U, 3800U, SPREAD_MV },
+    { 2500U, 3800U, SPREAD_MV },
+    { 2800U, 3800U, SPREAD_MV },
+    { 2500U, 3800U, SPREAD_MV },
+    { 2500U, 3800U, SPREAD_MV },
+    { 2700U, 3800U, SPREAD_MV },
+};
+
+/* Outcome per first-set condition bit, highest priority first */
+typedef struct {
+    BattClass   cls;
+    const char *label;
+    BattWhy     why;
+    uint16_t    color565;
+} BattOutcome;
+
+static const BattOutcome k_out[] = {
+    { BATT_CLASS_NOT_RECOVERABLE, "Not Recoverable",      BATT_WHY_NR_CODE,   COL_RED   },
+    { BATT_CLASS_NOT_RECOVERABLE, "Batt Not Recoverable", BATT_WHY_SPREAD,    COL_RED   },
+    { BATT_CLASS_RECOVERABLE,     "Batt Recoverable",     BATT_WHY_IN_WINDOW, COL_AMBER },
+    { BATT_CLASS_OPERATIONAL,     "Batt Operational",     BATT_WHY_ABOVE_MAX, COL_GREEN },
+    { BATT_CLASS_NOT_RECOVERABLE, "Batt Not Recoverable", BATT_WHY_BELOW_MIN, COL_RED   },
+};
+
+static const char *const k_why[BATT_WHY_COUNT] = {
+    [BATT_WHY_SIM]            = "BMS SIM active",
+    [BATT_WHY_NO_DATA]        = "type/V missing",
+    [BATT_WHY_UNKNOWN_FAMILY] = "unknown family",
+    [BATT_WHY_NR_CODE]        = "NR error code",
+    [BATT_WHY_SPREAD]         = "cell spread",
+    [BATT_WHY_IN_WINDOW]      = "min/max in window",
+    [BATT_WHY_ABOVE_MAX]      = "max above window",
+    [BATT_WHY_BELOW_MIN]      = "min below window",
+};
+
+static int rule_index(uint16_t family) {
+    for (unsigned i = 0U; i < N_RULES; ++i) {
+        if (k_rules[i].family == family) return (int)i;
     }
+    return -1;
 }
-static bool nr_code_500s_Hyper(uint8_t code) {
-    switch (code) {
-        case 0x02: case 0x05: case 0x06: case 0x08: case 0x07:
-        case 0x01: case 0x09: case 0x0C: case 0x0D: case 0x20:
-        case 0x21: case 0x22:
-            return true;
-        default: return false;
-    }
+
+/* ===== Evaluation ===== */
+
+typedef struct {
+    uint16_t vmin_q, vmax_q, spread_q;  /* BATT_Q_MV units, spread 0 without cell data */
+    uint8_t  code;
+    uint8_t  rule;
+} BattKey;
+
+typedef struct {
+    BattKey  k;
+    uint8_t  valid;
+    uint8_t  out;                       /* index into k_out */
+} BattMemo;
+
+static BattMemo s_memo[MEMO_SLOTS];
+
+/* To whole mV (the BMS resolution), then to BATT_Q_MV towards the side that
+ * fails the gate: a low cell rounds down, a high cell or a spread rounds up.
+ * With every threshold a multiple of BATT_Q_MV the quantized compare is then
+ * exact, so one memo entry is right for every input it covers. */
+static uint32_t to_mv(float v) {
+    const float mv = v * 1000.0f;
+    return (mv <= 0.0f) ? 0U : (mv >= 655350.0f) ? 655350U : (uint32_t)lrintf(mv);
 }
-static bool nr_code_400s(uint8_t code) { (void)code; return false; }
-
-static bool has_not_recoverable_code(uint16_t type_code, uint8_t err_code) {
-    if (err_code == 0u) return false;
-    switch (type_code) {
-        case 0x0600: return nr_code_600s(err_code);
-        case 0x0501: return nr_code_500s_BMZ(err_code);
-        case 0x0500: return nr_code_500s_Hyper(err_code);
-        case 0x0400: case 0x0401: case 0x0402: return nr_code_400s(err_code);
-        default: return false;
-    }
+static uint16_t quant_floor(float v) { return (uint16_t)(to_mv(v) / BATT_Q_MV); }
+static uint16_t quant_ceil(float v)  { return (uint16_t)((to_mv(v) + BATT_Q_MV - 1U) / BATT_Q_MV); }
+
+/* Every condition is computed, then the first set bit picks the outcome */
+static uint8_t evaluate(BattKey const *k) {
+    const BattRule       *r  = &k_rules[k->rule];
+    const BattThresholds *th = &s_th[k->rule];
+    const uint32_t vmin = (uint32_t)k->vmin_q * BATT_Q_MV;
+    const uint32_t vmax = (uint32_t)k->vmax_q * BATT_Q_MV;
+    const uint32_t spr  = (uint32_t)k->spread_q * BATT_Q_MV;
+
+    const uint32_t nr     = (r->nr[k->code >> 5] >> (k->code & 31U)) & 1U;  /* code 0 never set */
+    const uint32_t spread = (uint32_t)(spr > th->spread_max_mV);
+    const uint32_t in_win = (uint32_t)(vmin >= th->min_mV) & (uint32_t)(vmax <= th->max_mV);
+    const uint32_t above  = (uint32_t)(vmax > th->max_mV);
+
+    const uint32_t m = nr | (spread << 1) | (in_win << 2) | (above << 3) | (1U << 4);
+    return (uint8_t)__builtin_ctz(m);
 }
 
 BattClassResult batt_classify(const BmsTelemetry *t, bool bms_sim_active) {
-    BattClassResult r = { BATT_CLASS_UNKNOWN, "Unknown", "SIM/insufficient data", COL_GREY };
+    BattClassResult r = { BATT_CLASS_UNKNOWN, "Unknown", BATT_WHY_NO_DATA, 0U, COL_GREY };
 
     if (bms_sim_active) {
-        r.reason = "BMS SIM active";
+        r.why = BATT_WHY_SIM;
         return r;
     }
     if (!t) return r;
 
     const uint16_t fam = t->battery_type_code;
-    const float vmin  = t->low_cell_V;
-    const float vmax  = t->high_cell_V;
-
-    if (fam == 0u || vmin <= 0.01f || vmax <= 0.01f) {
-        r.reason = "type/V missing";
+    if (fam == 0u || t->low_cell_V <= 0.01f || t->high_cell_V <= 0.01f) {
         return r;
     }
+    const int rule = rule_index(fam);
+    if (rule < 0) { r.why = BATT_WHY_UNKNOWN_FAMILY; return r; }
 
-    if (has_not_recoverable_code(fam, t->last_error_code)) {
-        r.cls = BATT_CLASS_NOT_RECOVERABLE;
-        r.label = "Not Recoverable";
-        r.color565 = COL_RED;
-        static char why[32];
-        snprintf(why, sizeof(why), "NR error 0x%02X", t->last_error_code);
-        r.reason = why;
-        return r;
+    BattKey k;
+    memset(&k, 0, sizeof(k));           /* padding too: keys are compared with memcmp */
+    k.vmin_q   = quant_floor(t->low_cell_V);
+    k.vmax_q   = quant_ceil(t->high_cell_V);
+    k.spread_q = (t->cell_count >= 2U) ? quant_ceil(t->cell_spread_V) : 0U;
+    k.code     = t->last_error_code;
+    k.rule     = (uint8_t)rule;
+
+    const uint32_t h = ((uint32_t)k.vmin_q * 31U + k.vmax_q) * 2654435761u ^ k.code ^ k.spread_q;
+    BattMemo *mm = &s_memo[(h >> 16) & (MEMO_SLOTS - 1U)];
+    uint8_t out;
+    QF_CRIT_STAT;
+    QF_CRIT_ENTRY();                    /* memo is shared by every bay's Controller */
+    if (!mm->valid || memcmp(&mm->k, &k, sizeof(k)) != 0) {
+        mm->k     = k;
+        mm->out   = evaluate(&k);
+        mm->valid = 1U;
     }
+    out = mm->out;
+    QF_CRIT_EXIT();
 
-    const float low_ok  = low_thresh_minV(fam);
-    const float high_ok = upper_recovery_maxV();
-    if (low_ok <= 0.0f) { r.reason = "unknown family"; return r; }
+    BattOutcome const *o = &k_out[out];
+    r.cls      = o->cls;
+    r.label    = o->label;
+    r.why      = o->why;
+    r.color565 = o->color565;
+    r.nr_code  = (o->why == BATT_WHY_NR_CODE) ? k.code : 0U;
+    return r;
+}
 
-    if ( (vmin >= low_ok) && (vmax <= high_ok) ) {
-        r.cls = BATT_CLASS_RECOVERABLE;
-        r.label = "Batt Recoverable";
-        r.color565 = COL_AMBER;
-        static char why[32]; snprintf(why, sizeof(why), "min>=%.1f & max<=3.8", low_ok);
-        r.reason = why;
-        return r;
-    }
+const char *batt_why_text(BattWhy why) {
+    return ((unsigned)why < BATT_WHY_COUNT) ? k_why[why] : "?";
+}
 
-    if (vmax > high_ok) {
-        r.cls = BATT_CLASS_OPERATIONAL;
-        r.label = "Batt Operational";
-        r.color565 = COL_GREEN;
-        r.reason = "max>3.8";
-        return r;
-    }
+bool batt_classify_get_thresholds(uint16_t family, BattThresholds *out) {
+    const int i = rule_index(family);
+    if (i < 0 || !out) return false;
+    *out = s_th[i];
+    return true;
+}
 
-    r.cls = BATT_CLASS_NOT_RECOVERABLE;
-    r.label = "Batt Not Recoverable";
-    r.color565 = COL_RED;
-    if (vmin < low_ok) {
-        static char why[24]; snprintf(why, sizeof(why), "min<%.1f", low_ok);
-        r.reason = why;
-    } else {
-        r.reason = "out of window";
-    }
-    return r;
+bool batt_classify_set_thresholds(uint16_t family, BattThresholds const *th) {
+    const int i = rule_index(family);
+    if (i < 0 || !th || th->min_mV >= th->max_mV) return false;
+    if (th->min_mV % BATT_Q_MV != 0U || th->max_mV % BATT_Q_MV != 0U
+        || th->spread_max_mV % BATT_Q_MV != 0U) return false;   /* see quant_floor() */
+    QF_CRIT_STAT;
+    QF_CRIT_ENTRY();
+    s_th[i] = *th;
+    memset(s_memo, 0, sizeof(s_memo));  /* results under the old limits are stale */
+    QF_CRIT_EXIT();
+    return true;
 }
@@ -0,0 +1,68 @@
+// bms_cells.c
+#include "bms_cells.h"
+#include <string.h>
+
+void bms_cells_reset(BmsCellMap *m) {
+    memset(m, 0, sizeof(*m));
+    m->min_idx = BMS_CELL_NONE;
+    m->max_idx = BMS_CELL_NONE;
+}
+
+static void rescan(BmsCellMap *m) {
+    m->min_idx = BMS_CELL_NONE;
+    m->max_idx = BMS_CELL_NONE;
+    for (uint8_t i = 0U; i < BMS_MAX_CELLS; ++i) {
+        uint16_t const v = m->mv[i];
+        if (v == 0U) continue;
+        if (m->max_idx == BMS_CELL_NONE || v > m->mv[m->max_idx]) m->max_idx = i;
+        if (m->min_idx == BMS_CELL_NONE || v < m->mv[m->min_idx]) m->min_idx = i;
+    }
+    m->dirty = 0U;
+    ++m->rescans;
+}
+
+void bms_cells_set(BmsCellMap *m, uint8_t idx, uint16_t mv) {
+    if (idx >= BMS_MAX_CELLS) return;
+    uint16_t const old = m->mv[idx];
+    if (old == mv) return;
+
+    m->mv[idx] = mv;
+    m->sum_mv  = m->sum_mv - old + mv;
+    if (old == 0U) ++m->count;
+    if (mv == 0U)  --m->count;
+
+    if (m->dirty) return;            /* rescan pending */
+
+    if (idx == m->max_idx) {
+        if (mv < old) m->dirty = 1U;
+    } else if (mv != 0U && (m->max_idx == BMS_CELL_NONE || mv > m->mv[m->max_idx])) {
+        m->max_idx = idx;
+    }
+    if (idx == m->min_idx) {
+        if (mv > old || mv == 0U) m->dirty = 1U;
+    } else if (mv != 0U && (m->min_idx == BMS_CELL_NONE || mv < m->mv[m->min_idx])) {
+        m->min_idx = idx;
+    }
+}
+
+void bms_cells_clear(BmsCellMap *m, uint8_t first, uint8_t n) {
+    for (uint8_t k = 0U; k < n; ++k) {
+        bms_cells_set(m, (uint8_t)(first + k), 0U);
+    }
+}
+
+bool bms_cells_stats(BmsCellMap *m, BmsCellStats *st) {
+    if (m->dirty) rescan(m);
+    memset(st, 0, sizeof(*st));
+    st->min_idx = st->max_idx = BMS_CELL_NONE;
+    if (m->count == 0U || m->max_idx == BMS_CELL_NONE) return false;
+
+    st->count     = m->count;
+    st->min_idx   = m->min_idx;
+    st->max_idx   = m->max_idx;
+    st->min_mv    = m->mv[m->min_idx];
+    st->max_mv    = m->mv[m->max_idx];
+    st->mean_mv   = (uint16_t)((m->sum_mv + m->count / 2U) / m->count);
+    st->spread_mv = (uint16_t)(st->max_mv - st->min_mv);
+    return true;
+}
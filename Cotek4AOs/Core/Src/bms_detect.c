@@ -0,0 +1,122 @@
+// bms_detect.c
+#include "bms_detect.h"
+#include <stdio.h>
+#include <string.h>
+
+#define W_STRONG   8U    /* ID only this family sends */
+#define W_SIG      4U    /* payload signature on a shared ID */
+#define W_SERIES   1U    /* Vpack / Vcell ratio, before lock only */
+
+static char const *const k_names[BMS_DET_NCAND] = { "600s", "500s HYP", "500s BMZ", "400s" };
+
+static uint16_t code_of(BmsDetect const *d, uint8_t c) {
+    switch (c) {
+        case BMS_DET_600:    return 0x0600U;
+        case BMS_DET_500HYP: return 0x0500U;
+        case BMS_DET_500BMZ: return 0x0501U;
+        case BMS_DET_400:    return d->dual ? 0x0401U : (d->steatite ? 0x0402U : 0x0400U);
+        default:             return 0U;
+    }
+}
+
+void bms_detect_init(BmsDetect *d) {
+    memset(d, 0, sizeof(*d));
+    d->stats.ttl_min_ms = UINT32_MAX;
+}
+
+void bms_detect_reset(BmsDetect *d) {
+    BmsDetectStats const keep = d->stats;
+    memset(d, 0, sizeof(*d));
+    d->stats = keep;
+}
+
+/* credit c; everyone else drains by one so a swapped pack can take over */
+static void credit(BmsDetect *d, uint8_t c, uint8_t w, bool drain) {
+    uint16_t const v = (uint16_t)d->score[c] + w;
+    d->score[c] = (uint8_t)((v > BMS_DET_SCORE_MAX) ? BMS_DET_SCORE_MAX : v);
+    if (!drain) return;
+    for (uint8_t k = 0U; k < BMS_DET_NCAND; ++k) {
+        if (k != c && d->score[k] != 0U) --d->score[k];
+    }
+}
+
+static void on_lock(BmsDetect *d, uint8_t c, uint32_t now_ms) {
+    BmsDetectStats *const st = &d->stats;
+    uint32_t const ttl = now_ms - d->t0_ms;
+    bool const relock = (d->lock != 0U);
+    if (!relock) {
+        ++st->locks;
+        st->ttl_sum_ms += ttl;
+        if (ttl < st->ttl_min_ms) st->ttl_min_ms = ttl;
+        if (ttl > st->ttl_max_ms) st->ttl_max_ms = ttl;
+        if (d->first_guess != 0U && d->first_guess != (uint8_t)(c + 1U)) ++st->wrong_guess;
+    } else {
+        ++st->relocks;
+    }
+    d->lock = (uint8_t)(c + 1U);
+    printf("BMSDET: %slocked %s after %lu ms / %u frames | locks=%lu relocks=%lu wrong-first=%lu "
+           "ttl min/avg/max=%lu/%lu/%lu ms\r\n",
+           relock ? "re-" : "", k_names[c],
+           (unsigned long)ttl, (unsigned)d->frames,
+           (unsigned long)st->locks, (unsigned long)st->relocks,
+           (unsigned long)st->wrong_guess, (unsigned long)st->ttl_min_ms,
+           (unsigned long)(st->ttl_sum_ms / st->locks), (unsigned long)st->ttl_max_ms);
+}
+
+uint16_t bms_detect_feed(BmsDetect *d, BmsEvidence ev, uint32_t now_ms) {
+    if (d->frames == 0U) d->t0_ms = now_ms;
+    if (d->frames < UINT16_MAX) ++d->frames;
+
+    switch (ev) {
+        case BMS_EV_HYP500_ID:    credit(d, BMS_DET_500HYP, W_STRONG, true); break;
+        case BMS_EV_600_SIG:      credit(d, BMS_DET_600,    W_SIG,    true); break;
+        case BMS_EV_BMZ_SIG:      credit(d, BMS_DET_500BMZ, W_SIG,    true); break;
+        case BMS_EV_400_SLAVE:    d->dual = 1U;     credit(d, BMS_DET_400, W_STRONG, true); break;
+        case BMS_EV_400_STEATITE: d->steatite = 1U; credit(d, BMS_DET_400, W_STRONG, true); break;
+        case BMS_EV_400_ID:       credit(d, BMS_DET_400,    W_STRONG, true); break;
+        case BMS_EV_SERIES_16:
+            if (d->lock == 0U) credit(d, BMS_DET_600, W_SERIES, false);
+            break;
+        case BMS_EV_SERIES_14:    /* 500s: whichever subtype has evidence, BMZ if none */
+            if (d->lock == 0U) {
+                credit(d, (d->score[BMS_DET_500HYP] > d->score[BMS_DET_500BMZ])
+                              ? BMS_DET_500HYP : BMS_DET_500BMZ, W_SERIES, false);
+            }
+            break;
+        default: break;
+    }
+
+    uint8_t best = 0U, second = 0U;
+    for (uint8_t k = 1U; k < BMS_DET_NCAND; ++k) {
+        if (d->score[k] > d->score[best]) best = k;
+    }
+    for (uint8_t k = 0U; k < BMS_DET_NCAND; ++k) {
+        if (k != best && d->score[k] > second) second = d->score[k];
+    }
+
+    if (d->score[best] >= BMS_DET_LOCK_SCORE) {
+        if (d->lock == 0U) {
+            if ((uint8_t)(d->score[best] - second) >= BMS_DET_LOCK_MARGIN) on_lock(d, best, now_ms);
+        } else if (best != (uint8_t)(d->lock - 1U)
+                   && d->score[best] >= d->score[d->lock - 1U] + BMS_DET_LOCK_MARGIN) {
+            on_lock(d, best, now_ms);
+        }
+    }
+
+    if (d->lock == 0U && d->first_guess == 0U && d->score[best] != 0U) {
+        d->first_guess = (uint8_t)(best + 1U);
+    }
+    return bms_detect_current(d);
+}
+
+uint16_t bms_detect_current(BmsDetect const *d) {
+    if (d->lock != 0U) return code_of(d, (uint8_t)(d->lock - 1U));
+
+    uint8_t best = 0U;
+    for (uint8_t k = 1U; k < BMS_DET_NCAND; ++k) {
+        if (d->score[k] > d->score[best]) best = k;
+    }
+    return (d->score[best] != 0U) ? code_of(d, best) : 0U;
+}
+
+BmsDetectStats const *bms_detect_stats(BmsDetect const *d) { return &d->stats; }
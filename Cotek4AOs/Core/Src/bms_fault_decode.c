@@ -5,19 +5,98 @@
 #include <string.h>
 #include <stdio.h>
 
-static inline bool bit(uint32_t v, unsigned i){ return (v >> i) & 1U; }
+/* ===== Fault tables =====
+ * One row per bit: text, its length and the severity / domain the bit implies.
+ * Lengths come from sizeof on the literal, so rendering never has to strlen. */
+typedef struct {
+    const char *text;
+    uint8_t     len;
+    uint8_t     sev;    /* BmsSeverity, NONE = bit does not set the severity */
+    uint8_t     dom;    /* BmsDomainMask */
+} BmsFaultBit;
 
-static void append_reason(char *dst, size_t cap, const char *txt) {
-    if (!dst || cap == 0) return;
-    size_t len = strlen(dst);
-    if (len && len < cap-2) { dst[len++] = ','; dst[len++] = ' '; dst[len] = '\0'; }
-    strncat(dst, txt, cap - strlen(dst) - 1);
+#define FB(s, sev, dom)  { (s), (uint8_t)(sizeof(s) - 1U), (uint8_t)(sev), (uint8_t)(dom) }
+
+/* BMZ500 / CP600 pack fault byte */
+static const BmsFaultBit k_bmz_cp600[8] = {
+    FB("Charger current > demand", BMS_SEV_WARNING,  BMS_DOM_CURR),
+    FB("Discharge overcurrent",    BMS_SEV_FAULT,    BMS_DOM_CURR),
+    FB("Under-voltage",            BMS_SEV_FAULT,    BMS_DOM_VOLT),
+    FB("Over-voltage",             BMS_SEV_FAULT,    BMS_DOM_VOLT),
+    FB("Over-temperature",         BMS_SEV_FAULT,    BMS_DOM_TEMP),
+    FB("Under-temperature",        BMS_SEV_FAULT,    BMS_DOM_TEMP),
+    FB("General BMS fault",        BMS_SEV_HW_FAULT, BMS_DOM_OTHER),
+    FB("Voltage imbalance",        BMS_SEV_WARNING,  BMS_DOM_BAL),
+};
+
+/* HYP500 comms HW fault byte; severity comes from the error message */
+static const BmsFaultBit k_hyp500_hw[4] = {
+    FB("I2C ch1 error", BMS_SEV_NONE, BMS_DOM_HWCOMM),
+    FB("I2C ch2 error", BMS_SEV_NONE, BMS_DOM_HWCOMM),
+    FB("CAN bus error", BMS_SEV_NONE, BMS_DOM_HWCOMM),
+    FB("SPI error",     BMS_SEV_NONE, BMS_DOM_HWCOMM),
+};
+
+/* HYP400 flags, packed in BmsHyp400Input field order */
+static const BmsFaultBit k_hyp400[8] = {
+    FB("BMS fault",             BMS_SEV_WARNING,  BMS_DOM_OTHER),
+    FB("Cell undervoltage",     BMS_SEV_FAULT,    BMS_DOM_VOLT),
+    FB("Cell overvoltage",      BMS_SEV_FAULT,    BMS_DOM_VOLT),
+    FB("Discharge overcurrent", BMS_SEV_FAULT,    BMS_DOM_CURR),
+    FB("Charge overcurrent",    BMS_SEV_FAULT,    BMS_DOM_CURR),
+    FB("Pack unbalanced",       BMS_SEV_WARNING,  BMS_DOM_BAL),
+    FB("Node missing",          BMS_SEV_WARNING,  BMS_DOM_NODE),
+    FB("BMS hardware fault",    BMS_SEV_HW_FAULT, BMS_DOM_OTHER),
+};
+
+/* CP400 detail flags, packed in BmsCp400Input field order; severity is the master code */
+static const BmsFaultBit k_cp400[8] = {
+    FB("Under-voltage",         BMS_SEV_NONE, BMS_DOM_VOLT),
+    FB("Over-voltage",          BMS_SEV_NONE, BMS_DOM_VOLT),
+    FB("Over-temperature",      BMS_SEV_NONE, BMS_DOM_TEMP),
+    FB("Under-temperature",     BMS_SEV_NONE, BMS_DOM_TEMP),
+    FB("Discharge overcurrent", BMS_SEV_NONE, BMS_DOM_CURR),
+    FB("Charge overcurrent",    BMS_SEV_NONE, BMS_DOM_CURR),
+    FB("Thermistor warning",    BMS_SEV_NONE, BMS_DOM_TEMP),
+    FB("Voltage imbalance",     BMS_SEV_NONE, BMS_DOM_BAL),
+};
+
+#undef FB
+
+/* ===== Rendering ===== */
+
+/* Append n chars of s at out[len] with a ", " separator; returns the new length */
+static size_t put_text(char *out, size_t cap, size_t len, const char *s, size_t n) {
+    if (!out || cap == 0U) return 0U;
+    if (len != 0U && len + 2U < cap) { out[len++] = ','; out[len++] = ' '; }
+    if (len + n > cap - 1U) n = (len < cap - 1U) ? (cap - 1U - len) : 0U;
+    memcpy(out + len, s, n);
+    len += n;
+    out[len] = '\0';
+    return len;
 }
-static void set_if_empty(char *dst, size_t cap, const char *txt) {
-    if (dst && dst[0] == '\0') {
-        strncpy(dst, txt, cap);
-        if (cap) dst[cap-1] = '\0';
+
+/* Walk the set bits only, lowest first; severity is the worst bit's */
+static size_t put_bits(const BmsFaultBit *tbl, uint32_t mask,
+                       char *out, size_t cap, size_t len,
+                       uint8_t *sev, uint8_t *dom) {
+    while (mask != 0U) {
+        const BmsFaultBit *b = &tbl[__builtin_ctz(mask)];
+        mask &= mask - 1U;
+        len = put_text(out, cap, len, b->text, b->len);
+        if (b->sev > *sev) *sev = b->sev;
+        *dom |= b->dom;
     }
+    return len;
+}
+
+static void put_none_if_empty(char *out, size_t cap, size_t len) {
+    if (len == 0U) (void)put_text(out, cap, 0U, "None", 4U);
+}
+
+static void put_result(uint8_t sev, uint8_t dom, BmsSeverity *out_sev, BmsDomainMask *out_domains) {
+    if (out_sev)     *out_sev = (BmsSeverity)sev;
+    if (out_domains) *out_domains = (BmsDomainMask)dom;
 }
 
 const char* bms_severity_to_text(BmsSeverity sev){
@@ -46,27 +125,10 @@ const char* bms_family_to_text(BmsBatteryFamily fam){
 /* BMZ500 / CP600: 8-bit pack fault */
 void bms_decode_bmz500_cp600(uint8_t f, char *out, size_t cap,
                              BmsSeverity *out_sev, BmsDomainMask *out_domains){
-    if(out) out[0]='\0';
-    if(out_sev) *out_sev = BMS_SEV_NONE;
-    if(out_domains) *out_domains = BMS_DOM_NONE;
-
-    if(bit(f,0)) { append_reason(out,cap,"Charger current > demand"); if(out_domains) *out_domains |= BMS_DOM_CURR; }
-    if(bit(f,1)) { append_reason(out,cap,"Discharge overcurrent");    if(out_domains) *out_domains |= BMS_DOM_CURR; }
-    if(bit(f,2)) { append_reason(out,cap,"Under-voltage");            if(out_domains) *out_domains |= BMS_DOM_VOLT; }
-    if(bit(f,3)) { append_reason(out,cap,"Over-voltage");             if(out_domains) *out_domains |= BMS_DOM_VOLT; }
-    if(bit(f,4)) { append_reason(out,cap,"Over-temperature");         if(out_domains) *out_domains |= BMS_DOM_TEMP; }
-    if(bit(f,5)) { append_reason(out,cap,"Under-temperature");        if(out_domains) *out_domains |= BMS_DOM_TEMP; }
-    if(bit(f,6)) { append_reason(out,cap,"General BMS fault");        if(out_domains) *out_domains |= BMS_DOM_OTHER; }
-    if(bit(f,7)) { append_reason(out,cap,"Voltage imbalance");        if(out_domains) *out_domains |= BMS_DOM_BAL; }
-
-    if(out_sev){
-        if (f == 0) *out_sev = BMS_SEV_NONE;
-        else if (bit(f,6)) *out_sev = BMS_SEV_HW_FAULT;
-        else if (bit(f,3) || bit(f,2) || bit(f,1) || bit(f,4) || bit(f,5)) *out_sev = BMS_SEV_FAULT;
-        else if (bit(f,7) || bit(f,0)) *out_sev = BMS_SEV_WARNING;
-        else *out_sev = BMS_SEV_FAULT;
-    }
-    set_if_empty(out,cap,"None");
+    uint8_t sev = BMS_SEV_NONE, dom = BMS_DOM_NONE;
+    size_t  len = put_bits(k_bmz_cp600, f, out, cap, 0U, &sev, &dom);
+    put_none_if_empty(out, cap, len);
+    put_result(sev, dom, out_sev, out_domains);
 }
 
 /* HYP500 */
@@ -90,23 +152,18 @@ void bms_decode_hyp500(uint8_t hw_fault, uint8_t error_sev_raw, uint8_t error_co
                        char *out, size_t cap,
                        BmsSeverity *out_sev,
                        BmsDomainMask *out_domains){
-    if(out) out[0]='\0';
-    if(out_domains) *out_domains = BMS_DOM_NONE;
-
-    if(bit(hw_fault,0)) { append_reason(out,cap,"I2C ch1 error"); if(out_domains) *out_domains |= BMS_DOM_HWCOMM; }
-    if(bit(hw_fault,1)) { append_reason(out,cap,"I2C ch2 error"); if(out_domains) *out_domains |= BMS_DOM_HWCOMM; }
-    if(bit(hw_fault,2)) { append_reason(out,cap,"CAN bus error"); if(out_domains) *out_domains |= BMS_DOM_HWCOMM; }
-    if(bit(hw_fault,3)) { append_reason(out,cap,"SPI error");     if(out_domains) *out_domains |= BMS_DOM_HWCOMM; }
-
-    BmsSeverity sev = map_hyp500_sev(error_sev_raw);
-    if(out_sev) *out_sev = sev;
+    uint8_t sev = BMS_SEV_NONE, dom = BMS_DOM_NONE;
+    size_t  len = put_bits(k_hyp500_hw, hw_fault & 0x0FU, out, cap, 0U, &sev, &dom);
 
-    char tmp[64];
-    snprintf(tmp, sizeof(tmp), "Severity: %s (0x%02X), Code: 0x%02X",
-             bms_severity_to_text(sev), error_sev_raw, error_code);
-    append_reason(out, cap, tmp);
-
-    set_if_empty(out,cap,"None");
+    sev = (uint8_t)map_hyp500_sev(error_sev_raw);
+    if (out && cap != 0U) {
+        len = put_text(out, cap, len, "", 0U);      /* separator only */
+        if (len < cap) {
+            (void)snprintf(out + len, cap - len, "Severity: %s (0x%02X), Code: 0x%02X",
+                           bms_severity_to_text((BmsSeverity)sev), error_sev_raw, error_code);
+        }
+    }
+    put_result(sev, dom, out_sev, out_domains);
 }
 
 /* HYP400 */
@@ -115,25 +172,14 @@ void bms_decode_hyp400(const BmsHyp400Input *in,
                        BmsSeverity *out_sev,
                        BmsDomainMask *out_domains){
     if(!in) return;
-    if(out) out[0]='\0';
-    if(out_domains) *out_domains = BMS_DOM_NONE;
-
-    if(in->bms_fault)   { append_reason(out,cap,"BMS fault");            if(out_domains) *out_domains |= BMS_DOM_OTHER; }
-    if(in->cell_uv)     { append_reason(out,cap,"Cell undervoltage");    if(out_domains) *out_domains |= BMS_DOM_VOLT; }
-    if(in->cell_ov)     { append_reason(out,cap,"Cell overvoltage");     if(out_domains) *out_domains |= BMS_DOM_VOLT; }
-    if(in->dchg_oc)     { append_reason(out,cap,"Discharge overcurrent");if(out_domains) *out_domains |= BMS_DOM_CURR; }
-    if(in->chg_oc)      { append_reason(out,cap,"Charge overcurrent");   if(out_domains) *out_domains |= BMS_DOM_CURR; }
-    if(in->unbalanced)  { append_reason(out,cap,"Pack unbalanced");      if(out_domains) *out_domains |= BMS_DOM_BAL; }
-    if(in->node_missing){ append_reason(out,cap,"Node missing");         if(out_domains) *out_domains |= BMS_DOM_NODE; }
-    if(in->hw_fault)    { append_reason(out,cap,"BMS hardware fault");   if(out_domains) *out_domains |= BMS_DOM_OTHER; }
-
-    if(out_sev){
-        if(in->hw_fault) *out_sev = BMS_SEV_HW_FAULT;
-        else if (in->cell_uv || in->cell_ov || in->dchg_oc || in->chg_oc) *out_sev = BMS_SEV_FAULT;
-        else if (in->unbalanced || in->node_missing || in->bms_fault) *out_sev = BMS_SEV_WARNING;
-        else *out_sev = BMS_SEV_NONE;
-    }
-    set_if_empty(out,cap,"None");
+    const uint32_t mask = (in->bms_fault    ? 0x01U : 0U) | (in->cell_uv    ? 0x02U : 0U)
+                        | (in->cell_ov      ? 0x04U : 0U) | (in->dchg_oc    ? 0x08U : 0U)
+                        | (in->chg_oc       ? 0x10U : 0U) | (in->unbalanced ? 0x20U : 0U)
+                        | (in->node_missing ? 0x40U : 0U) | (in->hw_fault   ? 0x80U : 0U);
+    uint8_t sev = BMS_SEV_NONE, dom = BMS_DOM_NONE;
+    size_t  len = put_bits(k_hyp400, mask, out, cap, 0U, &sev, &dom);
+    put_none_if_empty(out, cap, len);
+    put_result(sev, dom, out_sev, out_domains);
 }
 
 /* CP400 */
@@ -152,25 +198,41 @@ void bms_decode_cp400(const BmsCp400Input *in,
                       BmsSeverity *out_sev,
                       BmsDomainMask *out_domains){
     if(!in) return;
-    if(out) out[0]='\0';
-    if(out_domains) *out_domains = BMS_DOM_NONE;
-
-    BmsSeverity master = map_cp400_master(in->master_fault_code);
-    char tmp[48];
-    snprintf(tmp,sizeof(tmp),"State: %s (0x%02X)", bms_severity_to_text(master), in->master_fault_code);
-    append_reason(out,cap,tmp);
-
-    if(in->uv)           { append_reason(out,cap,"Under-voltage");        if(out_domains) *out_domains |= BMS_DOM_VOLT; }
-    if(in->ov)           { append_reason(out,cap,"Over-voltage");         if(out_domains) *out_domains |= BMS_DOM_VOLT; }
-    if(in->ot)           { append_reason(out,cap,"Over-temperature");     if(out_domains) *out_domains |= BMS_DOM_TEMP; }
-    if(in->ut)           { append_reason(out,cap,"Under-temperature");    if(out_domains) *out_domains |= BMS_DOM_TEMP; }
-    if(in->dchg_oc)      { append_reason(out,cap,"Discharge overcurrent");if(out_domains) *out_domains |= BMS_DOM_CURR; }
-    if(in->chg_oc)       { append_reason(out,cap,"Charge overcurrent");   if(out_domains) *out_domains |= BMS_DOM_CURR; }
-    if(in->therm_warning){ append_reason(out,cap,"Thermistor warning");   if(out_domains) *out_domains |= BMS_DOM_TEMP; }
-    if(in->imbalance)    { append_reason(out,cap,"Voltage imbalance");    if(out_domains) *out_domains |= BMS_DOM_BAL; }
-
-    if(out_sev) *out_sev = master;
-    set_if_empty(out,cap,"None");
+    const BmsSeverity master = map_cp400_master(in->master_fault_code);
+    size_t len = 0U;
+    if (out && cap != 0U) {
+        const int n = snprintf(out, cap, "State: %s (0x%02X)",
+                               bms_severity_to_text(master), in->master_fault_code);
+        len = (n < 0) ? 0U : ((size_t)n < cap ? (size_t)n : cap - 1U);
+    }
+
+    const uint32_t mask = (in->uv            ? 0x01U : 0U) | (in->ov        ? 0x02U : 0U)
+                        | (in->ot            ? 0x04U : 0U) | (in->ut        ? 0x08U : 0U)
+                        | (in->dchg_oc       ? 0x10U : 0U) | (in->chg_oc    ? 0x20U : 0U)
+                        | (in->therm_warning ? 0x40U : 0U) | (in->imbalance ? 0x80U : 0U);
+    uint8_t sev = BMS_SEV_NONE, dom = BMS_DOM_NONE;
+    (void)put_bits(k_cp400, mask, out, cap, len, &sev, &dom);
+    put_result((uint8_t)master, dom, out_sev, out_domains);
+}
+
+/* ===== Cache ===== */
+
+BmsFaultCacheSlot *bms_fault_cache_slot(BmsFaultCache *c, uint16_t family, uint32_t key, bool *hit) {
+    uint32_t h = (key ^ ((uint32_t)family << 16)) * 2654435761u;
+    BmsFaultCacheSlot *s = &c->slot[(h >> 16) & (BMS_FAULT_CACHE_SLOTS - 1U)];
+    if (s->valid && s->key == key && s->family == family) {
+        ++c->hits;
+        *hit = true;
+        return s;
+    }
+    ++c->misses;
+    s->valid   = 1U;
+    s->family  = family;
+    s->key     = key;
+    s->sev     = BMS_SEV_NONE;
+    s->text[0] = '\0';
+    *hit = false;
+    return s;
 }
 
 /* Single entry */
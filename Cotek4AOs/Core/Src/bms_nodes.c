@@ -0,0 +1,114 @@
+// bms_nodes.c
+#include "bms_nodes.h"
+#include <string.h>
+
+void bms_nodes_reset(BmsNodeTable *t) {
+    memset(t, 0, sizeof(*t));
+    memset(t->slot_of, BMS_NODE_NONE, sizeof(t->slot_of));
+    t->hi_slot = BMS_NODE_NONE;
+    t->lo_slot = BMS_NODE_NONE;
+}
+
+/* node hi/lo over its pages (0 = page not seen) */
+static void node_fold(BmsNode *n) {
+    n->hi_V = 0.0f;
+    n->lo_V = 0.0f;
+    for (uint8_t p = 0U; p < BMS_NODE_PAGES; ++p) {
+        if (n->page_hi[p] > n->hi_V) n->hi_V = n->page_hi[p];
+        if (n->page_lo[p] > 0.0f && (n->lo_V == 0.0f || n->page_lo[p] < n->lo_V)) {
+            n->lo_V = n->page_lo[p];
+        }
+    }
+}
+
+static void rescan(BmsNodeTable *t) {
+    t->hi_slot = BMS_NODE_NONE;
+    t->lo_slot = BMS_NODE_NONE;
+    for (uint8_t s = 0U; s < t->count; ++s) {
+        BmsNode const *n = &t->node[s];
+        if (!n->fresh) continue;
+        if (n->hi_V > 0.0f && (t->hi_slot == BMS_NODE_NONE || n->hi_V > t->node[t->hi_slot].hi_V)) {
+            t->hi_slot = s;
+        }
+        if (n->lo_V > 0.0f && (t->lo_slot == BMS_NODE_NONE || n->lo_V < t->node[t->lo_slot].lo_V)) {
+            t->lo_slot = s;
+        }
+    }
+    t->dirty = 0U;
+    ++t->rescans;
+}
+
+bool bms_nodes_update(BmsNodeTable *t, uint8_t id, uint8_t page,
+                      float hi_V, float lo_V, uint32_t now_ms) {
+    uint8_t s = t->slot_of[id];
+    if (s == BMS_NODE_NONE) {
+        if (t->count >= BMS_MAX_NODES) {
+            ++t->dropped;
+            return false;
+        }
+        s = t->count++;
+        t->slot_of[id] = s;
+        memset(&t->node[s], 0, sizeof(t->node[s]));
+        t->node[s].id = id;
+    }
+    if (page >= BMS_NODE_PAGES) page = BMS_NODE_PAGES - 1U;
+
+    BmsNode *n = &t->node[s];
+    float const old_hi = n->hi_V, old_lo = n->lo_V;
+    n->page_hi[page] = hi_V;
+    n->page_lo[page] = lo_V;
+    node_fold(n);
+    n->fresh   = 1U;
+    n->last_ms = now_ms;
+
+    if (t->dirty) return true;       /* pending rescan will see this node */
+
+    /* owner moving inward may expose another node: defer to the rescan;
+     * anyone else only has to beat the current extreme */
+    if (t->hi_slot == s) {
+        if (n->hi_V < old_hi) t->dirty = 1U;
+    } else if (n->hi_V > 0.0f &&
+               (t->hi_slot == BMS_NODE_NONE || n->hi_V > t->node[t->hi_slot].hi_V)) {
+        t->hi_slot = s;
+    }
+    if (t->lo_slot == s) {
+        if (n->lo_V > old_lo || n->lo_V == 0.0f) t->dirty = 1U;
+    } else if (n->lo_V > 0.0f &&
+               (t->lo_slot == BMS_NODE_NONE || n->lo_V < t->node[t->lo_slot].lo_V)) {
+        t->lo_slot = s;
+    }
+    return true;
+}
+
+uint32_t bms_nodes_age(BmsNodeTable *t, uint32_t now_ms) {
+    uint32_t gone = 0U;
+    for (uint8_t s = 0U; s < t->count; ++s) {
+        BmsNode *n = &t->node[s];
+        if (n->fresh && (now_ms - n->last_ms) > BMS_NODE_STALE_MS) {
+            n->fresh = 0U;
+            gone |= (1UL << s);
+            if (s == t->hi_slot || s == t->lo_slot) t->dirty = 1U;
+        }
+    }
+    return gone;
+}
+
+bool bms_nodes_peek(BmsNodeTable const *t, float *hi_V, float *lo_V) {
+    if (t->dirty || t->hi_slot == BMS_NODE_NONE) return false;
+    *hi_V = t->node[t->hi_slot].hi_V;
+    *lo_V = (t->lo_slot != BMS_NODE_NONE) ? t->node[t->lo_slot].lo_V : 0.0f;
+    return true;
+}
+
+bool bms_nodes_pack(BmsNodeTable *t, float *hi_V, float *lo_V) {
+    if (t->dirty) rescan(t);
+    return bms_nodes_peek(t, hi_V, lo_V);
+}
+
+uint8_t bms_nodes_fresh_count(BmsNodeTable const *t) {
+    uint8_t k = 0U;
+    for (uint8_t s = 0U; s < t->count; ++s) {
+        if (t->node[s].fresh) ++k;
+    }
+    return k;
+}
@@ -0,0 +1,409 @@
+// bms_parse.c
+#include "bms_parse.h"
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+
+/* =============================== ID constants ============================== */
+
+/* 500s Hyperdrive (J1939-like) 0x18FFxx00 pattern and specific PGNs */
+#define ID_500_MASK             0xFFFF00FFu
+#define ID_500_BASE             0x18FF0000u
+#define ID_500_0600             0x18FF0600u  /* authoritative state + Hi/Lo cell (mV) */
+#define ID_500_0700             0x18FF0700u  /* pack V/SOC/current/min-to-full */
+#define ID_500_0800             0x18FF0800u  /* temps */
+#define ID_500_1900             0x18FF1900u  /* node IDs + discharge limit (optional) */
+#define ID_500_0300             0x18FF0300u  /* (legacy/fallback) fault/state; DO NOT use for Hi/Lo */
+#define ID_500_0E00             0x18FF0E00u  /* error */
+#define ID_500_5000             0x18FF5000u  /* fan etc */
+#define ID_500_4000             0x18FF4000u  /* serial/firmware */
+#define ID_500_F000             0x18FFF000u  /* BFG voltage etc (optional) */
+#define ID_500_E000             0x18FFE000u  /* SoC + currents etc */
+
+/* 600s + 500 BMZ extended range 0x100000xx */
+#define ID_EXT_MASK             0xFFFF0000u
+#define ID_EXT_BASE             0x10000000u
+#define ID_EXT_10               0x10000010u
+#define ID_EXT_11               0x10000011u
+#define ID_EXT_20               0x10000020u
+#define ID_EXT_100              0x10000100u
+#define ID_EXT_110              0x10000110u
+#define ID_EXT_50               0x10000050u
+#define ID_EXT_00               0x10000000u
+#define ID_EXT_80               0x10000080u
+#define ID_EXT_90               0x10000090u
+#define ID_EXT_91               0x10000091u
+#define ID_EXT_A0               0x100000A0u
+
+/* 400s family */
+#define ID_400_FAULT            0x18060800u
+#define ID_400_PACK_SOC         0x18070800u
+#define ID_400_TEMPS            0x180C0800u
+#define ID_400_SN_FW            0x18040A00u
+#define ID_400_CELL_A_MASK      0xFFFFFF00u
+#define ID_400_CELL_A_BASE      0x18000800u
+#define ID_400_CELL_B_MASK      0xFFFFFF00u
+#define ID_400_CELL_B_BASE      0x18010800u
+
+
+/* ================================ Thresholds =============================== */
+
+/* Use the range that worked for you on HYP */
+#define CELL_MIN_V              0.80f
+#define CELL_MAX_V              5.00f
+#define PACK_MIN_VALID_V        5.00f
+
+#define SERIES_600_MIN          15   /* inclusive */
+#define SERIES_600_MAX          17
+#define SERIES_500_MIN          13
+#define SERIES_500_MAX          15
+
+/* =========================== Endian helper funcs =========================== */
+
+static inline uint16_t be16(const uint8_t *d) {
+    return (uint16_t)((((uint16_t)d[0]) << 8) | d[1]);
+}
+static inline int16_t be16s(const uint8_t *d) {
+    return (int16_t)((((uint16_t)d[0]) << 8) | d[1]);
+}
+static inline uint32_t be32(const uint8_t *d) {
+    return ((uint32_t)d[0] << 24) | ((uint32_t)d[1] << 16) | ((uint32_t)d[2] << 8) | d[3];
+}
+
+/* ================================ Utilities =================================*/
+
+static inline int roundf_to_int(float x) {
+    return (int)(x >= 0.0f ? x + 0.5f : x - 0.5f);
+}
+
+static inline float accept_cell_mv(uint16_t mv) {
+    if (mv == 0u || mv == 0xFFFFu) return 0.0f;
+    const float v = (float)mv * 0.001f;
+    if (v < CELL_MIN_V || v > CELL_MAX_V) return 0.0f;
+    return v;
+}
+
+static void log_type(uint16_t new_code) {
+    static uint16_t s_last = 0;
+    if (new_code && new_code != s_last) {
+        s_last = new_code;
+        printf("BMS: detected type: %s (0x%04" PRIX16 ")\r\n", bms_type_str(new_code), new_code);
+    }
+}
+
+/* Clear snapshot when family changes (prevents sticky data between families).
+ * A 400s subtype refinement (Dual-Zone / Steatite) keeps the data. */
+static void begin_family(BmsTelemetry *b, uint16_t newcode) {
+    if (b->battery_type_code != newcode) {
+        const bool refine = ((b->battery_type_code & 0xFF00u) == TYPE_400S_HYP)
+                         && ((newcode & 0xFF00u) == TYPE_400S_HYP);
+        if (!refine) memset(b, 0, sizeof(*b));
+        b->battery_type_code = newcode;
+        log_type(newcode);
+    }
+}
+
+/* Feed one piece of evidence; follow whatever the detector now shows */
+static uint8_t detect(BmsDetect *det, BmsTelemetry *b, BmsEvidence ev, uint32_t now_ms) {
+    const uint16_t code = bms_detect_feed(det, ev, now_ms);
+    if (code != 0U && code != b->battery_type_code) {
+        begin_family(b, code);
+        return 1U;
+    }
+    return 0U;
+}
+
+/* Vpack / ~Vcell series count as weak evidence (10 Hz, ignored once locked) */
+uint8_t bms_detect_by_voltage(BmsDetect *det, BmsTelemetry *b, uint32_t now_ms) {
+    if (det->lock) return 0U;
+
+    const float vpack = b->array_voltage_V;
+    const float vhi   = b->high_cell_V;
+    const float vlo   = b->low_cell_V;
+
+    float vcell = 0.0f;
+    const bool hi_ok = (vhi >= CELL_MIN_V && vhi <= CELL_MAX_V);
+    const bool lo_ok = (vlo >= CELL_MIN_V && vlo <= CELL_MAX_V);
+
+    if (hi_ok && lo_ok)      vcell = 0.5f * (vhi + vlo);
+    else if (hi_ok)          vcell = vhi;
+    else if (lo_ok)          vcell = vlo;
+    else                     return 0U;
+
+    if (!(vpack > PACK_MIN_VALID_V)) return 0U;
+
+    const int series = roundf_to_int(vpack / vcell);
+    if (series >= SERIES_600_MIN && series <= SERIES_600_MAX) {
+        return detect(det, b, BMS_EV_SERIES_16, now_ms);
+    }
+    if (series >= SERIES_500_MIN && series <= SERIES_500_MAX) {
+        return detect(det, b, BMS_EV_SERIES_14, now_ms);
+    }
+    return 0U;
+}
+
+/* ============================ Family parsers ============================= */
+
+/* 600s + 500 BMZ “extended” range: 0x100000xx */
+static int parse_ext_100000xx(BmsDetect *det, uint32_t id, uint8_t dlc, const uint8_t *d, BmsTelemetry *b, uint32_t now_ms) {
+    if ((id & ID_EXT_MASK) != ID_EXT_BASE) return 0;
+
+    switch (id) {
+        case ID_EXT_10: {
+            /* common fields */
+            if (dlc >= 4) {
+                const uint16_t v10 = be16(&d[0]);     /* 0.1V */
+                const int16_t  i10 = be16s(&d[2]);    /* 0.1A (signed) */
+                b->array_voltage_V = (float)v10 * 0.1f;
+                b->current_dA      = i10;
+            }
+
+            /* payload signature: the only family evidence on this range, as
+             * both families send the other 0x100000xx frames. d7 is not part
+             * of it (the BMZ capture shows 01 and 05 there). */
+            if (dlc >= 8) {
+                const uint8_t d0 = d[0], d1 = d[1];
+                if (d0==0x01 && (d1==0xC0 || d1==0xC1)) {       /* BMZ: 01 C0|C1 .. */
+                    (void)detect(det, b, BMS_EV_BMZ_SIG, now_ms);
+                } else if (d0==0x02 && d1==0x25) {               /* 600: 02 25 ..    */
+                    (void)detect(det, b, BMS_EV_600_SIG, now_ms);
+                }
+            }
+            return 1;
+        }
+
+        case ID_EXT_11: {
+            /* neutral; some firmwares use mW + zero tail */
+            return 1;
+        }
+
+        /* sent by 600s and 500s BMZ alike (BMS_Simulator captures): data only */
+        case ID_EXT_20:
+        case ID_EXT_100:
+        case ID_EXT_110:
+        case ID_EXT_50:
+        case ID_EXT_00: {
+            if (id == ID_EXT_100 && dlc >= 4) {
+                const float hi = accept_cell_mv(be16(&d[0]));
+                const float lo = accept_cell_mv(be16(&d[2]));
+                if (hi > 0.0f) b->high_cell_V = hi;
+                if (lo > 0.0f) b->low_cell_V  = lo;
+            } else if (id == ID_EXT_110 && dlc >= 4) {
+                b->sys_temp_high_C = (float)be16s(&d[0]) * 0.1f;
+                b->sys_temp_low_C  = (float)be16s(&d[2]) * 0.1f;
+            } else if (id == ID_EXT_20 && dlc >= 4) {
+                b->soc_percent = d[3];
+            }
+            return 1;
+        }
+
+        /* neutral metadata */
+        case ID_EXT_80:
+        case ID_EXT_90:
+        case ID_EXT_91:
+        case ID_EXT_A0: {
+            if (id == ID_EXT_90 && dlc >= 8) {
+                b->serial_number    = be32(&d[0]);
+                b->firmware_version = be32(&d[4]);
+            }
+            return 1;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+/* 500s Hyperdrive (J1939-like): 0x18FFxx00 */
+static int parse_500HYP(BmsDetect *det, uint32_t id, uint8_t dlc, const uint8_t *d, BmsTelemetry *b, uint32_t now_ms) {
+    if ((id & ID_500_MASK) != ID_500_BASE) return 0;
+
+    (void)detect(det, b, BMS_EV_HYP500_ID, now_ms);
+
+    switch (id) {
+        case ID_500_0600: { /* Array state + Hi/Lo cell (1mV/bit each) */
+            if (dlc >= 8) {
+                const uint8_t st = d[2];
+                switch (st) {
+                    case 0: case 1: case 2: case 4: case 8: case 16:
+                        b->bms_state = st; break;
+                    default: break;
+                }
+                const float hi = accept_cell_mv(be16(&d[4]));
+                const float lo = accept_cell_mv(be16(&d[6]));
+                if (hi > 0.0f) b->high_cell_V = hi;
+                if (lo > 0.0f) b->low_cell_V  = lo;
+                if (hi > 0.0f || lo > 0.0f) {
+                    printf("BMS(0600): Hcell=%.3fV Lcell=%.3fV\r\n", b->high_cell_V, b->low_cell_V);
+                }
+            }
+            return 1;
+        }
+
+        case ID_500_0700: { /* pack V (0.1V), SOC %, charger flag, current (A) */
+            if (dlc >= 6) {
+                b->array_voltage_V = (float)be16(&d[0]) * 0.1f;
+                b->soc_percent     = d[2];
+                /* d[3] charger connected (ignored) */
+                b->current_dA      = be16s(&d[4]); /* 1 A/bit, signed */
+            }
+            return 1;
+        }
+
+        case ID_500_0800: { /* temps 0.1C (BE) */
+            if (dlc >= 4) {
+                b->sys_temp_high_C = (float)be16s(&d[0]) * 0.1f;
+                b->sys_temp_low_C  = (float)be16s(&d[2]) * 0.1f;
+            }
+            return 1;
+        }
+
+        case ID_500_1900: { /* optional; ignore for now */
+            return 1;
+        }
+
+        case ID_500_0300: { /* fault + state; DO NOT use for Hi/Lo to avoid conflicts */
+            if (dlc >= 4) {
+                b->bms_fault_raw = d[2];
+                b->bms_fault     = (b->bms_fault_raw != 0U) ? 1U : 0U;
+
+                const uint8_t st = d[3];
+                switch (st) {
+                    case 0: case 1: case 2: case 4: case 8: case 16:
+                        if (b->bms_state == 0) b->bms_state = st; /* keep 0600 priority */
+                        break;
+                    default: break;
+                }
+            }
+            return 1;
+        }
+
+        case ID_500_0E00: { if (dlc >= 2) b->last_error_code = d[1]; return 1; }
+        case ID_500_5000: { return 1; }
+        case ID_500_4000: {
+            if (dlc >= 8) {
+                b->serial_number    = be32(&d[0]);
+                b->firmware_version = be32(&d[4]);
+            }
+            return 1;
+        }
+        case ID_500_F000: { /* optional diag */
+            return 1;
+        }
+        case ID_500_E000: { /* SoC + currents (0.1A) */
+            if (dlc >= 1) {
+                b->soc_percent = d[0];
+            }
+            return 1;
+        }
+        default:
+            return 0;
+    }
+}
+
+/* 400s family (Hyperdrive / Dual-Zone / Steatite) */
+static int parse_400(BmsDetect *det, BmsNodeTable *nt, BmsCellMap *cm, uint32_t id, uint8_t dlc, const uint8_t *d, BmsTelemetry *b, uint32_t now_ms) {
+    const bool is_cell_A = ((id & ID_400_CELL_A_MASK) == ID_400_CELL_A_BASE);
+    const bool is_cell_B = ((id & ID_400_CELL_B_MASK) == ID_400_CELL_B_BASE);
+
+    if (!(id == ID_400_FAULT || id == ID_400_PACK_SOC || id == ID_400_TEMPS ||
+          id == ID_400_SN_FW || is_cell_A || is_cell_B)) {
+        return 0;
+    }
+
+    /* slave cell pages mark Dual-Zone, the SN tail 00 20 marks Steatite */
+    BmsEvidence ev = BMS_EV_400_ID;
+    if ((is_cell_A || is_cell_B) && (id & 0xFFu) == 0x01u) {
+        ev = BMS_EV_400_SLAVE;
+    } else if (id == ID_400_SN_FW && dlc >= 8 && d[6] == 0x00 && d[7] == 0x20) {
+        ev = BMS_EV_400_STEATITE;
+    }
+    (void)detect(det, b, ev, now_ms);
+
+    switch (id) {
+        case ID_400_FAULT: {
+            if (dlc >= 5) {
+                const uint8_t fault = d[0];
+                b->bms_fault     = fault ? 1U : 0U;
+                b->bms_fault_raw = fault;
+
+                const float hi = (float)be16(&d[1]) * 0.0015f;
+                const float lo = (float)be16(&d[3]) * 0.0015f;
+                const float ahi = (hi >= CELL_MIN_V && hi <= CELL_MAX_V) ? hi : 0.0f;
+                const float alo = (lo >= CELL_MIN_V && lo <= CELL_MAX_V) ? lo : 0.0f;
+
+                if (ahi > 0.0f) b->high_cell_V = ahi;
+                if (alo > 0.0f) {
+                    if (b->low_cell_V == 0.0f || alo < b->low_cell_V) b->low_cell_V = alo;
+                }
+                if (ahi > 0.0f || alo > 0.0f) {
+                    printf("BMS(400): Hcell=%.3fV Lcell=%.3fV\r\n", b->high_cell_V, b->low_cell_V);
+                }
+            }
+            return 1;
+        }
+
+        case ID_400_PACK_SOC: {
+            if (dlc >= 3) {
+                b->array_voltage_V = (float)be16(&d[0]) * 0.0012f;
+                b->soc_percent = d[2];
+            }
+            return 1;
+        }
+
+        case ID_400_TEMPS: {
+            if (dlc >= 4) {
+                b->sys_temp_high_C = (float)be16s(&d[0]) * 0.1f;
+                b->sys_temp_low_C  = (float)be16s(&d[2]) * 0.1f;
+            }
+            return 1;
+        }
+
+        case ID_400_SN_FW: {
+            if (dlc >= 6) {
+                b->serial_number    = be32(&d[0]);
+                b->firmware_version = be16(&d[4]);
+            }
+            return 1;
+        }
+
+        default: {
+            /* cell page from master (node 0x00) or a slave (id & 0xFF) */
+            const uint8_t node = (uint8_t)(id & 0xFFu);
+            const uint8_t page = is_cell_B ? 1U : 0U;
+            uint16_t mv[BMS_CELLS_PER_PAGE] = {0};
+            float fhi = 0.0f, flo = 0.0f;
+            for (int i = 0; i + 1 < dlc; i += 2) {
+                const float v = (float)be16(&d[i]) * 0.001f;
+                if (v > CELL_MIN_V && v <= CELL_MAX_V) {
+                    mv[i / 2] = be16(&d[i]);
+                    if (v > fhi) fhi = v;
+                    if (flo == 0.0f || v < flo) flo = v;
+                }
+            }
+            if (fhi > 0.0f && bms_nodes_update(nt, node, page, fhi, flo, now_ms)) {
+                const uint8_t slot = bms_nodes_slot(nt, node);
+                for (uint8_t k = 0U; k < BMS_CELLS_PER_PAGE; ++k) {
+                    bms_cells_set(cm, BMS_CELL_INDEX(slot, page, k), mv[k]);
+                }
+                float hi, lo;
+                if (bms_nodes_peek(nt, &hi, &lo)) {   /* else settled on the next tick */
+                    b->high_cell_V = hi;
+                    b->low_cell_V  = lo;
+                }
+            }
+            return 1;
+        }
+    }
+}
+
+/* ============================== Unified entry ============================== */
+
+int bms_parse_frame(BmsDetect *det, BmsNodeTable *nt, BmsCellMap *cm,
+                    uint32_t id, uint8_t dlc, const uint8_t *d, BmsTelemetry *b, uint32_t now_ms) {
+    if (parse_400(det, nt, cm, id, dlc, d, b, now_ms))    return 1; /* exclusive set of IDs */
+    if (parse_500HYP(det, id, dlc, d, b, now_ms))         return 1; /* 0x18FFxx00 pattern */
+    if (parse_ext_100000xx(det, id, dlc, d, b, now_ms))   return 1; /* 600s + 500BMZ ext */
+
+    return 0;
+}
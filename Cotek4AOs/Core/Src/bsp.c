@@ -7,9 +7,12 @@
 #include <stdio.h> /* for printf() */
 #include "can_app.h"
 #include "ao_controller.h"
+#include "app_channels.h"
 #include "stm32f103xb.h"
 #include "stm32f1xx_hal_rcc.h"
 #include "debug_trace.h"
+#include "ao_input.h"
+#include "batt_classify.h"
 #include "stm32f1xx.h"
 
 // Local-scope defines -----------------------------------------------------
@@ -38,6 +41,9 @@ extern uint8_t s_uart3_rxbuf[128];
 static volatile bool s_qf_started = false;
 extern void StartHmiRx(void);
 extern volatile uint8_t  g_lastTag;
+#ifdef BSP_TICKLESS
+static void tickless_init(void);
+#endif
 
 bool BSP_qfStarted(void) {
     return s_qf_started != 0U;
@@ -47,29 +53,50 @@ void BSP_markQfStarted(void) {
     s_qf_started = true;
 }
 
-/* This is called by HAL from EXTI15_10_IRQHandler() */
+/* This is called by HAL from EXTI15_10_IRQHandler(). Edges count from the
+ * moment AO_Input is started, not QF_run: an e-stop during the boot splash
+ * must still trip. */
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
-    if (!BSP_qfStarted()) {                 // <<< guard like SysTick does
-        __HAL_GPIO_EXTI_CLEAR_IT(GPIO_Pin); // clear any spurious pending
-        return;
+    Input_onEdgeISR(GPIO_Pin);
+}
+
+/* Inputs for AO_Input ------------------------------------------------------*/
+uint32_t BSP_inputLevels(void) {
+    uint32_t m = ((USER_BTN_PORT->IDR & USER_BTN_PIN) != 0U) ? (1U << BSP_IN_B1) : 0U;
+#ifdef ENABLE_ESTOP
+    if ((ESTOP_GPIO_Port->IDR & ESTOP_Pin) != 0U) m |= 1U << BSP_IN_ESTOP;   // loop open
+#endif
+    return m;
+}
+
+static uint32_t input_pins(uint32_t mask) {
+    uint32_t pins = 0U;
+    if ((mask & (1U << BSP_IN_B1)) != 0U) pins |= USER_BTN_PIN;
+#ifdef ENABLE_ESTOP
+    if ((mask & (1U << BSP_IN_ESTOP)) != 0U) pins |= ESTOP_Pin;
+#endif
+    return pins;
+}
+
+uint32_t BSP_inputForPin(uint16_t pin) {
+    uint32_t m = 0U;
+    for (uint_fast8_t i = 0U; i < BSP_NUM_INPUTS; ++i) {
+        if ((input_pins(1U << i) & pin) != 0U) m |= 1U << i;
     }
-    if (GPIO_Pin == GPIO_PIN_13) {
-        __HAL_GPIO_EXTI_CLEAR_IT(GPIO_Pin);
-        // GPIO_PinState s = HAL_GPIO_ReadPin(USER_BTN_PORT, USER_BTN_PIN);
-        // if (s == GPIO_PIN_SET) {
-        //     static QEvt const pressEvt = { .sig = BUTTON_PRESSED_SIG };
-        //     g_lastSig = BUTTON_PRESSED_SIG;  g_lastTag = 3;
-        //     printf("BTN: EXTI PC13 pressed\r\n");
-        //     (void)QACTIVE_POST_X(AO_Controller, &pressEvt, 3U, 0U);
-        //
-        // } else {
-        //     static QEvt const relEvt   = { .sig = BUTTON_RELEASED_SIG };
-        //     g_lastSig = BUTTON_RELEASED_SIG; g_lastTag = 4;
-        //     printf("BTN: EXTI PC13 pressed again\r\n");
-        //     (void)QACTIVE_POST_X(AO_Controller, &relEvt, 3U, 0U);
-        // }
-        return;
+    return m;
+}
+
+void BSP_inputIrq(uint32_t mask, bool on) {
+    uint32_t const pins = input_pins(mask);
+    QF_CRIT_STAT;
+    QF_CRIT_ENTRY();
+    if (on) {
+        EXTI->PR   = pins;                  // drop edges seen while masked
+        EXTI->IMR |= pins;
+    } else {
+        EXTI->IMR &= ~pins;
     }
+    QF_CRIT_EXIT();
 }
 // ------------ LED on PA5 (change if needed) ------------
 static void led_init_once(void) {
@@ -106,10 +133,14 @@ static void uart2_raw_puts(const char *s) {
 void BSP_breadcrumb(uint8_t tag) {
     led_init_once();
     led_toggle();            // visual tick
+#ifdef Q_SPY
+    (void)tag;               // USART2 belongs to QS
+#else
     if (USART2->CR1 & USART_CR1_UE) {
         // if USART2 is enabled, try to drop a single raw tag
         uart2_raw_putc((char)tag);
     }
+#endif
 }
 
 // ------------ Fatal blinker ------------
@@ -158,6 +189,15 @@ void BSP_dumpIRQs(void) {
            (long)NVIC_GetPriority(USB_LP_CAN1_RX0_IRQn));
 }
 
+// DWT cycle counter: BSP_cycles() and the QS time stamps
+static void cycles_start(void) {
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0U;
+        DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+}
+
 void QF_onStartup(void) {
     // bsp.c :: QF_onStartup()
     HAL_NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);
@@ -178,6 +218,13 @@ void QF_onStartup(void) {
     // **Important change**: SysTick must also be kernel-aware (same threshold)
     HAL_NVIC_SetPriority(SysTick_IRQn, QF_AWARE_ISR_CMSIS_PRI, 0);
 
+    // cycle counter for latency stamps (BSP_cycles); already running under Q_SPY
+    cycles_start();
+
+#ifdef BSP_TICKLESS
+    tickless_init();
+#endif
+
     // Now it’s safe to start HMI RX (IRQ won’t preempt critical sections incorrectly)
     StartHmiRx();
     BSP_markQfStarted();
@@ -188,6 +235,9 @@ void QF_onCleanup(void) {
 }
 
 int __io_putchar(int ch) {
+#ifdef Q_SPY
+    return ch;      // USART2 carries QS records: printf goes nowhere
+#endif
     // Only send if USART2 is enabled (avoid spurious writes before init)
     if ((USART2->CR1 & USART_CR1_UE) == 0U) {
         return ch;
@@ -230,66 +280,473 @@ void assert_failed(char const * const module, int_t const id) {
 
 
 // ISRs  ======================================================================
+#ifdef Q_SPY
+static QSpyId const l_SysTick_Handler = { 0U };  // sender of the QF ticks
+#endif
+
+/* ms per tick of each QF tick rate (bsp.h) */
+static uint8_t const k_rate_ms[BSP_NUM_RATES] = {
+    [BSP_RATE_BASE] = 1000U / BSP_TICKS_PER_SEC,
+    [BSP_RATE_FAST] = 1000U / BSP_FAST_TICKS_PER_SEC,
+    [BSP_RATE_SLOW] = 1000U / BSP_SLOW_TICKS_PER_SEC,
+};
+static uint16_t q_tick_div[BSP_NUM_RATES];  /* ms into the current tick of each rate */
+
+#ifdef BSP_TICKLESS
+/* SysTick stretched over several ms while idle. The period is programmed so
+ * that the ms boundaries stay where they would have been: the first one is
+ * rem0 cycles into the stretch, then one every cyc_per_ms. */
+static struct {
+    uint32_t ms;            /* ms boundaries covered by the stretch, 0 = none */
+    uint32_t credited;      /* of those, already added to uwTick (early wake) */
+    uint32_t rem0;
+    uint32_t load;
+    uint32_t cyc_per_ms;
+    uint32_t max_ms;        /* 24-bit SysTick limit */
+} s_tl;
+
+static void tickless_init(void) {
+    s_tl.cyc_per_ms = SysTick->LOAD + 1U;               /* as set up by HAL_InitTick */
+    s_tl.max_ms     = (SysTick_LOAD_RELOAD_Msk + 1U) / s_tl.cyc_per_ms;
+    DBGMCU->CR     |= DBGMCU_CR_DBG_SLEEP;              /* debugger stays attached in WFI */
+}
+
+/* SysTick ended a stretch: credit the remaining ms, back to 1 ms periods.
+ * Returns the ms to feed to the QF tick dividers. */
+static uint32_t tickless_resume(void) {
+    uint32_t const ms = s_tl.ms;
+    uwTick += ms - 1U - s_tl.credited;  /* HAL_IncTick() adds the last one */
+    s_tl.ms       = 0U;
+    s_tl.credited = 0U;
+    SysTick->LOAD = s_tl.cyc_per_ms - 1U;
+    SysTick->VAL  = 0U;                 /* reload now, not after the old period */
+    return ms;
+}
+#endif
+
 void SysTick_Handler(void) {
+    BSP_ISR_ENTRY();
+    uint32_t ms = 1U;
+#ifdef BSP_TICKLESS
+    if (s_tl.ms != 0U) {
+        ms = tickless_resume();
+    }
+#endif
     /* HAL tick must always run */
     HAL_IncTick();
 
     if (s_qf_started) {
-        /* QP time events */
-        static uint8_t q_tick_div;
-        if (++q_tick_div >= 10) {   // 1000 Hz / 10 = 100 Hz
-            q_tick_div = 0;
-            QTIMEEVT_TICK_X(0U, &l_SysTick_Handler);
+        /* QP time events, one list per rate; an empty list only keeps its phase */
+        for (uint_fast8_t r = 0U; r < BSP_NUM_RATES; ++r) {
+            uint32_t div = q_tick_div[r] + ms;
+            if (QTimeEvt_noActive(r)) {
+                div %= k_rate_ms[r];
             }
-
-        /* Button debounce + posts ONLY after kernel started */
-        static struct {
-            uint32_t depressed;
-            uint32_t previous;
-        } buttons = { 0U, 0U };
-
-        uint32_t current = GPIOC->IDR;
-        uint32_t tmp = buttons.depressed;
-        buttons.depressed |= (buttons.previous & current);
-        buttons.depressed &= (buttons.previous | current);
-        buttons.previous   = current;
-        tmp ^= buttons.depressed;
-        current = buttons.depressed;
-        static uint32_t warmup = 200U; // ~200 ms at 1 kHz
-        if (warmup) { --warmup; return; }
-        if ((tmp & (1U << B1_PIN)) != 0U) {
-            if ((current & (1U << B1_PIN)) != 0U) {
-                static QEvt const pressEvt = QEVT_INITIALIZER(BUTTON_PRESSED_SIG);
-                g_lastSig = BUTTON_PRESSED_SIG;  g_lastTag = 1;  // tag 1 = SysTick press
-                QACTIVE_POST_X(AO_Controller, &pressEvt, 3U, 0U);
-                printf("BTN: PC13 pressed\r\n");
-            } else {
-                static QEvt const releaseEvt = QEVT_INITIALIZER(BUTTON_RELEASED_SIG);
-                g_lastSig = BUTTON_RELEASED_SIG; g_lastTag = 2; // tag 2 = SysTick release
-                QACTIVE_POST_X(AO_Controller, &releaseEvt, 3U, 0U);
+            for (; div >= k_rate_ms[r]; div -= k_rate_ms[r]) {
+                QTIMEEVT_TICK_X(r, &l_SysTick_Handler);
             }
+            q_tick_div[r] = (uint16_t)div;
         }
     }
+    BSP_ISR_EXIT();
+}
+
+/* Idle ======================================================================*/
+/* Sleep statistics for BSP_idleStats() */
+static struct {
+    uint32_t wakeups;
+    uint32_t idle_cyc;
+    uint32_t t0;            /* start of the window (CYCCNT) */
+    uint32_t max_ms;        /* longest stretch in the window */
+} s_idle;
+
+#ifdef BSP_TICKLESS
+/* Ticks to the nearest armed time event at one rate, UINT32_MAX when none.
+ * Both the main list and the newly armed list (linked from .act) count. */
+static uint32_t next_timeout_ticks(uint_fast8_t rate) {
+    QTimeEvt const *const head = &QTimeEvt_timeEvtHead_[rate];
+    uint32_t best = UINT32_MAX;
+    for (QTimeEvt const *t = head->next; t != (QTimeEvt *)0; t = t->next) {
+        if (t->ctr != 0U && t->ctr < best) best = t->ctr;
+    }
+    for (QTimeEvt const *t = (QTimeEvt const *)head->act; t != (QTimeEvt *)0; t = t->next) {
+        if (t->ctr != 0U && t->ctr < best) best = t->ctr;
+    }
+    return best;
+}
+
+/* How many ms SysTick may skip; 0 = keep the 1 ms tick */
+static uint32_t stretch_budget(void) {
+    if (!s_qf_started || s_tl.ms != 0U) return 0U;
+    uint32_t const cap = (s_tl.max_ms < BSP_TICKLESS_MAX_MS) ? s_tl.max_ms : BSP_TICKLESS_MAX_MS;
+    uint32_t ms = cap;
+    for (uint_fast8_t r = 0U; r < BSP_NUM_RATES; ++r) {
+        uint32_t ticks = next_timeout_ticks(r);
+        if (ticks > cap) ticks = cap;   /* every tick is >= 1 ms, so this cannot overflow */
+        uint32_t const due = (k_rate_ms[r] - q_tick_div[r]) + (ticks - 1U) * k_rate_ms[r];
+        if (due < ms) ms = due;
+    }
+    return (ms >= 2U) ? ms : 0U;
+}
+
+static bool stretch_begin(uint32_t ms) {
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    uint32_t const rem = SysTick->VAL;  /* left of the current ms */
+    if (rem == 0U || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U) {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;   /* tick due anyway */
+        return false;
+    }
+    s_tl.rem0     = rem;
+    s_tl.load     = rem + (ms - 1U) * s_tl.cyc_per_ms - 1U;
+    s_tl.ms       = ms;
+    s_tl.credited = 0U;
+    SysTick->LOAD = s_tl.load;
+    SysTick->VAL  = 0U;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    return true;
+}
+
+/* Woken before the stretch ran out (CAN, UART, EXTI): credit the whole ms
+ * that passed and let SysTick fire on the next ms boundary, which then
+ * closes the stretch in tickless_resume(). QF ticks are left to that
+ * SysTick, as posting from here could activate AOs under QK. */
+static void stretch_end(void) {
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) == 0U) {
+        uint32_t const c = s_tl.load - SysTick->VAL;
+        uint32_t const n = (c < s_tl.rem0) ? 0U : 1U + (c - s_tl.rem0) / s_tl.cyc_per_ms;
+        uint32_t next = s_tl.rem0 + n * s_tl.cyc_per_ms - c;
+        if (next < 2U) next = 2U;
+        uwTick       += n;
+        s_tl.credited = n;
+        s_tl.ms       = n + 1U;
+        SysTick->LOAD = next - 1U;
+        SysTick->VAL  = 0U;
+    }
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+}
+#endif /* BSP_TICKLESS */
+
+/* Entered with QF interrupts disabled, leaves them enabled. PRIMASK is held
+ * across WFI, so the waking ISR only runs after the tick has been repaired. */
+static void idle_sleep(void) {
+    __disable_irq();
+    QF_INT_ENABLE();
+#ifdef BSP_TICKLESS
+    uint32_t const ms = stretch_budget();
+    bool const stretched = (ms != 0U) && stretch_begin(ms);
+    if (stretched && ms > s_idle.max_ms) s_idle.max_ms = ms;
+#endif
+    uint32_t const t0 = BSP_cycles();
+    __DSB();
+    __WFI();
+    __ISB();
+    s_idle.idle_cyc += BSP_cycles() - t0;
+    ++s_idle.wakeups;
+#ifdef BSP_TICKLESS
+    if (stretched) {
+        stretch_end();
+    }
+#endif
+    __enable_irq();
+}
+
+void BSP_idleStats(BspIdleStats *out) {
+    QF_CRIT_STAT;
+    QF_CRIT_ENTRY();
+    uint32_t const now  = BSP_cycles();
+    uint32_t const span = now - s_idle.t0;
+    uint32_t const us   = span / BSP_CYCLES_PER_US;
+    out->wakeups_per_s = (us != 0U) ? (uint32_t)((uint64_t)s_idle.wakeups * 1000000U / us) : 0U;
+    out->idle_pct      = (span != 0U) ? (uint8_t)((uint64_t)s_idle.idle_cyc * 100U / span) : 0U;
+    out->max_sleep_ms  = s_idle.max_ms;
+    s_idle.wakeups  = 0U;
+    s_idle.idle_cyc = 0U;
+    s_idle.max_ms   = 0U;
+    s_idle.t0       = now;
+    QF_CRIT_EXIT();
+}
+
+/* Housekeeping report ======================================================*/
+/* BSP diagnostics, printed from the idle loop every BSP_REPORT_MS so that no
+ * AO has to carry them. Not in Q_SPY builds, where printf is dropped. */
+#ifndef Q_SPY
+#ifndef BSP_REPORT_MS
+#define BSP_REPORT_MS  10000U   /* < 59 s, see BSP_idleStats() */
+#endif
+
+static uint32_t s_report_ms;
+
+static bool report_due(void) {
+    uint32_t const now = HAL_GetTick();
+    if ((now - s_report_ms) < BSP_REPORT_MS) return false;
+    s_report_ms = now;
+    return true;
+}
+
+static void report(void) {
+    BspIdleStats is;
+    BSP_idleStats(&is);
+    printf("BSP: idle %u%%, %lu wakeups/s, longest sleep %lu ms\r\n",
+           (unsigned)is.idle_pct, (unsigned long)is.wakeups_per_s,
+           (unsigned long)is.max_sleep_ms);
+    /* low-water marks: how close a Q_NEW has come to asserting */
+    printf("BSP: pool min free");
+    for (uint_fast8_t p = 1U; p <= BSP_NUM_POOLS; ++p) {
+        printf(" %u", (unsigned)QF_getPoolMin(p));
+    }
+    printf(" (by block size)\r\n");
+}
+#endif /* Q_SPY */
+
+/* QS software tracing ======================================================*/
+#ifdef Q_SPY
+/* Records leave by DMA1 channel 7 (USART2 TX) in bursts started from idle;
+ * a burst is handed over with QS_getBlock() and sent in place. Only a QS
+ * buffer overrun can reuse bytes still in flight, and that already drops
+ * records, which QSPY reports from the sequence numbers. */
+#define QS_TX_BUF_SIZE   1024U
+#define QS_RX_BUF_SIZE     64U
+#define QS_TX_BURST_MAX   128U      /* bounds the wait in QS_onFlush() */
+
+static bool qs_tx_busy(void) {
+    return ((DMA1_Channel7->CCR & DMA_CCR_EN) != 0U) && (DMA1_Channel7->CNDTR != 0U);
 }
 
+/* Interrupts disabled: start the next burst once the last one is out */
+static void qs_tx_dma(void) {
+    if (qs_tx_busy()) return;
+    uint16_t n = QS_TX_BURST_MAX;
+    uint8_t const *block = QS_getBlock(&n);
+    if (block == (uint8_t const *)0) return;
+    DMA1_Channel7->CCR  &= ~DMA_CCR_EN;
+    DMA1->IFCR           = DMA_IFCR_CGIF7;
+    DMA1_Channel7->CMAR  = (uint32_t)block;
+    DMA1_Channel7->CNDTR = n;
+    DMA1_Channel7->CCR  |= DMA_CCR_EN;
+}
+
+/* Only here to end WFI when a burst is done, so idle can start the next */
+void DMA1_Channel7_IRQHandler(void) {
+    DMA1->IFCR = DMA_IFCR_CGIF7;
+}
+
+/* From USART2_IRQHandler(): QSPY commands into the QS receive buffer.
+ * Reading DR also clears IDLE / ORE left by the HAL receive setup. */
+void BSP_qsUart2Isr(void) {
+    uint32_t const sr = USART2->SR;
+    if ((sr & (USART_SR_RXNE | USART_SR_IDLE | USART_SR_ORE)) != 0U) {
+        uint8_t const b = (uint8_t)USART2->DR;
+        if ((sr & USART_SR_RXNE) != 0U) {
+            QS_RX_PUT(b);
+        }
+    }
+}
+
+/* Idle part of QS, interrupts disabled on entry and exit */
+static void qs_idle(void) {
+    qs_tx_dma();
+    QF_INT_ENABLE();
+    QS_rxParse();
+    QF_INT_DISABLE();
+}
+
+/* Called from main() once USART2 is up */
+uint8_t QS_onStartup(void const *arg) {
+    static uint8_t qsTxBuf[QS_TX_BUF_SIZE];
+    static uint8_t qsRxBuf[QS_RX_BUF_SIZE];
+    (void)arg;
+    QS_initBuf(qsTxBuf, sizeof(qsTxBuf));
+    QS_rxInitBuf(qsRxBuf, sizeof(qsRxBuf));
+    cycles_start();
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    DMA1_Channel7->CCR  = 0U;
+    DMA1_Channel7->CPAR = (uint32_t)&USART2->DR;
+    DMA1_Channel7->CCR  = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_TCIE;  /* 8-bit mem -> DR */
+    USART2->CR3        |= USART_CR3_DMAT;
+    HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, QF_AWARE_ISR_CMSIS_PRI, 0U);
+    HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
+
+    /* state machines, AO queues and the user records; QSPY can widen this */
+    QS_GLB_FILTER(QS_SM_RECORDS);
+    QS_GLB_FILTER(QS_AO_RECORDS);
+    QS_GLB_FILTER(QS_UA_RECORDS);
+    QS_OBJ_DICTIONARY(&l_SysTick_Handler);
+    QS_USR_DICTIONARY(BSP_QS_CAN_RX);
+    QS_USR_DICTIONARY(BSP_QS_PSU_READ);
+    QS_ENUM_DICTIONARY(BSP_QS_CMD_THRESHOLDS, QS_CMD);
+    return 1U;
+}
+
+void QS_onCleanup(void) {
+}
+
+/* Drain everything by polling (assertions, QSPY requests); leaves PRIMASK
+ * alone so it also works from Q_onError() */
+void QS_onFlush(void) {
+    while (qs_tx_busy()) { }
+    for (;;) {
+        uint16_t n = QS_TX_BURST_MAX;
+        QF_CRIT_STAT;
+        QF_CRIT_ENTRY();
+        uint8_t const *block = QS_getBlock(&n);
+        QF_CRIT_EXIT();
+        if (block == (uint8_t const *)0) break;
+        while (n-- != 0U) {
+            uart2_raw_putc((char)*block++);
+        }
+    }
+    while ((USART2->SR & USART_SR_TC) == 0U) { }
+}
+
+#ifndef Q_UTEST   /* qutest.c has its own: one count per record */
+QSTimeCtr QS_onGetTime(void) {
+    return BSP_cycles();
+}
+#endif
+
+void QS_onReset(void) {
+    NVIC_SystemReset();
+}
+
+/* Runs in the idle loop (QS_rxParse); a rejected set leaves the table as is */
+void QS_onCommand(uint8_t cmdId, uint32_t param1, uint32_t param2, uint32_t param3) {
+    switch (cmdId) {
+        case BSP_QS_CMD_THRESHOLDS: {
+            BattThresholds const th = { (uint16_t)param2, (uint16_t)(param2 >> 16),
+                                        (uint16_t)param3 };
+            (void)batt_classify_set_thresholds((uint16_t)param1, &th);
+            break;
+        }
+        default: break;
+    }
+}
+
+#ifdef Q_UTEST
+/* QUTest on the target (USE_QUTEST): the qutest script is the only event
+ * source and steps time with tick(). The QUTest stub never calls
+ * QF_onStartup(), so SysTick leaves the time events alone and tick
+ * counts in a script are exact. */
+void QS_onTestSetup(void) {
+}
+
+void QS_onTestTeardown(void) {
+}
+
+void QS_onTestEvt(QEvt *e) {
+    (void)e;
+}
+
+void QS_onTestPost(void const *sender, QActive *recipient, QEvt const *e, bool status) {
+    (void)sender; (void)recipient; (void)e; (void)status;
+}
+
+void QS_onTestLoop(void) {
+    QS_rxPriv_.inTestLoop = true;
+    while (QS_rxPriv_.inTestLoop) {
+        QS_rxParse();
+        __disable_irq();            /* the port's QF_INT_* only count */
+        qs_tx_dma();
+        __enable_irq();
+    }
+    QS_rxPriv_.inTestLoop = true;   /* ready for the next call */
+}
+#endif /* Q_UTEST */
+#endif /* Q_SPY */
+
 //............................................................................
-void QV_onIdle(void) {
+#ifdef APP_USE_QK
+void QK_onIdle(void) {   /* called with interrupts enabled */
+#ifdef Q_SPY
+    QF_INT_DISABLE();
+    qs_idle();
     QF_INT_ENABLE();
-#ifdef NDEBUG
+#else
+    if (report_due()) {
+        report();
+        return;
+    }
+#endif
+#if defined(NDEBUG) || defined(BSP_TICKLESS)
+    QF_INT_DISABLE();
+    idle_sleep();
+#endif
+}
+#else
+void QV_onIdle(void) {   /* called with interrupts disabled */
+#ifdef Q_SPY
+    qs_idle();
+#else
+    if (report_due()) {
+        QF_INT_ENABLE();    /* printf blocks on the UART; QV re-checks on return */
+        report();
+        return;
+    }
+#endif
+#if defined(NDEBUG) || defined(BSP_TICKLESS)
     /* Put the CPU and peripherals to the low-power mode.
     * you might need to customize the clock management for your application,
     * see the datasheet for your particular Cortex-M MCU.
     */
-    QV_CPU_SLEEP();  /* atomically go to sleep and enable interrupts */
+    idle_sleep();
 #else
     QF_INT_ENABLE(); /* just enable interrupts */
 #endif
 }
+#endif
 /* BSP functions ===========================================================*/
 void BSP_init(void) {
     //BSP_print_banner();
 }
 
+/* I2C1 bus-hang recovery ---------------------------------------------------
+ * A slave unplugged mid-byte can keep SDA low forever and the F1 peripheral
+ * then sits in BUSY. Take the pins over as open-drain GPIO, clock SCL until
+ * the slave lets go of SDA (max 9 bits), drive a STOP, reset the peripheral
+ * and re-init it with the settings still held in hi2c1.Init. */
+#define I2C1_SCL_PIN  GPIO_PIN_6   /* PB6 */
+#define I2C1_SDA_PIN  GPIO_PIN_7   /* PB7 */
+
+static void i2c_half_bit(void) {   /* ~5 us: half a 100 kHz clock */
+    for (volatile uint32_t n = SystemCoreClock / 1600000U; n != 0U; --n) { }
+}
+
+bool BSP_i2c1Recover(void) {
+    extern I2C_HandleTypeDef hi2c1;
+    GPIO_InitTypeDef g = {0};
+
+    (void)HAL_I2C_DeInit(&hi2c1);
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    HAL_GPIO_WritePin(GPIOB, I2C1_SCL_PIN | I2C1_SDA_PIN, GPIO_PIN_SET);
+    g.Pin   = I2C1_SCL_PIN | I2C1_SDA_PIN;
+    g.Mode  = GPIO_MODE_OUTPUT_OD;
+    g.Pull  = GPIO_NOPULL;
+    g.Speed = GPIO_SPEED_FREQ_HIGH;
+    HAL_GPIO_Init(GPIOB, &g);
+
+    for (uint8_t i = 0U; i < 9U; ++i) {
+        if (HAL_GPIO_ReadPin(GPIOB, I2C1_SDA_PIN) == GPIO_PIN_SET) break;
+        HAL_GPIO_WritePin(GPIOB, I2C1_SCL_PIN, GPIO_PIN_RESET); i2c_half_bit();
+        HAL_GPIO_WritePin(GPIOB, I2C1_SCL_PIN, GPIO_PIN_SET);   i2c_half_bit();
+    }
+    /* STOP: SDA rises while SCL is high */
+    HAL_GPIO_WritePin(GPIOB, I2C1_SCL_PIN, GPIO_PIN_RESET); i2c_half_bit();
+    HAL_GPIO_WritePin(GPIOB, I2C1_SDA_PIN, GPIO_PIN_RESET); i2c_half_bit();
+    HAL_GPIO_WritePin(GPIOB, I2C1_SCL_PIN, GPIO_PIN_SET);   i2c_half_bit();
+    HAL_GPIO_WritePin(GPIOB, I2C1_SDA_PIN, GPIO_PIN_SET);   i2c_half_bit();
+    bool const released = (HAL_GPIO_ReadPin(GPIOB, I2C1_SDA_PIN) == GPIO_PIN_SET);
+
+    /* clear the BUSY latch the peripheral kept from the stuck transfer */
+    __HAL_RCC_I2C1_CLK_ENABLE();
+    __HAL_RCC_I2C1_FORCE_RESET();
+    __HAL_RCC_I2C1_RELEASE_RESET();
+    if (HAL_I2C_Init(&hi2c1) != HAL_OK) {   /* MspInit restores AF_OD pins */
+        return false;
+    }
+    return released;
+}
+
 
 #define POSTX_TRACE_TAG(tag_, ao_, e_, margin_, sender_)          \
 do {                                                          \
@@ -298,8 +755,10 @@ g_lastTag = (uint8_t)(tag_);                              \
 (void)QACTIVE_POST_X((ao_), (e_), (margin_), (sender_));  \
 } while (0)
 
+#ifndef Q_UTEST   /* qutest.c reports the assertion to the script and resets */
 Q_NORETURN Q_onError(char const * const module, int loc) {
     __disable_irq();
+    QS_ASSERTION(module, loc, 10000U);
     printf(">>> Q_onAssert: %s : %d  (lastSig=%u tag=%u)\r\n",
            module, loc, g_lastSig, g_lastTag);
     while (1) {
@@ -307,6 +766,7 @@ Q_NORETURN Q_onError(char const * const module, int loc) {
         for (volatile uint32_t i=0; i<100000; ++i) { __NOP(); }
     }
 }
+#endif
 
 
 // support for printf() ======================================================
@@ -9,6 +9,8 @@
 #include <math.h>
 #include <stdbool.h>
 #include "bms_debug.h"
+#include "app_channels.h"
+#include "j1939_tp.h"
 
 Q_DEFINE_THIS_FILE
 
@@ -17,6 +19,14 @@ extern volatile uint16_t g_lastSig;
 extern volatile uint8_t  g_lastTag;
 static volatile uint8_t s_rxEnabled = 0u;
 
+/* Exact-id filters ignore the J1939 source-address byte when several bays
+ * share the bus (the bay is told apart by App_routeCanId()). */
+#if (APP_NUM_CHANNELS > 1U)
+#define CAN_EXACT_MASK  0x1FFFFF00u
+#else
+#define CAN_EXACT_MASK  0x1FFFFFFFu
+#endif
+
 /* ---------- helpers ---------- */
 static void print_hal(const char *tag, HAL_StatusTypeDef st) {
     printf("%s: %s\r\n", tag,
@@ -64,21 +74,21 @@ void CANAPP_InitAll(void) {
     {
         CAN_FilterTypeDef f = {0};
         f.FilterBank = 2; f.FilterMode = CAN_FILTERMODE_IDMASK; f.FilterScale = CAN_FILTERSCALE_32BIT;
-        pack_ext_filter(0x18070800u, 0x1FFFFFFFu, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
+        pack_ext_filter(0x18070800u, CAN_EXACT_MASK, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
         f.FilterFIFOAssignment = CAN_RX_FIFO0; f.FilterActivation = ENABLE; f.SlaveStartFilterBank = 14;
         print_hal("CAN ConfigFilter (0x18070800)", HAL_CAN_ConfigFilter(&hcan, &f));
     }
     {
         CAN_FilterTypeDef f = {0};
         f.FilterBank = 3; f.FilterMode = CAN_FILTERMODE_IDMASK; f.FilterScale = CAN_FILTERSCALE_32BIT;
-        pack_ext_filter(0x18060800u, 0x1FFFFFFFu, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
+        pack_ext_filter(0x18060800u, CAN_EXACT_MASK, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
         f.FilterFIFOAssignment = CAN_RX_FIFO0; f.FilterActivation = ENABLE; f.SlaveStartFilterBank = 14;
         print_hal("CAN ConfigFilter (0x18060800)", HAL_CAN_ConfigFilter(&hcan, &f));
     }
     {
         CAN_FilterTypeDef f = {0};
         f.FilterBank = 4; f.FilterMode = CAN_FILTERMODE_IDMASK; f.FilterScale = CAN_FILTERSCALE_32BIT;
-        pack_ext_filter(0x180C0800u, 0x1FFFFFFFu, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
+        pack_ext_filter(0x180C0800u, CAN_EXACT_MASK, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
         f.FilterFIFOAssignment = CAN_RX_FIFO0; f.FilterActivation = ENABLE; f.SlaveStartFilterBank = 14;
         print_hal("CAN ConfigFilter (0x180C0800)", HAL_CAN_ConfigFilter(&hcan, &f));
     }
@@ -99,10 +109,32 @@ void CANAPP_InitAll(void) {
     {
         CAN_FilterTypeDef f = {0};
         f.FilterBank = 7; f.FilterMode = CAN_FILTERMODE_IDMASK; f.FilterScale = CAN_FILTERSCALE_32BIT;
-        pack_ext_filter(0x18040A00u, 0x1FFFFFFFu, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
+        pack_ext_filter(0x18040A00u, CAN_EXACT_MASK, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
         f.FilterFIFOAssignment = CAN_RX_FIFO0; f.FilterActivation = ENABLE; f.SlaveStartFilterBank = 14;
         print_hal("CAN ConfigFilter (0x18040A00)", HAL_CAN_ConfigFilter(&hcan, &f));
     }
+    /* J1939 transport (BAM to global) + single-frame DM1, any source address */
+    {
+        CAN_FilterTypeDef f = {0};
+        f.FilterBank = 8; f.FilterMode = CAN_FILTERMODE_IDMASK; f.FilterScale = CAN_FILTERSCALE_32BIT;
+        pack_ext_filter(0x1CECFF00u, 0x1FFFFF00u, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
+        f.FilterFIFOAssignment = CAN_RX_FIFO0; f.FilterActivation = ENABLE; f.SlaveStartFilterBank = 14;
+        print_hal("CAN ConfigFilter (0x1CECFFxx TP.CM)", HAL_CAN_ConfigFilter(&hcan, &f));
+    }
+    {
+        CAN_FilterTypeDef f = {0};
+        f.FilterBank = 9; f.FilterMode = CAN_FILTERMODE_IDMASK; f.FilterScale = CAN_FILTERSCALE_32BIT;
+        pack_ext_filter(0x1CEBFF00u, 0x1FFFFF00u, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
+        f.FilterFIFOAssignment = CAN_RX_FIFO0; f.FilterActivation = ENABLE; f.SlaveStartFilterBank = 14;
+        print_hal("CAN ConfigFilter (0x1CEBFFxx TP.DT)", HAL_CAN_ConfigFilter(&hcan, &f));
+    }
+    {
+        CAN_FilterTypeDef f = {0};
+        f.FilterBank = 10; f.FilterMode = CAN_FILTERMODE_IDMASK; f.FilterScale = CAN_FILTERSCALE_32BIT;
+        pack_ext_filter(0x18FECA00u, 0x1FFFFF00u, &f.FilterIdHigh, &f.FilterIdLow, &f.FilterMaskIdHigh, &f.FilterMaskIdLow);
+        f.FilterFIFOAssignment = CAN_RX_FIFO0; f.FilterActivation = ENABLE; f.SlaveStartFilterBank = 14;
+        print_hal("CAN ConfigFilter (0x18FECAxx DM1)", HAL_CAN_ConfigFilter(&hcan, &f));
+    }
 
     print_hal("CAN Start", HAL_CAN_Start(&hcan));
 
@@ -144,6 +176,32 @@ void CANAPP_EnableRx(bool enable) {
     }
 }
 
+/* ---------- TX ---------- */
+bool CANAPP_Send(uint32_t id, const uint8_t *data, uint8_t dlc) {
+    CAN_TxHeaderTypeDef txh = {0};
+    uint32_t mbox;
+    bool ok = false;
+    txh.ExtId = id & 0x1FFFFFFFu;
+    txh.IDE   = CAN_ID_EXT;
+    txh.RTR   = CAN_RTR_DATA;
+    txh.DLC   = (dlc > 8U) ? 8U : dlc;
+
+    /* free-mailbox check + fill must not interleave between bays (QK) */
+    QF_CRIT_STAT;
+    QF_CRIT_ENTRY();
+    if (HAL_CAN_GetTxMailboxesFreeLevel(&hcan) != 0U) {
+        ok = (HAL_CAN_AddTxMessage(&hcan, &txh, (uint8_t *)data, &mbox) == HAL_OK);
+    }
+    QF_CRIT_EXIT();
+    return ok;
+}
+
+bool CANAPP_IsPriorityId(uint32_t id) {
+    return id == 0x18FF4000u      /* 500 HYP serial / firmware */
+        || id == 0x18FF1900u      /* 500 HYP node ids / limits */
+        || id == 0x18040A00u;     /* 400s serial / firmware / type */
+}
+
 /* ---------- RX ISR ---------- */
 void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hh) {
     if (!s_rxEnabled) {
@@ -158,22 +216,47 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hh) {
         printf("CAN RX: HAL_GetRxMessage ERR\r\n");
         return;
     }
-    const uint32_t id    = (rxh.IDE == CAN_ID_STD) ? rxh.StdId : rxh.ExtId;
+    const uint32_t raw   = (rxh.IDE == CAN_ID_STD) ? rxh.StdId : rxh.ExtId;
     const uint8_t  isExt = (rxh.IDE == CAN_ID_EXT) ? 1U : 0U;
 
+    /* bay routing by source address; the bay's SA base is taken off so the
+     * parsers see the same ids (master node 0) as in a single-bay setup */
+    uint32_t id;
+    const uint8_t ch = App_routeCanId(raw, &id);
+    if (ch >= APP_NUM_CHANNELS) return;
+
+    /* transport / DM1: sessions are keyed by the raw source address */
+    if (isExt && j1939_tp_claims(raw)) {
+        J1939MsgEvt *m = j1939_tp_rx(raw, data, (uint8_t)(rxh.DLC > 8 ? 8 : rxh.DLC), tick_ms());
+        if (m != NULL && !QACTIVE_POST_X(AO_BmsCh[ch], &m->super, 1U, 0U)) {
+            QF_gc(&m->super);
+        }
+        return;
+    }
     if (!can_id_is_expected(id, isExt)) return;
 
     CanFrameEvt *e = Q_NEW_X(CanFrameEvt, 0U, CAN_RX_SIG);
     if (!e) return;
 
-    e->id    = id;
-    e->isExt = isExt;
+    e->id     = id;
+    e->isExt  = isExt;
+    e->rx_cyc = BSP_cycles();
     e->dlc   = (uint8_t)(rxh.DLC > 8 ? 8 : rxh.DLC);
     memset(e->data, 0, sizeof(e->data));
     memcpy(e->data, data, e->dlc);
 
     g_lastSig = CAN_RX_SIG; g_lastTag = 10;
-    if (!QACTIVE_POST_X(AO_Bms, &e->super, 1U, 0U)) {
+    QS_BEGIN_ID(BSP_QS_CAN_RX, BSP_QS_ID_CAN)
+        QS_U8(0, ch);
+        QS_U32(QS_HEX_FMT, id);
+        QS_U8(0, e->dlc);
+        QS_MEM(e->data, e->dlc);
+    QS_END()
+    /* identity replies go to the front, but never use up the last slots
+     * (LIFO posting asserts on a full queue) */
+    if (CANAPP_IsPriorityId(id) && AO_BmsCh[ch]->eQueue.nFree > 2U) {
+        QACTIVE_POST_LIFO(AO_BmsCh[ch], &e->super);
+    } else if (!QACTIVE_POST_X(AO_BmsCh[ch], &e->super, 1U, 0U)) {
         QF_gc(&e->super);
     }
 }
@@ -0,0 +1,177 @@
+// charge_profile.c
+#include "charge_profile.h"
+#include <math.h>
+#include <stddef.h>
+
+/* Re-program the PSU only when the setpoint moves by more than this */
+#define CHG_DEADBAND_V      0.05f
+#define CHG_DEADBAND_A      0.05f
+/* Harness drop allowance (PSU terminal minus BMS pack voltage) */
+#define CHG_DROP_MAX_V      2.0f
+/* PSU readback this close to vset counts as voltage-limited */
+#define CHG_CEIL_BAND_V     0.3f
+/* CV trim: per-update step limits and total range */
+#define CHG_TRIM_STEP_DN_V  0.20f
+#define CHG_TRIM_STEP_UP_V  0.05f
+#define CHG_TRIM_MIN_V     (-3.0f)
+#define CHG_TRIM_MAX_V      1.0f
+
+/* Rows start from the old fixed 48 V / 1 A / 3 A charge; the pre-charge exit
+ * sits above each family's Recoverable floor (batt_classify.c). Refine per pack
+ * datasheet. A family without a row is refused, never charged on a guess. */
+static ChargeProfile const k_profiles[] = {
+    /* code    Vmax   preX  cvV   abortV iPre iCC  iTap  hold preMax maxMin Ah */
+    { 0x0400U, 48.0f, 3.0f, 4.05f, 4.20f, 1.0f, 3.0f, 0.30f, 30U, 900U, 240U, 50U },
+    { 0x0401U, 48.0f, 3.0f, 4.05f, 4.20f, 1.0f, 3.0f, 0.30f, 30U, 900U, 240U, 50U },
+    { 0x0402U, 48.0f, 3.0f, 4.05f, 4.20f, 1.0f, 3.0f, 0.30f, 30U, 900U, 240U, 50U },
+    { 0x0500U, 48.0f, 3.1f, 4.05f, 4.20f, 1.0f, 3.0f, 0.30f, 30U, 900U, 240U, 50U },
+    { 0x0501U, 48.0f, 3.0f, 4.05f, 4.20f, 1.0f, 3.0f, 0.30f, 30U, 900U, 240U, 50U },
+    { 0x0600U, 48.0f, 2.8f, 4.05f, 4.20f, 1.0f, 3.0f, 0.30f, 30U, 900U, 240U, 50U },
+};
+#define N_PROFILES (sizeof(k_profiles) / sizeof(k_profiles[0]))
+
+static inline bool valid(float x) { return isfinite(x) && x > 0.05f; }
+static inline float clampf(float x, float lo, float hi) { return x < lo ? lo : (x > hi ? hi : x); }
+
+ChargeProfile const *charge_profile_for(uint16_t type_code) {
+    for (size_t i = 0; i < N_PROFILES; ++i) {
+        if (k_profiles[i].type_code == type_code) return &k_profiles[i];
+    }
+    return NULL;
+}
+
+char const *charge_stage_str(ChargeStage s) {
+    switch (s) {
+        case CHG_STAGE_PRECHARGE: return "pre-charge";
+        case CHG_STAGE_CC:        return "charging CC";
+        case CHG_STAGE_CV:        return "charging CV";
+        case CHG_STAGE_DONE:      return "charge complete";
+        case CHG_STAGE_FAULT:     return "charge fault";
+        default:                  return "idle";
+    }
+}
+
+static void enter(ChargeEngine *ce, ChargeStage s, uint32_t now_ms) {
+    ce->stage    = s;
+    ce->stage_ms = now_ms;
+    ce->below_ms = 0U;
+    if (s == CHG_STAGE_CV) ce->trim_V = 0.0f;
+}
+
+void charge_start(ChargeEngine *ce, uint16_t type_code, bool recoverable, uint32_t now_ms) {
+    ce->p      = charge_profile_for(type_code);
+    ce->vset   = 0.0f;
+    ce->iset   = 0.0f;
+    ce->trim_V = 0.0f;
+    ce->cells  = 0U;
+    ce->t0_ms  = now_ms;
+    ce->why    = NULL;
+    if (ce->p == NULL) {
+        ce->why = "no charge profile for this pack";
+        enter(ce, CHG_STAGE_FAULT, now_ms);
+        return;
+    }
+    enter(ce, recoverable ? CHG_STAGE_PRECHARGE : CHG_STAGE_CC, now_ms);
+}
+
+static void fail(ChargeEngine *ce, char const *why, uint32_t now_ms) {
+    ce->why = why;
+    enter(ce, CHG_STAGE_FAULT, now_ms);
+}
+
+/* CV voltage: cells * target + harness drop + trim from the highest cell */
+static float cv_voltage(ChargeEngine *ce, ChargeInputs const *in) {
+    ChargeProfile const *p = ce->p;
+    if (ce->cells == 0U) return p->pack_max_V;
+
+    float drop = 0.0f;
+    if (in->psu_on && valid(in->psu_V) && valid(in->pack_V)) {
+        drop = clampf(in->psu_V - in->pack_V, 0.0f, CHG_DROP_MAX_V);
+    }
+    if (valid(in->high_cell_V)) {
+        float const step = (p->cell_cv_V - in->high_cell_V) * (float)ce->cells;
+        ce->trim_V = clampf(ce->trim_V + clampf(step, -CHG_TRIM_STEP_DN_V, CHG_TRIM_STEP_UP_V),
+                            CHG_TRIM_MIN_V, CHG_TRIM_MAX_V);
+    }
+    return clampf((float)ce->cells * p->cell_cv_V + drop + ce->trim_V, 0.0f, p->pack_max_V);
+}
+
+bool charge_step(ChargeEngine *ce, ChargeInputs const *in, uint32_t now_ms) {
+    ChargeProfile const *p = ce->p;
+    ChargeStage const before = ce->stage;
+    if (p == NULL || ce->stage == CHG_STAGE_IDLE ||
+        ce->stage == CHG_STAGE_DONE || ce->stage == CHG_STAGE_FAULT) {
+        return false;
+    }
+
+    /* series count from pack / mean cell (refreshed while the data is sane) */
+    if (valid(in->pack_V) && valid(in->high_cell_V) && valid(in->low_cell_V)) {
+        float const n = in->pack_V / (0.5f * (in->high_cell_V + in->low_cell_V));
+        if (n >= 1.0f && n <= 64.0f) ce->cells = (uint8_t)(n + 0.5f);
+    }
+
+    float v = p->pack_max_V, i = 0.0f;
+
+    if (valid(in->high_cell_V) && in->high_cell_V >= p->cell_abort_V) {
+        fail(ce, "cell over-voltage", now_ms);
+    }
+
+    switch (ce->stage) {
+        case CHG_STAGE_PRECHARGE:
+            if (valid(in->low_cell_V) && in->low_cell_V >= p->cell_pre_exit_V) {
+                enter(ce, CHG_STAGE_CC, now_ms);
+                i = p->i_cc_A;
+            } else if ((now_ms - ce->stage_ms) >= (uint32_t)p->pre_max_s * 1000U) {
+                fail(ce, "pre-charge timeout", now_ms);
+            } else {
+                i = p->i_pre_A;
+            }
+            break;
+
+        case CHG_STAGE_CC: {
+            /* CV either on the cell target or when the PSU itself has hit the
+             * voltage ceiling and the current started to fall off */
+            bool const at_ceiling = in->psu_on && valid(in->psu_V)
+                                 && in->psu_V >= ce->vset - CHG_CEIL_BAND_V
+                                 && in->psu_I < 0.9f * p->i_cc_A;
+            if ((valid(in->high_cell_V) && in->high_cell_V >= p->cell_cv_V) || at_ceiling) {
+                enter(ce, CHG_STAGE_CV, now_ms);
+                v = cv_voltage(ce, in);
+            }
+            i = p->i_cc_A;
+        } break;
+
+        case CHG_STAGE_CV: {
+            v = cv_voltage(ce, in);
+            i = p->i_cc_A;
+            float const meas = (in->bms_I_A > 0.0f) ? in->bms_I_A
+                             : (in->psu_on ? in->psu_I : NAN);
+            if (isfinite(meas) && meas < p->i_taper_A) {
+                if (ce->below_ms == 0U) ce->below_ms = now_ms | 1U;
+                if ((now_ms - ce->below_ms) >= (uint32_t)p->taper_hold_s * 1000U) {
+                    ce->why = "taper current reached";
+                    enter(ce, CHG_STAGE_DONE, now_ms);
+                }
+            } else {
+                ce->below_ms = 0U;
+            }
+        } break;
+
+        default:
+            break;
+    }
+
+    if (ce->stage == CHG_STAGE_DONE || ce->stage == CHG_STAGE_FAULT) {
+        ce->vset = 0.0f;
+        ce->iset = 0.0f;
+        return true;
+    }
+    if (ce->stage != before
+        || fabsf(v - ce->vset) >= CHG_DEADBAND_V
+        || fabsf(i - ce->iset) >= CHG_DEADBAND_A) {
+        ce->vset = v;
+        ce->iset = i;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,221 @@
+// cotek_emu.c
+// Emulated Cotek PSU: register file 0x60..0x7C, fault/latency injection and a
+// small CC/CV-into-battery output model with thermal rise.
+
+#include "cotek_emu.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* ============================ Register layout ============================= */
+
+#define REG_VOUT    0x60U   /* V*100, LE */
+#define REG_IOUT    0x62U   /* A*100, LE */
+#define REG_TEMP    0x68U   /* degC      */
+#define REG_VSET    0x70U   /* V*100, LE */
+#define REG_ISET    0x72U   /* A*100, LE */
+#define REG_CTRL    0x7CU
+
+#define CTRL_ON     0x01U
+#define CTRL_UPDATE 0x04U
+#define CTRL_REMOTE 0x80U
+
+#define NREGS       (COTEK_EMU_REG_LAST - COTEK_EMU_REG_FIRST + 1U)
+
+static struct {
+    CotekEmuCfg   cfg;
+    CotekEmuStats st;
+    uint8_t       reg[NREGS];
+    uint8_t       remote, on;
+    float         vset, iset;        /* latched by CTRL_UPDATE */
+    float         v, i, t;           /* model outputs          */
+    uint32_t      last_ms;
+    uint32_t      rng;
+    bool          wedged;            /* SDA held low by the slave */
+} s_psu;
+
+/* ================================ Helpers ================================= */
+
+static inline uint8_t *reg_at(uint8_t r) { return &s_psu.reg[r - COTEK_EMU_REG_FIRST]; }
+static inline bool reg_ok(uint8_t r) { return r >= COTEK_EMU_REG_FIRST && r <= COTEK_EMU_REG_LAST; }
+
+static inline uint16_t rd16(uint8_t r) { return (uint16_t)(reg_at(r)[0] | (reg_at(r)[1] << 8)); }
+static inline void wr16(uint8_t r, uint16_t v) {
+    reg_at(r)[0] = (uint8_t)(v & 0xFFU);
+    reg_at(r)[1] = (uint8_t)(v >> 8);
+}
+
+static uint8_t rng_pct(void) {                 /* xorshift32 -> 0..99 */
+    uint32_t x = s_psu.rng;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    s_psu.rng = x;
+    return (uint8_t)(x % 100U);
+}
+
+static inline float slew(float cur, float tgt, float rate, float dt) {
+    float const step = rate * dt;
+    if (tgt > cur + step) return cur + step;
+    if (tgt < cur - step) return cur - step;
+    return tgt;
+}
+
+static void burn(uint32_t ms) {
+    s_psu.st.busy_ms += ms;
+    if (ms && s_psu.cfg.delay_ms) s_psu.cfg.delay_ms(ms);
+}
+
+static void publish_readbacks(void) {
+    float const v = (s_psu.v > 0.0f) ? s_psu.v : 0.0f;
+    float const i = (s_psu.i > 0.0f) ? s_psu.i : 0.0f;
+    wr16(REG_VOUT, (uint16_t)(v * 100.0f + 0.5f));
+    wr16(REG_IOUT, (uint16_t)(i * 100.0f + 0.5f));
+    *reg_at(REG_TEMP) = (uint8_t)((s_psu.t > 0.0f) ? (s_psu.t + 0.5f) : 0.0f);
+    *reg_at(REG_CTRL) = (uint8_t)((s_psu.remote ? CTRL_REMOTE : 0U) | (s_psu.on ? CTRL_ON : 0U));
+}
+
+/* Control byte: remote bit gates everything, UPDATE latches 0x70..0x73 */
+static void write_ctrl(uint8_t v) {
+    s_psu.remote = (uint8_t)((v & CTRL_REMOTE) != 0U);
+    if (!s_psu.remote) return;
+    if (v & CTRL_UPDATE) {
+        s_psu.vset = (float)rd16(REG_VSET) / 100.0f;
+        s_psu.iset = (float)rd16(REG_ISET) / 100.0f;
+        ++s_psu.st.commits;
+    }
+    uint8_t const on = (uint8_t)((v & CTRL_ON) != 0U);
+    if (on && !s_psu.on)  ++s_psu.st.on_cmds;
+    if (!on && s_psu.on)  ++s_psu.st.off_cmds;
+    s_psu.on = on;
+}
+
+/* Common front end of every transaction: model time, injected faults, latency */
+static CotekEmuStatus begin_xfer(uint16_t len, uint32_t timeout_ms) {
+    CotekEmu_step();
+    ++s_psu.st.xfers;
+    if (s_psu.wedged) {
+        return COTEK_EMU_BUSY;       /* HAL gives up on the BUSY flag */
+    }
+    if (!s_psu.cfg.present) {
+        ++s_psu.st.nacks;            /* nobody acks the address */
+        return COTEK_EMU_NACK;
+    }
+    if (s_psu.cfg.timeout_pct && rng_pct() < s_psu.cfg.timeout_pct) {
+        ++s_psu.st.timeouts;
+        burn(timeout_ms);
+        s_psu.wedged = s_psu.cfg.wedge_on_timeout;
+        return COTEK_EMU_TIMEOUT;
+    }
+    if (s_psu.cfg.nack_pct && rng_pct() < s_psu.cfg.nack_pct) {
+        ++s_psu.st.nacks;
+        return COTEK_EMU_NACK;
+    }
+    burn(s_psu.cfg.latency_ms);
+    s_psu.st.bytes += len;
+    return COTEK_EMU_OK;
+}
+
+/* ================================== API =================================== */
+
+void CotekEmu_defaults(CotekEmuCfg *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->latency_ms  = 1U;
+    cfg->present     = true;
+    cfg->batt_ocv_V  = 46.0f;
+    cfg->batt_r_ohm  = 0.15f;
+    cfg->v_slew_Vps  = 10.0f;
+    cfg->i_slew_Aps  = 5.0f;
+    cfg->ambient_C   = 25.0f;
+    cfg->heat_CpWs   = 0.02f;
+    cfg->cool_per_s  = 0.01f;
+    cfg->efficiency  = 0.90f;
+}
+
+void CotekEmu_init(CotekEmuCfg const *cfg) {
+    memset(&s_psu, 0, sizeof(s_psu));
+    if (cfg) s_psu.cfg = *cfg; else CotekEmu_defaults(&s_psu.cfg);
+    s_psu.rng     = 0x2545F491u;
+    s_psu.v       = s_psu.cfg.batt_ocv_V;
+    s_psu.t       = s_psu.cfg.ambient_C;
+    s_psu.last_ms = s_psu.cfg.now_ms ? s_psu.cfg.now_ms() : 0U;
+    publish_readbacks();
+}
+
+CotekEmuCfg *CotekEmu_cfg(void) { return &s_psu.cfg; }
+
+void CotekEmu_step(void) {
+    uint32_t const now = s_psu.cfg.now_ms ? s_psu.cfg.now_ms() : s_psu.last_ms;
+    uint32_t dms = now - s_psu.last_ms;
+    s_psu.last_ms = now;
+    if (dms > 1000U) dms = 1000U;             /* long gaps: settle, don't overshoot */
+    float const dt = (float)dms * 0.001f;
+
+    float v_tgt = s_psu.cfg.batt_ocv_V;       /* output off: terminals see the pack */
+    float i_tgt = 0.0f;
+    if (s_psu.on && s_psu.vset > s_psu.cfg.batt_ocv_V && s_psu.cfg.batt_r_ohm > 0.0f) {
+        float const i_cv = (s_psu.vset - s_psu.cfg.batt_ocv_V) / s_psu.cfg.batt_r_ohm;
+        if (i_cv > s_psu.iset) {              /* CC: current limit sets the voltage */
+            i_tgt = s_psu.iset;
+            v_tgt = s_psu.cfg.batt_ocv_V + s_psu.iset * s_psu.cfg.batt_r_ohm;
+        } else {                              /* CV */
+            i_tgt = i_cv;
+            v_tgt = s_psu.vset;
+        }
+    }
+    s_psu.v = slew(s_psu.v, v_tgt, s_psu.cfg.v_slew_Vps, dt);
+    s_psu.i = slew(s_psu.i, i_tgt, s_psu.cfg.i_slew_Aps, dt);
+
+    float const eff  = (s_psu.cfg.efficiency > 0.0f) ? s_psu.cfg.efficiency : 1.0f;
+    float const loss = s_psu.v * s_psu.i * (1.0f / eff - 1.0f);
+    s_psu.t += (loss * s_psu.cfg.heat_CpWs - (s_psu.t - s_psu.cfg.ambient_C) * s_psu.cfg.cool_per_s) * dt;
+
+    publish_readbacks();
+}
+
+CotekEmuStatus CotekEmu_write(uint8_t const *buf, uint16_t len, uint32_t timeout_ms) {
+    CotekEmuStatus const st = begin_xfer(len, timeout_ms);
+    if (st != COTEK_EMU_OK || len == 0U) return st;
+
+    uint8_t r = buf[0];                       /* register pointer, auto-increment */
+    for (uint16_t k = 1U; k < len; ++k, ++r) {
+        if (!reg_ok(r)) { ++s_psu.st.nacks; return COTEK_EMU_NACK; }
+        if (r == REG_CTRL) write_ctrl(buf[k]);
+        else               *reg_at(r) = buf[k];
+    }
+    publish_readbacks();
+    return COTEK_EMU_OK;
+}
+
+CotekEmuStatus CotekEmu_memRead(uint8_t reg, uint8_t *buf, uint16_t len, uint32_t timeout_ms) {
+    CotekEmuStatus const st = begin_xfer((uint16_t)(len + 1U), timeout_ms);
+    if (st != COTEK_EMU_OK) return st;
+    for (uint16_t k = 0U; k < len; ++k) {
+        uint8_t const r = (uint8_t)(reg + k);
+        buf[k] = reg_ok(r) ? *reg_at(r) : 0xFFU;
+    }
+    return COTEK_EMU_OK;
+}
+
+CotekEmuStatus CotekEmu_probe(void) {
+    ++s_psu.st.probes;
+    if (s_psu.wedged)         return COTEK_EMU_BUSY;
+    if (!s_psu.cfg.present)   { ++s_psu.st.nacks; return COTEK_EMU_NACK; }
+    return COTEK_EMU_OK;
+}
+
+void CotekEmu_recover(void) {
+    ++s_psu.st.recoveries;
+    s_psu.wedged = false;
+}
+
+CotekEmuStats const *CotekEmu_stats(void) { return &s_psu.st; }
+
+void CotekEmu_report(void) {
+    printf("COTEKEMU: xfers=%lu bytes=%lu nack=%lu tmo=%lu busy=%lu ms probes=%lu rec=%lu | "
+           "commits=%lu on=%lu off=%lu | out=%s V=%.2f I=%.2f T=%.1f\r\n",
+           (unsigned long)s_psu.st.xfers, (unsigned long)s_psu.st.bytes,
+           (unsigned long)s_psu.st.nacks, (unsigned long)s_psu.st.timeouts,
+           (unsigned long)s_psu.st.busy_ms, (unsigned long)s_psu.st.probes,
+           (unsigned long)s_psu.st.recoveries, (unsigned long)s_psu.st.commits,
+           (unsigned long)s_psu.st.on_cmds, (unsigned long)s_psu.st.off_cmds,
+           s_psu.on ? "ON" : "OFF", (double)s_psu.v, (double)s_psu.i, (double)s_psu.t);
+}
@@ -0,0 +1,65 @@
+// coulomb.c
+#include "coulomb.h"
+#include <string.h>
+
+#define MS_PER_H   3600000LL
+
+static int64_t full_mAms(Coulomb const *c) { return (int64_t)c->cap_mAh * MS_PER_H; }
+
+static int64_t soc_to_mAms(Coulomb const *c, uint8_t pct) {
+    if (pct > 100U) pct = 100U;
+    return full_mAms(c) * pct / 100;
+}
+
+void coulomb_start(Coulomb *c, uint32_t cap_mAh, uint8_t bms_soc_pct, uint32_t now_ms) {
+    memset(c, 0, sizeof(*c));
+    c->cap_mAh   = cap_mAh;
+    c->pack_mAms = soc_to_mAms(c, bms_soc_pct);
+    c->bms_pct   = bms_soc_pct;
+    c->t0_ms     = now_ms;
+    c->last_ms   = now_ms;
+}
+
+void coulomb_sample(Coulomb *c, int32_t i_mA, int32_t v_mV, uint32_t now_ms) {
+    if (c->have) {
+        uint32_t dt = now_ms - c->last_ms;
+        if (dt > COULOMB_MAX_GAP_MS) dt = COULOMB_MAX_GAP_MS;
+        const int64_t q = (int64_t)c->i_mA * dt;
+        c->sess_mAms += q;
+        c->sess_mWms += q * c->v_mV / 1000;
+        c->pack_mAms += q;
+        if (c->pack_mAms < 0) c->pack_mAms = 0;
+        if (c->cap_mAh != 0U && c->pack_mAms > full_mAms(c)) c->pack_mAms = full_mAms(c);
+    }
+    c->i_mA    = i_mA;
+    c->v_mV    = v_mV;
+    c->last_ms = now_ms;
+    c->have    = 1U;
+}
+
+void coulomb_correct(Coulomb *c, uint8_t bms_soc_pct) {
+    if (c->cap_mAh == 0U || bms_soc_pct == c->bms_pct) return;
+    const uint8_t prev = c->bms_pct;
+    c->bms_pct = bms_soc_pct;
+    /* a single step happens at the edge between the two values; a jump says
+     * no more than the new value does */
+    int64_t target = soc_to_mAms(c, bms_soc_pct);
+    if (bms_soc_pct == (uint8_t)(prev + 1U) || prev == (uint8_t)(bms_soc_pct + 1U)) {
+        target = (target + soc_to_mAms(c, prev)) / 2;
+    }
+    c->pack_mAms += (target - c->pack_mAms) / COULOMB_CORR_DIV;
+}
+
+uint8_t coulomb_soc_pct(Coulomb const *c) {
+    if (c->cap_mAh == 0U) return 0U;
+    return (uint8_t)((c->pack_mAms * 100 + full_mAms(c) / 2) / full_mAms(c));
+}
+
+int32_t coulomb_session_mAh(Coulomb const *c) { return (int32_t)(c->sess_mAms / MS_PER_H); }
+int32_t coulomb_session_mWh(Coulomb const *c) { return (int32_t)(c->sess_mWms / MS_PER_H); }
+
+uint16_t coulomb_ttf_min(Coulomb const *c) {
+    if (c->cap_mAh == 0U || c->i_mA <= 0) return 0xFFFFU;
+    const int64_t min = (full_mAms(c) - c->pack_mAms) / ((int64_t)c->i_mA * 60000);
+    return (min > 0xFFFE) ? 0xFFFEU : (uint16_t)min;
+}
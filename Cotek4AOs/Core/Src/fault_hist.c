@@ -0,0 +1,98 @@
+// fault_hist.c
+#include "fault_hist.h"
+#include <string.h>
+
+_Static_assert((FAULT_HIST_BUCKETS & (FAULT_HIST_BUCKETS - 1U)) == 0U, "buckets must be a power of two");
+_Static_assert(FAULT_HIST_SIZE < FAULT_HIST_NONE, "entry index must fit below FAULT_HIST_NONE");
+
+static uint8_t bucket_of(uint16_t family, uint8_t domain, uint32_t code) {
+    uint32_t k = code * 2654435761u;
+    k ^= ((uint32_t)family << 8) ^ domain;
+    k ^= k >> 15;
+    return (uint8_t)(k & (FAULT_HIST_BUCKETS - 1U));
+}
+
+void fault_hist_reset(FaultHist *h) {
+    memset(h, 0, sizeof(*h));
+    memset(h->head, FAULT_HIST_NONE, sizeof(h->head));
+}
+
+void fault_hist_begin(FaultHist *h) {
+    ++h->gen;
+}
+
+static void unlink(FaultHist *h, uint8_t i) {
+    FaultHistEntry const *x = &h->e[i];
+    uint8_t *p = &h->head[bucket_of(x->family, x->domain, x->code)];
+    while (*p != FAULT_HIST_NONE && *p != i) p = &h->e[*p].next;
+    if (*p == i) *p = x->next;
+}
+
+/* full table: least recently seen, inactive ones first */
+static uint8_t victim(FaultHist const *h) {
+    uint8_t best = 0U;
+    for (uint8_t i = 1U; i < FAULT_HIST_SIZE; ++i) {
+        FaultHistEntry const *a = &h->e[i], *b = &h->e[best];
+        if ((a->active < b->active) ||
+            (a->active == b->active && (int32_t)(a->last_ms - b->last_ms) < 0)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool fault_hist_note(FaultHist *h, uint16_t family, uint8_t domain, uint32_t code, uint32_t now_ms) {
+    const uint8_t b = bucket_of(family, domain, code);
+    uint8_t i = h->head[b];
+    while (i != FAULT_HIST_NONE) {
+        FaultHistEntry *x = &h->e[i];
+        if (x->code == code && x->family == family && x->domain == domain) break;
+        i = x->next;
+    }
+
+    if (i == FAULT_HIST_NONE) {
+        if (h->used < FAULT_HIST_SIZE) {
+            i = h->used++;
+        } else {
+            i = victim(h);
+            unlink(h, i);
+            ++h->evicted;
+        }
+        FaultHistEntry *x = &h->e[i];
+        memset(x, 0, sizeof(*x));
+        x->family   = family;
+        x->domain   = domain;
+        x->code     = code;
+        x->first_ms = now_ms;
+        x->next     = h->head[b];
+        h->head[b]  = i;
+    }
+
+    FaultHistEntry *x = &h->e[i];
+    const bool fresh = (x->active == 0U);
+    if (fresh && x->count < UINT16_MAX) ++x->count;
+    x->active  = 1U;
+    x->seen    = h->gen;
+    x->last_ms = now_ms;
+    return fresh;
+}
+
+void fault_hist_end(FaultHist *h) {
+    for (uint8_t i = 0U; i < h->used; ++i) {
+        if (h->e[i].seen != h->gen) h->e[i].active = 0U;
+    }
+}
+
+uint8_t fault_hist_recent(FaultHist const *h, uint8_t *idx, uint8_t max) {
+    uint8_t n = 0U;
+    for (uint8_t i = 0U; i < h->used; ++i) {
+        /* insertion into the top-`max` list, newest first */
+        uint8_t k = (n < max) ? n++ : max;
+        while (k > 0U && (int32_t)(h->e[idx[k - 1U]].last_ms - h->e[i].last_ms) < 0) {
+            if (k < max) idx[k] = idx[k - 1U];
+            --k;
+        }
+        if (k < max) idx[k] = i;
+    }
+    return n;
+}
@@ -0,0 +1,84 @@
+// inputs.c
+#include "inputs.h"
+#include <string.h>
+
+void inputs_init(Inputs *s, uint8_t n, uint32_t gestures, uint32_t levels, uint32_t now_ms) {
+    memset(s, 0, sizeof(*s));
+    s->n        = (n > INPUTS_MAX) ? INPUTS_MAX : n;
+    s->gestures = gestures;
+    for (uint8_t i = 0U; i < s->n; ++i) {
+        InputState *x = &s->in[i];
+        x->raw = x->stable = (uint8_t)((levels >> i) & 1U);
+        x->edge_ms = x->down_ms = now_ms;
+        x->long_sent = x->stable;       /* held at boot: no LONG for it */
+    }
+}
+
+static void put(InputEv *out, uint8_t max, uint8_t *n, uint8_t input, InputEvKind kind) {
+    if (*n < max) {
+        out[*n].input = input;
+        out[*n].kind  = (uint8_t)kind;
+        ++*n;
+    }
+}
+
+uint8_t inputs_sample(Inputs *s, uint32_t levels, uint32_t now_ms, InputEv *out, uint8_t max) {
+    uint8_t n = 0U;
+    for (uint8_t i = 0U; i < s->n; ++i) {
+        InputState *x = &s->in[i];
+        const uint8_t lvl = (uint8_t)((levels >> i) & 1U);
+        const bool    g   = ((s->gestures >> i) & 1U) != 0U;
+
+        if (lvl != x->raw) {
+            x->raw     = lvl;
+            x->edge_ms = now_ms;
+        } else if (lvl != x->stable && (now_ms - x->edge_ms) >= INPUT_DEBOUNCE_MS) {
+            x->stable = lvl;
+            put(out, max, &n, i, lvl ? INPUT_EV_DOWN : INPUT_EV_UP);
+            if (g && lvl) {
+                x->down_ms   = now_ms;
+                x->long_sent = 0U;
+            } else if (g && !x->long_sent) {
+                if (x->clicks != 0U) {
+                    x->clicks = 0U;
+                    put(out, max, &n, i, INPUT_EV_DOUBLE);
+                } else {
+                    x->clicks = 1U;
+                    x->up_ms  = now_ms;
+                }
+            }
+        }
+
+        if (!g) continue;
+        if (x->stable && !x->long_sent && (now_ms - x->down_ms) >= INPUT_LONG_MS) {
+            x->long_sent = 1U;
+            x->clicks    = 0U;          /* click + long is just a long */
+            put(out, max, &n, i, INPUT_EV_LONG);
+        }
+        if (x->clicks != 0U && !x->stable && (now_ms - x->up_ms) >= INPUT_DOUBLE_MS) {
+            x->clicks = 0U;
+            put(out, max, &n, i, INPUT_EV_CLICK);
+        }
+    }
+    return n;
+}
+
+bool inputs_busy(Inputs const *s) {
+    for (uint8_t i = 0U; i < s->n; ++i) {
+        InputState const *x = &s->in[i];
+        if (x->raw != x->stable) return true;
+        if (((s->gestures >> i) & 1U) != 0U &&
+            ((x->stable && !x->long_sent) || x->clicks != 0U)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t inputs_levels(Inputs const *s) {
+    uint32_t m = 0U;
+    for (uint8_t i = 0U; i < s->n; ++i) {
+        m |= (uint32_t)s->in[i].stable << i;
+    }
+    return m;
+}
@@ -0,0 +1,155 @@
+// j1939_tp.c
+#include "j1939_tp.h"
+#include "app_signals.h"
+#include <string.h>
+
+#define PF_TP_CM        0xECu
+#define PF_TP_DT        0xEBu
+#define TP_CM_BAM       0x20u
+#define TP_DT_PAYLOAD   7U
+
+typedef struct {
+    J1939MsgEvt *evt;           /* NULL = free; reassembly buffer otherwise */
+    uint8_t      sa;
+    uint8_t      npkts;
+    uint8_t      next;          /* next expected sequence number (1-based) */
+    uint32_t     last_ms;
+} TpSession;
+
+static TpSession    s_ses[J1939_TP_MAX_SESSIONS];
+static J1939TpStats s_stats;
+
+static inline uint8_t pf_of(uint32_t id) { return (uint8_t)(id >> 16); }
+static inline uint8_t ps_of(uint32_t id) { return (uint8_t)(id >> 8); }
+
+bool j1939_tp_claims(uint32_t id) {
+    const uint8_t pf = pf_of(id);
+    if (pf == PF_TP_CM || pf == PF_TP_DT) return true;
+    return pf == (uint8_t)(J1939_PGN_DM1 >> 8) && ps_of(id) == (uint8_t)J1939_PGN_DM1;
+}
+
+static void drop(TpSession *s) {
+    QF_gc(&s->evt->super);
+    s->evt = NULL;
+}
+
+static TpSession *find(uint8_t sa) {
+    for (uint8_t k = 0U; k < J1939_TP_MAX_SESSIONS; ++k) {
+        if (s_ses[k].evt != NULL && s_ses[k].sa == sa) return &s_ses[k];
+    }
+    return NULL;
+}
+
+static void expire(uint32_t now_ms) {
+    for (uint8_t k = 0U; k < J1939_TP_MAX_SESSIONS; ++k) {
+        if (s_ses[k].evt != NULL && (now_ms - s_ses[k].last_ms) > J1939_TP_T1_MS) {
+            drop(&s_ses[k]);
+            ++s_stats.timeouts;
+        }
+    }
+}
+
+static void on_bam(uint8_t sa, uint8_t const *d, uint32_t now_ms) {
+    const uint16_t size  = (uint16_t)(d[1] | ((uint16_t)d[2] << 8));
+    const uint8_t  npkts = d[3];
+    const uint32_t pgn   = d[5] | ((uint32_t)d[6] << 8) | ((uint32_t)d[7] << 16);
+
+    TpSession *s = find(sa);
+    if (s != NULL) {                /* new BAM before the old one finished */
+        drop(s);
+        ++s_stats.bad_seq;
+    }
+    if (size > J1939_TP_MAX_LEN || npkts == 0U
+        || (uint16_t)npkts * TP_DT_PAYLOAD < size) {
+        ++s_stats.too_long;
+        return;
+    }
+    for (uint8_t k = 0U; s == NULL && k < J1939_TP_MAX_SESSIONS; ++k) {
+        if (s_ses[k].evt == NULL) s = &s_ses[k];
+    }
+    if (s == NULL) {
+        ++s_stats.busy;
+        return;
+    }
+    J1939MsgEvt *e = Q_NEW_X(J1939MsgEvt, 1U, J1939_MSG_SIG);
+    if (e == NULL) {
+        ++s_stats.no_mem;
+        return;
+    }
+    e->pgn = pgn;
+    e->len = size;
+    e->sa  = sa;
+    s->evt     = e;
+    s->sa      = sa;
+    s->npkts   = npkts;
+    s->next    = 1U;
+    s->last_ms = now_ms;
+}
+
+static J1939MsgEvt *on_dt(uint8_t sa, uint8_t const *d, uint32_t now_ms) {
+    TpSession *s = find(sa);
+    if (s == NULL) return NULL;     /* missed the BAM: ignore the tail */
+    if (d[0] != s->next) {
+        drop(s);
+        ++s_stats.bad_seq;
+        return NULL;
+    }
+    J1939MsgEvt *e = s->evt;
+    const uint16_t off = (uint16_t)(s->next - 1U) * TP_DT_PAYLOAD;
+    if (off < e->len) {
+        const uint16_t left = (uint16_t)(e->len - off);
+        memcpy(&e->data[off], &d[1], (left < TP_DT_PAYLOAD) ? left : TP_DT_PAYLOAD);
+    }
+    s->last_ms = now_ms;
+    if (s->next++ < s->npkts) return NULL;
+
+    s->evt = NULL;                  /* ownership goes to the caller */
+    ++s_stats.done;
+    return e;
+}
+
+J1939MsgEvt *j1939_tp_rx(uint32_t id, uint8_t const *d, uint8_t dlc, uint32_t now_ms) {
+    const uint8_t sa = (uint8_t)id;
+    const uint8_t pf = pf_of(id);
+
+    expire(now_ms);
+
+    if (pf == PF_TP_CM) {
+        if (dlc >= 8U && d[0] == TP_CM_BAM) on_bam(sa, d, now_ms);
+        return NULL;                /* RTS/CTS/abort: not ours */
+    }
+    if (pf == PF_TP_DT) {
+        return (dlc >= 8U) ? on_dt(sa, d, now_ms) : NULL;
+    }
+
+    /* single-frame DM1 */
+    J1939MsgEvt *e = Q_NEW_X(J1939MsgEvt, 1U, J1939_MSG_SIG);
+    if (e == NULL) {
+        ++s_stats.no_mem;
+        return NULL;
+    }
+    e->pgn = J1939_PGN_DM1;
+    e->len = dlc;
+    e->sa  = sa;
+    memcpy(e->data, d, dlc);
+    ++s_stats.done;
+    return e;
+}
+
+uint8_t j1939_dm1_decode(uint8_t const *d, uint16_t len, J1939Dtc *out, uint8_t max) {
+    uint8_t n = 0U;
+    for (uint16_t off = 2U; off + 4U <= len && n < max; off += 4U) {
+        const uint8_t *p = &d[off];
+        const uint32_t spn = p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)(p[2] & 0xE0u) << 11);
+        const uint8_t  fmi = (uint8_t)(p[2] & 0x1Fu);
+        if (spn == 0U && fmi == 0U) continue;          /* "no active DTC" filler */
+        if (spn == 0x7FFFFu) continue;                 /* padding (FF FF FF FF) */
+        out[n].spn = spn;
+        out[n].fmi = fmi;
+        out[n].oc  = (uint8_t)(p[3] & 0x7Fu);
+        ++n;
+    }
+    return n;
+}
+
+J1939TpStats const *j1939_tp_stats(void) { return &s_stats; }
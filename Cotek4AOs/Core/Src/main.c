@@ -47,6 +47,9 @@
 #include "ao_nextion.h"
 #include "ao_cotek.h"
 #include "ao_controller.h"
+#include "ao_input.h"
+#include "app_channels.h"
+#include "j1939_tp.h"
 #include "stm32f1xx_hal.h"
 #include "stm32f1xx_hal_gpio.h"
 #include "stm32f1xx_hal_i2c.h"
@@ -75,6 +78,10 @@ typedef struct {
 
 _Static_assert(sizeof(NextionSummaryEvt) <= UI_POOL_BLOCK_SIZE, "UI pool too small for NextionSummaryEvt");
 _Static_assert(sizeof(NextionDetailsEvt) <= UI_POOL_BLOCK_SIZE, "UI pool too small for NextionDetailsEvt");
+_Static_assert(sizeof(NextionCellsEvt)   <= UI_POOL_BLOCK_SIZE, "UI pool too small for NextionCellsEvt");
+_Static_assert(sizeof(NextionFaultsEvt)  <= UI_POOL_BLOCK_SIZE, "UI pool too small for NextionFaultsEvt");
+_Static_assert(sizeof(J1939MsgEvt) > sizeof(BmsTelemetryEvt) && sizeof(J1939MsgEvt) < UI_POOL_BLOCK_SIZE,
+               "J1939 pool must sit between the BMS and UI pools");
 
 /* Private variables ---------------------------------------------------------*/
 CAN_HandleTypeDef hcan;
@@ -146,17 +153,67 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t len) {
     HAL_UARTEx_ReceiveToIdle_IT(&huart2, s_uart2_rxbuf, sizeof s_uart2_rxbuf);
   }
 }
+#ifdef Q_SPY
+/* Signal names for QSPY; objects and states are named by each AO's initial
+ * transition, the user records in QS_onStartup() */
+static void qs_sig_dictionaries(void) {
+  QS_SIG_DICTIONARY(CAN_RX_SIG, (void *)0);
+  QS_SIG_DICTIONARY(BMS_UPDATED_SIG, (void *)0);
+  QS_SIG_DICTIONARY(BMS_NO_BATTERY_SIG, (void *)0);
+  QS_SIG_DICTIONARY(BMS_CONN_LOST_SIG, (void *)0);
+  QS_SIG_DICTIONARY(TIMEOUT_SIG, (void *)0);
+  QS_SIG_DICTIONARY(CHARGE_TIMEOUT_SIG, (void *)0);
+  QS_SIG_DICTIONARY(PSU_OFF_WAIT_TO_SIG, (void *)0);
+  QS_SIG_DICTIONARY(BMS_TICK_SIG, (void *)0);
+  QS_SIG_DICTIONARY(BMS_WATCHDOG_TO_SIG, (void *)0);
+  QS_SIG_DICTIONARY(LOST_HOLD_TO_SIG, (void *)0);
+  QS_SIG_DICTIONARY(BOOT_SIG, (void *)0);
+  QS_SIG_DICTIONARY(NEX_READY_SIG, (void *)0);
+  QS_SIG_DICTIONARY(NEX_REQ_SHOW_PAGE_SIG, (void *)0);
+  QS_SIG_DICTIONARY(NEX_REQ_UPDATE_SUMMARY_SIG, (void *)0);
+  QS_SIG_DICTIONARY(NEX_REQ_UPDATE_LIVE_SIG, (void *)0);
+  QS_SIG_DICTIONARY(NEX_REQ_UPDATE_DETAILS_SIG, (void *)0);
+  QS_SIG_DICTIONARY(NEX_REQ_UPDATE_PSU_SIG, (void *)0);
+  QS_SIG_DICTIONARY(NEX_REQ_UPDATE_CELLS_SIG, (void *)0);
+  QS_SIG_DICTIONARY(NEX_REQ_UPDATE_FAULTS_SIG, (void *)0);
+  QS_SIG_DICTIONARY(PSU_REQ_SETPOINT_SIG, (void *)0);
+  QS_SIG_DICTIONARY(PSU_REQ_OFF_SIG, (void *)0);
+  QS_SIG_DICTIONARY(PSU_RSP_STATUS_SIG, (void *)0);
+  QS_SIG_DICTIONARY(COTEK_STATUS_SIG, (void *)0);
+  QS_SIG_DICTIONARY(COTEK_TICK_SIG, (void *)0);
+  QS_SIG_DICTIONARY(COTEK_RAMP_SIG, (void *)0);
+  QS_SIG_DICTIONARY(J1939_MSG_SIG, (void *)0);
+  QS_SIG_DICTIONARY(BUTTON_PRESSED_SIG, (void *)0);
+  QS_SIG_DICTIONARY(BUTTON_RELEASED_SIG, (void *)0);
+  QS_SIG_DICTIONARY(BUTTON_LONG_PRESS_SIG, (void *)0);
+  QS_SIG_DICTIONARY(INPUT_EDGE_SIG, (void *)0);
+  QS_SIG_DICTIONARY(INPUT_SAMPLE_SIG, (void *)0);
+  QS_SIG_DICTIONARY(ESTOP_SIG, (void *)0);
+  QS_SIG_DICTIONARY(ESTOP_RELEASE_SIG, (void *)0);
+  QS_SIG_DICTIONARY(HMI_SELECT_SIG, (void *)0);
+  QS_SIG_DICTIONARY(FAULT_HIST_CLEAR_SIG, (void *)0);
+#ifdef ENABLE_BMS_SIM
+  QS_SIG_DICTIONARY(SIM_TICK_SIG, (void *)0);
+#endif
+#ifdef ENABLE_NEX_EMU
+  QS_SIG_DICTIONARY(NEX_EMU_TICK_SIG, (void *)0);
+#endif
+}
+#endif
+
 /**
   * @brief  The application entry point.
   * @retval int
   */
 int main(void)
 {
+  QF_init();   /* QK: registers its idle AO and keeps the scheduler locked until QF_run */
   /* --- construct AOs --- */
   NextionAO_ctor();
   ControllerAO_ctor();
   CotekAO_ctor();
   BmsAO_ctor();
+  InputAO_ctor();
    /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
   HAL_Init();
   /* Ensure priorities are QP-safe *before* anything else runs */
@@ -187,6 +244,12 @@ int main(void)
   printf("main(): UART2 up\r\n");
   BSP_breadcrumb('p');
   HAL_UARTEx_ReceiveToIdle_IT(&huart2, RxBuffer, 256);
+  if (QS_INIT((void *)0) == 0U) {   // Q_SPY: trace buffers + USART2 TX DMA (bsp.c)
+    BSP_die(24);                    // code 24 = QS init failed
+  }
+#ifdef Q_SPY
+  qs_sig_dictionaries();
+#endif
   //BSP_markUart2Ready();
   //BSP_print_banner();
   //printf("\r\nmain(): UART2 up\r\n");
@@ -203,6 +266,7 @@ int main(void)
     /* ---------------- dynamic event pools & pub/sub table --------------------*/
   static QF_MPOOL_EL(CanFrameEvt)     s_canPoolSto[64];
   static QF_MPOOL_EL(BmsTelemetryEvt) s_bmsPoolSto[32];
+  static QF_MPOOL_EL(J1939MsgEvt)     s_tpPoolSto[J1939_TP_MAX_SESSIONS + 2U];   /* reassembly buffers */
   static QSubscrList subscrSto[MAX_PUB_SIG];
   QF_psInit(subscrSto, Q_DIM(subscrSto));
     /* pools: smallest blocks first */
@@ -214,11 +278,13 @@ int main(void)
         QF_poolInit(s_bmsPoolSto, sizeof(s_bmsPoolSto), sizeof(s_bmsPoolSto[0]));
         QF_poolInit(s_canPoolSto, sizeof(s_canPoolSto), sizeof(s_canPoolSto[0]));
   }
+  QF_poolInit(s_tpPoolSto, sizeof(s_tpPoolSto), sizeof(s_tpPoolSto[0]));
     /* UI pool is the largest: init it last */
   QF_poolInit(s_uiPoolSto, sizeof(s_uiPoolSto), UI_POOL_BLOCK_SIZE);
-  printf("pool blocks: CAN=%lu  BMS=%lu  UI=%u\r\n",
+  printf("pool blocks: CAN=%lu  BMS=%lu  TP=%lu  UI=%u\r\n",
        (unsigned long)(sizeof(s_canPoolSto) / sizeof(s_canPoolSto[0])),
        (unsigned long)(sizeof(s_bmsPoolSto) / sizeof(s_bmsPoolSto[0])),
+       (unsigned long)(sizeof(s_tpPoolSto) / sizeof(s_tpPoolSto[0])),
        UI_POOL_BLOCK_SIZE);
 
   printf("main() 3\r\n");
@@ -234,23 +300,37 @@ int main(void)
   NVIC_SetPriority(EXTI15_10_IRQn, 5);
   NVIC_SetPriority(USB_HP_CAN1_TX_IRQn, 5);
   NVIC_SetPriority(USB_LP_CAN1_RX0_IRQn, 5);
+#ifdef APP_USE_QK
+  /* QK preempts from PendSV: it must be the lowest exception (as QK_init set it) */
+  NVIC_SetPriority(PendSV_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL);
+#endif
   BSP_dumpIRQs();
-  // 1) Controller first
-  static QEvt const *ctlQueueSto[64];
-  QACTIVE_START(AO_Controller, 4U, ctlQueueSto, Q_DIM(ctlQueueSto), 0, 0U, 0);
+  // 1) Controllers first (one per bay, see app_channels.h for priorities)
+  static QEvt const *ctlQueueSto[APP_NUM_CHANNELS][64];
+  for (uint8_t ch = 0U; ch < APP_NUM_CHANNELS; ++ch) {
+    QACTIVE_START(AO_ControllerCh[ch], APP_PRIO_CTL(ch), ctlQueueSto[ch], Q_DIM(ctlQueueSto[ch]), 0, 0U, 0);
+  }
   printf("main() CtlAO up\r\n");
   // 2) Nextion second
   static QEvt const *nexQueueSto[128];
-  QACTIVE_START(AO_Nextion, 5U, nexQueueSto, Q_DIM(nexQueueSto), 0, 0U, 0);
+  QACTIVE_START(AO_Nextion, APP_PRIO_NEXTION, nexQueueSto, Q_DIM(nexQueueSto), 0, 0U, 0);
   printf("main() NexAO up\r\n");
   // 3) Cotek
-  static QEvt const *cotekQueueSto[64];
-  QACTIVE_START(AO_Cotek, 2U, cotekQueueSto, Q_DIM(cotekQueueSto), 0, 0U, 0);
+  static QEvt const *cotekQueueSto[APP_NUM_CHANNELS][64];
+  for (uint8_t ch = 0U; ch < APP_NUM_CHANNELS; ++ch) {
+    QACTIVE_START(AO_CotekCh[ch], APP_PRIO_COTEK(ch), cotekQueueSto[ch], Q_DIM(cotekQueueSto[ch]), 0, 0U, 0);
+  }
   printf("main() CotekAO up\r\n");
   // 4) BMS
-  static QEvt const *bmsQueueSto[64];
-  QACTIVE_START(AO_Bms, 3U, bmsQueueSto, Q_DIM(bmsQueueSto), 0, 0U, 0);
+  static QEvt const *bmsQueueSto[APP_NUM_CHANNELS][64];
+  for (uint8_t ch = 0U; ch < APP_NUM_CHANNELS; ++ch) {
+    QACTIVE_START(AO_BmsCh[ch], APP_PRIO_BMS(ch), bmsQueueSto[ch], Q_DIM(bmsQueueSto[ch]), 0, 0U, 0);
+  }
   printf("main() BmsAO up\r\n");
+  // 5) Inputs (button gestures, e-stop release)
+  static QEvt const *inputQueueSto[16];
+  QACTIVE_START(AO_Input, APP_PRIO_INPUT, inputQueueSto, Q_DIM(inputQueueSto), 0, 0U, 0);
+#ifndef Q_UTEST   /* under QUTest the script injects CAN frames and buttons */
   /* Bring up CAN after AOs are running */
   // NOW init + start CAN (bus mode already set to NORMAL in MX_CAN_Init)
   MX_CAN_Init();
@@ -263,6 +343,7 @@ int main(void)
 
   HAL_NVIC_SetPriority(EXTI15_10_IRQn, QF_AWARE_ISR_CMSIS_PRI, 0U);
   HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+#endif
   HAL_UARTEx_ReceiveToIdle_IT(&huart2, RxBuffer, 256);
   printf("main() 8\r\n");
   __set_BASEPRI(0U);
@@ -341,13 +422,28 @@ static void MX_GPIO_Init(void)
     GPIO_InitStruct.Pull  = GPIO_NOPULL;
     HAL_GPIO_Init(LD2_GPIO_Port, &GPIO_InitStruct);
 
-    /*Configure GPIO pin : B1_Pin(PC13) */
+    /*Configure GPIO pin : B1_Pin(PC13), both edges wake AO_Input.
+     * Under QUTest the pins are plain inputs: the script injects the
+     * button and e-stop events, so no EXTI may post behind its back. */
+#ifndef Q_UTEST
+#define GPIO_MODE_INPUT_EDGES  GPIO_MODE_IT_RISING_FALLING
+#else
+#define GPIO_MODE_INPUT_EDGES  GPIO_MODE_INPUT
+#endif
     GPIO_InitStruct.Pin = GPIO_PIN_13;
-    GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+    GPIO_InitStruct.Mode = GPIO_MODE_INPUT_EDGES;
     GPIO_InitStruct.Pull = GPIO_PULLDOWN;
     HAL_GPIO_Init(USER_BTN_GPIO_Port, &GPIO_InitStruct);
+#ifdef ENABLE_ESTOP
+    GPIO_InitStruct.Pin  = ESTOP_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_INPUT_EDGES;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    HAL_GPIO_Init(ESTOP_GPIO_Port, &GPIO_InitStruct);
+#endif
+#ifndef Q_UTEST
     HAL_NVIC_SetPriority(EXTI15_10_IRQn, QF_AWARE_ISR_CMSIS_PRI+1, 0);
     HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+#endif
 
 }
 /**
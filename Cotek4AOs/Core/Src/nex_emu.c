@@ -0,0 +1,334 @@
+// nex_emu.c
+// Nextion HMI emulator: parses the nex_send3() byte stream into a page/component
+// model and measures what the UI path costs (bytes, commands, redundant writes,
+// time until a freshly shown page is fully painted).
+
+#include "nex_emu.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================== Page model ================================ */
+
+#define NEX_EMU_LINE_MAX    160U
+#define NEX_EMU_NAME_MAX    16U
+#define NEX_EMU_PAGE_NONE   0xFFU
+
+typedef struct {
+    char const *name;
+    char const *const *required;   /* objects that must be written after "page" */
+} NexEmuPage;
+
+/* Page ids match NEX_REQ_SHOW_PAGE_SIG: 0=splash,1=wait,2=main,3=details,4=cells,5=faults */
+static char const *const s_req_splash[]  = { "tVer", NULL };
+static char const *const s_req_wait[]    = { NULL };
+static char const *const s_req_main[]    = {
+    "tBattType", "tRecHead", "tVolt", "tErrors", "pWarn", "tPsu", "tOutState", NULL
+};
+static char const *const s_req_details[] = {
+    "tHVolt", "tLVolt", "tAVolt", "tSerialN", "tFW", "tBmsState", "tBmsFault", NULL
+};
+static char const *const s_req_cells[]   = {
+    "tCount", "tMin", "tMax", "tAvg", "tSpread", NULL
+};
+static char const *const s_req_faults[]  = {
+    "tTotal", "f0", "f1", "f2", "f3", "f4", "f5", NULL
+};
+
+static NexEmuPage const s_pages[] = {
+    { "pSplash",  s_req_splash  },
+    { "pWait",    s_req_wait    },
+    { "pMain",    s_req_main    },
+    { "pDetails", s_req_details },
+    { "pCells",   s_req_cells   },
+    { "pFaults",  s_req_faults  },
+};
+#define NEX_EMU_NPAGES  ((uint8_t)(sizeof(s_pages) / sizeof(s_pages[0])))
+
+typedef struct {
+    uint8_t page;                   /* owning page id                        */
+    uint8_t written;                /* painted since the page was last shown */
+    uint8_t vis;
+    char    name[NEX_EMU_NAME_MAX];
+    char    txt[NEX_EMU_TXT_MAX];
+    int32_t bco, pco, val;
+} NexEmuComp;
+
+static struct {
+    NexEmuRxFn  rx;
+    NexEmuComp  comp[NEX_EMU_MAX_COMPS];
+    uint8_t     ncomp;
+    uint8_t     page;
+    uint8_t     settled;
+    uint32_t    page_ms;            /* when the current page was shown */
+
+    char        line[NEX_EMU_LINE_MAX];
+    uint16_t    len;
+    uint8_t     ff;                 /* consecutive 0xFF terminators seen */
+    uint8_t     overflow;
+    uint32_t    now_ms;
+
+    NexEmuStats st;
+    uint32_t    rep_ms, rep_bytes, rep_cmds;
+} s_emu;
+
+/* ================================ Helpers ================================= */
+
+static uint8_t page_by_name(char const *name, size_t n) {
+    for (uint8_t i = 0U; i < NEX_EMU_NPAGES; ++i) {
+        if (strlen(s_pages[i].name) == n && strncmp(s_pages[i].name, name, n) == 0) {
+            return i;
+        }
+    }
+    return NEX_EMU_PAGE_NONE;
+}
+
+static NexEmuComp *comp_find(uint8_t page, char const *name, size_t n, bool create) {
+    if (n == 0U || n >= NEX_EMU_NAME_MAX) return NULL;
+    for (uint8_t i = 0U; i < s_emu.ncomp; ++i) {
+        NexEmuComp *c = &s_emu.comp[i];
+        if (c->page == page && strlen(c->name) == n && strncmp(c->name, name, n) == 0) {
+            return c;
+        }
+    }
+    if (!create || s_emu.ncomp >= NEX_EMU_MAX_COMPS) return NULL;
+    NexEmuComp *c = &s_emu.comp[s_emu.ncomp++];
+    memset(c, 0, sizeof(*c));
+    c->page = page;
+    c->vis  = 1U;
+    memcpy(c->name, name, n);
+    c->name[n] = '\0';
+    return c;
+}
+
+/* "pMain.tVolt" or "tVolt" (current page) -> component */
+static NexEmuComp *comp_ref(char const *obj, size_t n, bool create) {
+    char const *dot = memchr(obj, '.', n);
+    if (dot) {
+        uint8_t const pg = page_by_name(obj, (size_t)(dot - obj));
+        if (pg == NEX_EMU_PAGE_NONE) return NULL;
+        return comp_find(pg, dot + 1, n - (size_t)(dot - obj) - 1U, create);
+    }
+    return comp_find(s_emu.page, obj, n, create);
+}
+
+static void check_settled(void) {
+    if (s_emu.settled || s_emu.page >= NEX_EMU_NPAGES) return;
+    for (char const *const *r = s_pages[s_emu.page].required; *r; ++r) {
+        NexEmuComp const *c = comp_find(s_emu.page, *r, strlen(*r), false);
+        if (!c || !c->written) return;
+    }
+    s_emu.settled = 1U;
+    s_emu.st.settle_last_ms = s_emu.now_ms - s_emu.page_ms;
+    if (s_emu.st.settle_last_ms > s_emu.st.settle_max_ms) {
+        s_emu.st.settle_max_ms = s_emu.st.settle_last_ms;
+    }
+}
+
+/* Count the write, flag it redundant if it did not change a painted object */
+static void note_write(NexEmuComp *c, bool changed) {
+    ++s_emu.st.writes;
+    if (c->page != s_emu.page) {
+        ++s_emu.st.offpage;
+    } else if (!changed && c->written) {
+        ++s_emu.st.redundant;
+    }
+    if (c->page == s_emu.page) {
+        c->written = 1U;
+        check_settled();
+    }
+}
+
+static void show_page(uint8_t pg) {
+    if (!s_emu.settled && s_emu.st.page_changes) ++s_emu.st.unsettled;
+    ++s_emu.st.page_changes;
+    s_emu.page    = pg;
+    s_emu.page_ms = s_emu.now_ms;
+    s_emu.settled = 0U;
+    for (uint8_t i = 0U; i < s_emu.ncomp; ++i) {
+        if (s_emu.comp[i].page == pg) s_emu.comp[i].written = 0U;
+    }
+    check_settled();
+}
+
+/* 0x66 page event back through the RX hook, like "sendme" on the panel */
+static void send_page(void) {
+    if (s_emu.rx) {
+        uint8_t const ev[5] = { 0x66U, s_emu.page, 0xFFU, 0xFFU, 0xFFU };
+        s_emu.rx(ev, (uint16_t)sizeof(ev));
+    }
+}
+
+/* ================================ Parsing ================================= */
+
+static bool exec_assign(char *lhs, char *rhs) {
+    char *attr = strrchr(lhs, '.');
+    if (!attr) {
+        return (strcmp(lhs, "bkcmd") == 0) || (strcmp(lhs, "dim") == 0);   /* system vars */
+    }
+    *attr++ = '\0';
+    NexEmuComp *c = comp_ref(lhs, strlen(lhs), true);
+    if (!c) return false;
+
+    if (strcmp(attr, "txt") == 0) {
+        char *v = rhs;
+        size_t n = strlen(v);
+        if (n >= 2U && v[0] == '"' && v[n - 1U] == '"') { ++v; n -= 2U; }
+        if (n >= NEX_EMU_TXT_MAX) n = NEX_EMU_TXT_MAX - 1U;
+        bool const changed = (strncmp(c->txt, v, n) != 0) || (c->txt[n] != '\0');
+        memcpy(c->txt, v, n);
+        c->txt[n] = '\0';
+        note_write(c, changed);
+        return true;
+    }
+
+    int32_t *slot = NULL;
+    if      (strcmp(attr, "bco") == 0) slot = &c->bco;
+    else if (strcmp(attr, "pco") == 0) slot = &c->pco;
+    else if (strcmp(attr, "val") == 0) slot = &c->val;
+    if (!slot) return false;
+
+    int32_t const v = (int32_t)strtol(rhs, NULL, 10);
+    bool const changed = (*slot != v);
+    *slot = v;
+    note_write(c, changed);
+    return true;
+}
+
+static bool exec_line(char *s) {
+    if (strncmp(s, "page ", 5) == 0) {
+        char const *name = s + 5;
+        uint8_t pg = page_by_name(name, strlen(name));
+        if (pg == NEX_EMU_PAGE_NONE && name[0] >= '0' && name[0] <= '9') {
+            pg = (uint8_t)atoi(name);
+        }
+        if (pg >= NEX_EMU_NPAGES) return false;
+        show_page(pg);          /* commanded: the panel does not report it back */
+        return true;
+    }
+    if (strcmp(s, "sendme") == 0) {
+        send_page();
+        return true;
+    }
+    if (strncmp(s, "vis ", 4) == 0) {
+        char *comma = strchr(s + 4, ',');
+        if (!comma) return false;
+        NexEmuComp *c = comp_ref(s + 4, (size_t)(comma - (s + 4)), true);
+        if (!c) return false;
+        uint8_t const v = (uint8_t)(atoi(comma + 1) != 0);
+        bool const changed = (c->vis != v);
+        c->vis = v;
+        note_write(c, changed);
+        return true;
+    }
+    if (strncmp(s, "ref ", 4) == 0) {
+        ++s_emu.st.refs;
+        return comp_ref(s + 4, strlen(s + 4), true) != NULL;
+    }
+    if (strcmp(s, "rest") == 0) {
+        /* HMI reboot: drop the screen model, keep the counters */
+        memset(s_emu.comp, 0, sizeof(s_emu.comp));
+        s_emu.ncomp   = 0U;
+        s_emu.page    = 0U;
+        s_emu.settled = 1U;
+        return true;
+    }
+    char *eq = strchr(s, '=');
+    if (eq) {
+        *eq = '\0';
+        return exec_assign(s, eq + 1);
+    }
+    return false;
+}
+
+/* ================================== API =================================== */
+
+void NexEmu_init(NexEmuRxFn rx) {
+    memset(&s_emu, 0, sizeof(s_emu));
+    s_emu.rx      = rx;
+    s_emu.page    = 0U;      /* the HMI boots into pSplash */
+    s_emu.settled = 1U;
+}
+
+void NexEmu_reset(void) {
+    NexEmu_init(s_emu.rx);
+}
+
+void NexEmu_feed(uint8_t const *buf, uint16_t len, uint32_t now_ms) {
+    s_emu.now_ms = now_ms;
+    s_emu.st.bytes += len;
+    for (uint16_t i = 0U; i < len; ++i) {
+        uint8_t const b = buf[i];
+        if (b == 0xFFU) {
+            if (++s_emu.ff < 3U) continue;
+            s_emu.line[s_emu.len] = '\0';
+            ++s_emu.st.cmds;
+            if (s_emu.overflow || !exec_line(s_emu.line)) {
+                ++s_emu.st.unknown;
+            }
+            s_emu.len = 0U; s_emu.ff = 0U; s_emu.overflow = 0U;
+            continue;
+        }
+        s_emu.ff = 0U;
+        if (s_emu.len < NEX_EMU_LINE_MAX - 1U) {
+            s_emu.line[s_emu.len++] = (char)b;
+        } else {
+            s_emu.overflow = 1U;
+        }
+    }
+}
+
+void NexEmu_touch(uint8_t page, uint8_t comp, bool press) {
+    if (!s_emu.rx) return;
+    uint8_t const ev[7] = { 0x65U, page, comp, press ? 1U : 0U, 0xFFU, 0xFFU, 0xFFU };
+    s_emu.rx(ev, (uint16_t)sizeof(ev));
+}
+
+void NexEmu_gotoPage(uint8_t page) {
+    if (page >= NEX_EMU_NPAGES) return;
+    show_page(page);
+#if NEX_EMU_SENDME
+    send_page();
+#endif
+}
+
+uint8_t NexEmu_page(void)        { return s_emu.page; }
+bool    NexEmu_isConsistent(void) { return s_emu.settled != 0U; }
+
+char const *NexEmu_getTxt(char const *obj) {
+    NexEmuComp const *c = comp_ref(obj, strlen(obj), false);
+    return c ? c->txt : NULL;
+}
+
+int32_t NexEmu_getVal(char const *obj, char const *attr) {
+    NexEmuComp const *c = comp_ref(obj, strlen(obj), false);
+    if (!c) return -1;
+    if (strcmp(attr, "bco") == 0) return c->bco;
+    if (strcmp(attr, "pco") == 0) return c->pco;
+    if (strcmp(attr, "vis") == 0) return c->vis;
+    return c->val;
+}
+
+NexEmuStats const *NexEmu_stats(void) { return &s_emu.st; }
+
+void NexEmu_report(uint32_t now_ms) {
+    uint32_t const dt = now_ms - s_emu.rep_ms;
+    if (dt == 0U) return;
+    uint32_t const db = s_emu.st.bytes - s_emu.rep_bytes;
+    uint32_t const dc = s_emu.st.cmds  - s_emu.rep_cmds;
+    s_emu.rep_ms    = now_ms;
+    s_emu.rep_bytes = s_emu.st.bytes;
+    s_emu.rep_cmds  = s_emu.st.cmds;
+
+    printf("NEXEMU: %lu B/s %lu cmd/s | page=%s %s | writes=%lu redundant=%lu offpage=%lu "
+           "refs=%lu unknown=%lu | settle last=%lu ms max=%lu ms unsettled=%lu\r\n",
+           (unsigned long)(db * 1000U / dt), (unsigned long)(dc * 1000U / dt),
+           (s_emu.page < NEX_EMU_NPAGES) ? s_pages[s_emu.page].name : "?",
+           s_emu.settled ? "consistent" : "painting",
+           (unsigned long)s_emu.st.writes, (unsigned long)s_emu.st.redundant,
+           (unsigned long)s_emu.st.offpage, (unsigned long)s_emu.st.refs,
+           (unsigned long)s_emu.st.unknown,
+           (unsigned long)s_emu.st.settle_last_ms, (unsigned long)s_emu.st.settle_max_ms,
+           (unsigned long)s_emu.st.unsettled);
+}
@@ -48,10 +48,12 @@ extern UART_HandleTypeDef huart3;
 /**
   * @brief This function handles Non maskable interrupt.
   */
+#ifndef APP_USE_QK   /* QK's port returns from PendSV through NMI (qk_port.c) */
 void NMI_Handler(void)
 {
    while (1)  {  }
 }
+#endif
 /**
   * @brief This function handles Hard fault interrupt.
   */
@@ -95,16 +97,23 @@ void DebugMon_Handler(void)
 /**
   * @brief This function handles Pendable request for system service.
   */
+#ifndef APP_USE_QK   /* QK's port owns PendSV for preemption (qk_port.c) */
 void PendSV_Handler(void)
 {
 }
+#endif
 static void EXTI15_10_NVIC_QPaware(void) {
   HAL_NVIC_SetPriority(EXTI15_10_IRQn, QF_AWARE_ISR_CMSIS_PRI, 0);
   HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
 }
 void EXTI15_10_IRQHandler(void) {
+  BSP_ISR_ENTRY();
   HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_13);  // PC13 callback
+#ifdef ENABLE_ESTOP
+  HAL_GPIO_EXTI_IRQHandler(ESTOP_Pin);    // PB12 e-stop loop
+#endif
   EXTI15_10_NVIC_QPaware();
+  BSP_ISR_EXIT();
 }
 /**
   * @brief This function handles System tick timer.
@@ -122,7 +131,9 @@ void EXTI15_10_IRQHandler(void) {
   */
 void USB_HP_CAN1_TX_IRQHandler(void)
 {
+  BSP_ISR_ENTRY();
   HAL_CAN_IRQHandler(&hcan);
+  BSP_ISR_EXIT();
 }
 
 /**
@@ -130,35 +141,51 @@ void USB_HP_CAN1_TX_IRQHandler(void)
   */
 void USB_LP_CAN1_RX0_IRQHandler(void)
 {
+  BSP_ISR_ENTRY();
   HAL_CAN_IRQHandler(&hcan);
+  BSP_ISR_EXIT();
 }
 /**
   * @brief This function handles CAN RX1 interrupt.
   */
 void CAN1_RX1_IRQHandler(void)
 {
+  BSP_ISR_ENTRY();
   HAL_CAN_IRQHandler(&hcan);
+  BSP_ISR_EXIT();
 }
 /**
   * @brief This function handles I2C1 event interrupt.
   */
 void I2C1_EV_IRQHandler(void)
 {
+  BSP_ISR_ENTRY();
   HAL_I2C_EV_IRQHandler(&hi2c1);
+  BSP_ISR_EXIT();
 }
 /**
   * @brief This function handles I2C1 error interrupt.
   */
 void I2C1_ER_IRQHandler(void)
 {
+  BSP_ISR_ENTRY();
   HAL_I2C_ER_IRQHandler(&hi2c1);
+  BSP_ISR_EXIT();
 }
 
 void USART2_IRQHandler(void) {
+  BSP_ISR_ENTRY();
+#ifdef Q_SPY
+  BSP_qsUart2Isr();                 // QSPY commands, bsp.c
+#else
   HAL_UART_IRQHandler(&huart2);
+#endif
+  BSP_ISR_EXIT();
 }
 void USART3_IRQHandler(void) {
+  BSP_ISR_ENTRY();
   HAL_UART_IRQHandler(&huart3);
+  BSP_ISR_EXIT();
 }
 
 
@@ -54,6 +54,10 @@
 // QF "thread" type used to store the MPU settings in the AO
 #define QACTIVE_THREAD_TYPE     void const *
 
+#ifndef QF_MAX_EPOOL
+#define QF_MAX_EPOOL  4U   /* must be >= number of QF_poolInit() you call */
+#endif
+
 // QF interrupt disable/enable and log2()...
 #if (__ARM_ARCH == 6) // ARMv6-M?
 
@@ -98,10 +102,14 @@
         __asm volatile ("msr BASEPRI,%0" :: "r" (basepri_) : "memory")
 
     // BASEPRI threshold for "QF-aware" interrupts, see NOTE3
-    #define QF_BASEPRI          0x3F
+#ifndef QF_BASEPRI
+#define QF_BASEPRI          0x50    /* 0x50 >> (8-4) = 5 */
+#endif
 
     // CMSIS threshold for "QF-aware" interrupts, see NOTE5
-    #define QF_AWARE_ISR_CMSIS_PRI (QF_BASEPRI >> (8 - __NVIC_PRIO_BITS))
+#ifndef QF_AWARE_ISR_CMSIS_PRI
+#define QF_AWARE_ISR_CMSIS_PRI (QF_BASEPRI >> (8 - __NVIC_PRIO_BITS))
+#endif
 
     // ARMv7-M or higher provide the CLZ instruction for fast LOG2
     #define QF_LOG2(n_) ((uint_fast8_t)(32 - __builtin_clz((unsigned)(n_))))
@@ -55,7 +55,7 @@
 #define QACTIVE_THREAD_TYPE     void const *
 
 #ifndef QF_MAX_EPOOL
-#define QF_MAX_EPOOL  3U   /* must be >= number of QF_poolInit() you call */
+#define QF_MAX_EPOOL  4U   /* must be >= number of QF_poolInit() you call */
 #endif
 
 // QF interrupt disable/enable and log2()...
@@ -0,0 +1,109 @@
+// bay_bench.c
+// Host benchmark for multi-bay CAN routing (App_routeCanId), built once per
+// bay count. Replays the per-pack frame mix of every bay -- master plus slave
+// nodes on the 400s cell pages, 500s J1939 frames -- and checks that every
+// frame reaches its own bay with the node id it was sent from, that strangers
+// are dropped, then times the routing step.
+// Exit status is the number of misrouted frames.
+
+#include "app_channels.h"
+
+#include <stdio.h>
+#include <time.h>
+
+/* app_channels.c links against these; the benchmark never posts */
+QActive *AO_ControllerCh[APP_NUM_CHANNELS];
+bool QActive_post_(QActive * const me, QEvt const * const e,
+                   uint_fast16_t const margin, void const * const sender) {
+    (void)me; (void)e; (void)margin; (void)sender;
+    return true;
+}
+
+#define BENCH_NODES     4U          /* master + 3 slaves per pack */
+#define BENCH_ROUNDS    2000000UL
+
+typedef struct {
+    uint32_t base;      /* id with SA byte 0 */
+    uint16_t per_s;     /* frames per second per node (or per pack) */
+    uint8_t  per_node;  /* sent by every node, else by the master only */
+} BenchFrame;
+
+/* one pack's traffic (cyclic rates as seen on the bench) */
+static BenchFrame const k_mix[] = {
+    { 0x18000800u, 10U, 1U },   /* 400s cell page A */
+    { 0x18010800u, 10U, 1U },   /* 400s cell page B */
+    { 0x18070800u, 10U, 0U },
+    { 0x18060800u, 10U, 0U },
+    { 0x180C0800u, 10U, 0U },
+    { 0x18040A00u,  1U, 0U },   /* serial / firmware / type */
+    { 0x18FF4000u,  1U, 0U },   /* 500s HYP serial */
+    { 0x18FF1900u,  1U, 0U },
+};
+#define N_MIX  (sizeof(k_mix) / sizeof(k_mix[0]))
+
+static uint32_t sa_of(uint8_t ch, uint8_t node) {
+    return (APP_NUM_CHANNELS == 1U) ? node : (uint32_t)g_appChannels[ch].can_sa + node;
+}
+
+int main(void) {
+    static uint32_t ids[APP_NUM_CHANNELS * N_MIX * BENCH_NODES];
+    static uint8_t  want_ch[sizeof(ids) / sizeof(ids[0])];
+    static uint8_t  want_node[sizeof(ids) / sizeof(ids[0])];
+    unsigned n = 0U, bad = 0U;
+    uint32_t offered = 0U;
+
+    for (uint8_t ch = 0U; ch < APP_NUM_CHANNELS; ++ch) {
+        for (size_t k = 0U; k < N_MIX; ++k) {
+            uint8_t const nodes = k_mix[k].per_node ? BENCH_NODES : 1U;
+            for (uint8_t nd = 0U; nd < nodes; ++nd) {
+                ids[n]       = k_mix[k].base | sa_of(ch, nd);
+                want_ch[n]   = ch;
+                want_node[n] = nd;
+                offered     += k_mix[k].per_s;
+                ++n;
+            }
+        }
+    }
+
+    /* every frame to its own bay, node id preserved */
+    for (unsigned i = 0U; i < n; ++i) {
+        uint32_t id = 0U;
+        uint8_t const ch = App_routeCanId(ids[i], &id);
+        if (ch != want_ch[i] || (id & 0xFFu) != want_node[i]
+            || (id & ~0xFFu) != (ids[i] & ~0xFFu)) {
+            printf("MISROUTE id=0x%08lX -> bay %u node %u (want bay %u node %u)\n",
+                   (unsigned long)ids[i], (unsigned)ch, (unsigned)(id & 0xFFu),
+                   (unsigned)want_ch[i], (unsigned)want_node[i]);
+            ++bad;
+        }
+    }
+    /* a source address outside every bay's block is dropped */
+    if (APP_NUM_CHANNELS > 1U) {
+        uint32_t id;
+        if (App_routeCanId(0x18000800u | 0xF0u, &id) != APP_NUM_CHANNELS) {
+            printf("MISROUTE: stranger SA 0xF0 was accepted\n");
+            ++bad;
+        }
+    }
+
+    /* timing: route the whole mix BENCH_ROUNDS / n times */
+    struct timespec t0, t1;
+    volatile uint32_t sink = 0U;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned long r = 0UL; r < BENCH_ROUNDS; ++r) {
+        uint32_t id;
+        uint8_t const ch = App_routeCanId(ids[r % n], &id);
+        sink += ch + id;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double const ns = ((double)(t1.tv_sec - t0.tv_sec) * 1e9
+                     + (double)(t1.tv_nsec - t0.tv_nsec)) / (double)BENCH_ROUNDS;
+
+    printf("bays=%u ids=%u offered=%lu frames/s (%lu per bay) route=%.1f ns/frame "
+           "(host) -> %.4f%% of one host core at the offered load, misrouted=%u\n",
+           (unsigned)APP_NUM_CHANNELS, n, (unsigned long)offered,
+           (unsigned long)(offered / APP_NUM_CHANNELS), ns,
+           ns * (double)offered / 1e7, bad);
+    (void)sink;
+    return (int)bad;
+}
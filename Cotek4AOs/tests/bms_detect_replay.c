@@ -0,0 +1,119 @@
+// bms_detect_replay.c
+// Replays the CAN sniffer captures in BMS_Simulator/ through the frame
+// parsers and the family detector, as AO_Bms runs them: every frame parsed
+// on arrival, the Vpack/Vcell evidence at 10 Hz, a new session after
+// BMS_WATCH_MS without a frame. Reports time-to-lock and the wrong first
+// guesses / re-locks per capture.
+// Arguments: pairs of <expected type code> <capture>, e.g. 0x0600 600s.txt.
+// Exit status is the number of captures that locked to a wrong family or
+// never locked.
+
+#include "bms_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_TICK_MS     100U     /* BMS_TICK_HZ */
+#define REPLAY_WATCH_MS   1500U     /* BMS_WATCH_MS */
+
+typedef struct {
+    BmsDetect    det;
+    BmsNodeTable nodes;
+    BmsCellMap   cells;
+    BmsTelemetry snap;
+    uint8_t      have;      /* a frame parsed this session */
+    uint8_t      lock;      /* last lock seen, to count wrong ones once */
+    uint32_t     last_rx_ms, next_tick_ms;
+    unsigned     frames, wrong_locks;
+} Replay;
+
+static void session_reset(Replay *r) {
+    memset(&r->snap, 0, sizeof(r->snap));
+    bms_detect_reset(&r->det);
+    bms_nodes_reset(&r->nodes);
+    bms_cells_reset(&r->cells);
+    r->have = 0U;
+    r->lock = 0U;
+}
+
+static void check_lock(Replay *r, uint16_t want) {
+    if (r->det.lock == 0U || r->det.lock == r->lock) return;
+    r->lock = r->det.lock;
+    uint16_t const got = bms_detect_current(&r->det);
+    if (got != want) {
+        printf("  WRONG LOCK: %s (0x%04X) after %u frames\n",
+               bms_type_str(got), (unsigned)got, r->frames);
+        ++r->wrong_locks;
+    }
+}
+
+/* "<ms>,<us>,<ide>,<rtr>,0x<id>,<dlc>,<b0>,..,<b7>"; 0 for anything else */
+static int parse_line(char const *s, uint32_t *ms, uint32_t *id, uint8_t *dlc, uint8_t *d) {
+    unsigned long t, us, x;
+    unsigned ide, rtr, n;
+    int used;
+    while (*s == ',') ++s;      /* a stray separator in front of a few lines */
+    if (sscanf(s, "%lu,%lu,%u,%u,%lx,%u%n", &t, &us, &ide, &rtr, &x, &n, &used) != 6) return 0;
+    if (ide != 1U || rtr != 0U || n > 8U) return 0;
+    s += used;
+    for (unsigned k = 0U; k < n; ++k) {
+        unsigned b;
+        if (sscanf(s, ",%x%n", &b, &used) != 1) return 0;
+        d[k] = (uint8_t)b;
+        s += used;
+    }
+    *ms = (uint32_t)t; *id = (uint32_t)x; *dlc = (uint8_t)n;
+    return 1;
+}
+
+static int replay(char const *path, uint16_t want) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        printf("%s: cannot open\n", path);
+        return 1;
+    }
+    static Replay r;
+    memset(&r, 0, sizeof(r));
+    bms_detect_init(&r.det);
+    session_reset(&r);
+
+    char line[160];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        uint32_t ms, id;
+        uint8_t dlc, d[8];
+        if (!parse_line(line, &ms, &id, &dlc, d)) continue;
+
+        if (r.have && (ms - r.last_rx_ms) > REPLAY_WATCH_MS) session_reset(&r);
+        for (; r.have && (int32_t)(ms - r.next_tick_ms) >= 0; r.next_tick_ms += REPLAY_TICK_MS) {
+            (void)bms_detect_by_voltage(&r.det, &r.snap, r.next_tick_ms);
+            check_lock(&r, want);
+        }
+        if (bms_parse_frame(&r.det, &r.nodes, &r.cells, id, dlc, d, &r.snap, ms)) {
+            if (!r.have) r.next_tick_ms = ms + REPLAY_TICK_MS;
+            r.have = 1U;
+            r.last_rx_ms = ms;
+            ++r.frames;
+            check_lock(&r, want);
+        }
+    }
+    fclose(f);
+
+    BmsDetectStats const *st = bms_detect_stats(&r.det);
+    printf("%-16s %6u frames  locks %lu  ttl min/avg/max %lu/%lu/%lu ms  "
+           "wrong-first %lu  relocks %lu  wrong locks %u\n",
+           bms_type_str(want), r.frames, (unsigned long)st->locks,
+           (unsigned long)(st->locks ? st->ttl_min_ms : 0U),
+           (unsigned long)(st->locks ? st->ttl_sum_ms / st->locks : 0U),
+           (unsigned long)st->ttl_max_ms,
+           (unsigned long)st->wrong_guess, (unsigned long)st->relocks, r.wrong_locks);
+    return (st->locks == 0U || r.wrong_locks != 0U) ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    int fail = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        fail += replay(argv[i + 1], (uint16_t)strtoul(argv[i], NULL, 0));
+    }
+    return fail;
+}
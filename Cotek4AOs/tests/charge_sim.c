@@ -0,0 +1,203 @@
+// charge_sim.c
+// Host simulation of the CC/CV charge engine against a simple pack + PSU model.
+// Checks the PRECHARGE -> CC -> CV -> DONE sequence and the FAULT exits, and
+// compares time-to-full with the old fixed profile (48 V, 1 A Recoverable /
+// 3 A Operational, stopped by the 30 s tCharge and restarted by the user).
+// Exit status is the number of failed checks.
+
+#include "charge_profile.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_DT_MS       1000U
+#define SIM_MAX_S       (12U * 3600U)
+#define SIM_CELLS       11U
+#define SIM_R_PACK      0.12f       /* ohm, cells + harness */
+#define SIM_IMBAL_V     0.015f      /* high/low cell offset from the mean */
+#define FIXED_SESSION_S 30U         /* old hard tCharge */
+
+static unsigned s_fail;
+
+#define CHECK(cond_) do { \
+    if (!(cond_)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond_); ++s_fail; } \
+} while (0)
+
+/* Li-ion open-circuit voltage per cell over state of charge (piecewise linear) */
+static float ocv(float soc) {
+    static float const pts[][2] = {
+        { 0.00f, 2.80f }, { 0.02f, 3.20f }, { 0.10f, 3.50f },
+        { 0.90f, 4.00f }, { 1.00f, 4.15f },
+    };
+    if (soc <= 0.0f) return pts[0][1];
+    for (size_t i = 1U; i < sizeof(pts) / sizeof(pts[0]); ++i) {
+        if (soc <= pts[i][0]) {
+            float const f = (soc - pts[i - 1U][0]) / (pts[i][0] - pts[i - 1U][0]);
+            return pts[i - 1U][1] + f * (pts[i][1] - pts[i - 1U][1]);
+        }
+    }
+    return pts[4][1];
+}
+
+typedef struct {
+    float soc, cap_Ah;
+    float vset, iset;      /* PSU setpoint, 0/0 = off */
+    float v, i;            /* PSU terminal readback */
+    float peak_cell_V;
+} Sim;
+
+/* CC/CV source into (OCV + R): current limited first, then voltage */
+static void sim_step(Sim *s, float dt_s) {
+    float const e = ocv(s->soc) * (float)SIM_CELLS;
+    float i = 0.0f;
+    if (s->iset > 0.0f && s->vset > e) {
+        i = fminf(s->iset, (s->vset - e) / SIM_R_PACK);
+    }
+    s->i = i;
+    s->v = (i > 0.0f) ? e + i * SIM_R_PACK : e;
+    s->soc = fminf(1.0f, s->soc + i * dt_s / 3600.0f / s->cap_Ah);
+    float const cell = s->v / (float)SIM_CELLS + SIM_IMBAL_V;
+    if (cell > s->peak_cell_V) s->peak_cell_V = cell;
+}
+
+static void sim_inputs(Sim const *s, ChargeInputs *in) {
+    float const mean = s->v / (float)SIM_CELLS;
+    in->high_cell_V = mean + SIM_IMBAL_V;
+    in->low_cell_V  = mean - SIM_IMBAL_V;
+    in->pack_V      = s->v;
+    in->bms_I_A     = s->i;
+    in->psu_V       = s->v;
+    in->psu_I       = s->i;
+    in->psu_on      = s->iset > 0.0f;
+}
+
+/* Run the engine to DONE/FAULT; returns seconds, records the stage order */
+static uint32_t run_engine(Sim *s, uint16_t type, bool recoverable,
+                           ChargeStage *order, size_t *norder, char const **why) {
+    ChargeEngine ce;
+    ChargeInputs in;
+    uint32_t t_ms = 0U;
+    memset(&ce, 0, sizeof(ce));
+    *norder = 0U;
+    charge_start(&ce, type, recoverable, t_ms);
+    for (uint32_t t = 0U; t < SIM_MAX_S; ++t, t_ms += SIM_DT_MS) {
+        sim_inputs(s, &in);
+        if (charge_step(&ce, &in, t_ms)) {
+            s->vset = ce.vset;
+            s->iset = ce.iset;
+        }
+        if (*norder == 0U || order[*norder - 1U] != ce.stage) {
+            if (*norder < 8U) order[(*norder)++] = ce.stage;
+        }
+        if (ce.stage == CHG_STAGE_DONE || ce.stage == CHG_STAGE_FAULT) {
+            *why = ce.why;
+            return t;
+        }
+        sim_step(s, (float)SIM_DT_MS / 1000.0f);
+    }
+    *why = "sim time limit";
+    return SIM_MAX_S;
+}
+
+/* Old fixed profile: 48 V at 1 A or 3 A in 30 s sessions, restarted at once.
+ * 48 V is above a full pack's OCV, so it never tapers: time it to the state of
+ * charge the engine finished at */
+static uint32_t run_fixed(Sim *s, float i_set, float soc_full, uint32_t *sessions) {
+    *sessions = 0U;
+    for (uint32_t t = 0U; t < SIM_MAX_S; ++t) {
+        if (t % FIXED_SESSION_S == 0U) ++*sessions;
+        s->vset = 48.0f;
+        s->iset = i_set;
+        sim_step(s, 1.0f);
+        if (s->soc >= soc_full) return t;
+    }
+    return SIM_MAX_S;
+}
+
+static void test_recoverable_to_done(void) {
+    Sim s = { .soc = 0.005f, .cap_Ah = 10.0f };
+    ChargeStage order[8];
+    size_t n;
+    char const *why;
+    uint32_t const t = run_engine(&s, 0x0400U, true, order, &n, &why);
+
+    CHECK(n == 4U);
+    CHECK(order[0] == CHG_STAGE_PRECHARGE);
+    CHECK(order[1] == CHG_STAGE_CC);
+    CHECK(order[2] == CHG_STAGE_CV);
+    CHECK(order[3] == CHG_STAGE_DONE);
+    CHECK(why != NULL && strcmp(why, "taper current reached") == 0);
+    CHECK(s.peak_cell_V < charge_profile_for(0x0400U)->cell_abort_V);
+    CHECK(t < (uint32_t)charge_profile_for(0x0400U)->max_total_min * 60U);
+
+    Sim f = { .soc = 0.005f, .cap_Ah = 10.0f };
+    uint32_t sessions;
+    uint32_t const tf = run_fixed(&f, 1.0f, s.soc, &sessions);
+    printf("recoverable 10 Ah: engine %lu s to %.0f%% (peak cell %.3f V) | "
+           "fixed 1 A %lu s to %.0f%% in %lu sessions (peak cell %.3f V)\n",
+           (unsigned long)t, (double)(s.soc * 100.0f), (double)s.peak_cell_V,
+           (unsigned long)tf, (double)(f.soc * 100.0f), (unsigned long)sessions,
+           (double)f.peak_cell_V);
+    CHECK(t < tf);
+}
+
+static void test_operational_to_done(void) {
+    Sim s = { .soc = 0.60f, .cap_Ah = 10.0f };
+    ChargeStage order[8];
+    size_t n;
+    char const *why;
+    uint32_t const t = run_engine(&s, 0x0500U, false, order, &n, &why);
+
+    CHECK(n == 3U);
+    CHECK(order[0] == CHG_STAGE_CC);
+    CHECK(order[1] == CHG_STAGE_CV);
+    CHECK(order[2] == CHG_STAGE_DONE);
+    CHECK(s.peak_cell_V < charge_profile_for(0x0500U)->cell_abort_V);
+
+    Sim f = { .soc = 0.60f, .cap_Ah = 10.0f };
+    uint32_t sessions;
+    uint32_t const tf = run_fixed(&f, 3.0f, s.soc, &sessions);
+    printf("operational 10 Ah: engine %lu s to %.0f%% (peak cell %.3f V) | "
+           "fixed 3 A %lu s to %.0f%% in %lu sessions (peak cell %.3f V)\n",
+           (unsigned long)t, (double)(s.soc * 100.0f), (double)s.peak_cell_V,
+           (unsigned long)tf, (double)(f.soc * 100.0f), (unsigned long)sessions,
+           (double)f.peak_cell_V);
+}
+
+static void test_faults(void) {
+    ChargeEngine ce;
+    ChargeInputs in = { .high_cell_V = 3.9f, .low_cell_V = 3.85f, .pack_V = 42.6f,
+                        .bms_I_A = 0.0f, .psu_V = 0.0f, .psu_I = 0.0f, .psu_on = false };
+
+    /* unknown family: refused at start, nothing to program */
+    charge_start(&ce, 0x0123U, false, 0U);
+    CHECK(ce.stage == CHG_STAGE_FAULT);
+    CHECK(!charge_step(&ce, &in, 1000U));
+
+    /* a cell over the abort limit ends CC with a zero setpoint */
+    charge_start(&ce, 0x0400U, false, 0U);
+    CHECK(charge_step(&ce, &in, 0U) && ce.stage == CHG_STAGE_CC);
+    in.high_cell_V = 4.25f;
+    CHECK(charge_step(&ce, &in, 1000U));
+    CHECK(ce.stage == CHG_STAGE_FAULT && ce.vset == 0.0f && ce.iset == 0.0f);
+    CHECK(strcmp(ce.why, "cell over-voltage") == 0);
+
+    /* a dead cell never leaves pre-charge */
+    ChargeProfile const *p = charge_profile_for(0x0600U);
+    in.high_cell_V = 3.2f;
+    in.low_cell_V  = 1.5f;
+    charge_start(&ce, 0x0600U, true, 0U);
+    CHECK(charge_step(&ce, &in, 0U) && ce.stage == CHG_STAGE_PRECHARGE && ce.iset == p->i_pre_A);
+    CHECK(!charge_step(&ce, &in, (uint32_t)p->pre_max_s * 1000U - 1U));
+    CHECK(charge_step(&ce, &in, (uint32_t)p->pre_max_s * 1000U));
+    CHECK(ce.stage == CHG_STAGE_FAULT && strcmp(ce.why, "pre-charge timeout") == 0);
+}
+
+int main(void) {
+    test_recoverable_to_done();
+    test_operational_to_done();
+    test_faults();
+    printf("%s (%u failed)\n", s_fail ? "FAILED" : "OK", s_fail);
+    return (int)s_fail;
+}
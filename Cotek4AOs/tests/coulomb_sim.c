@@ -0,0 +1,89 @@
+// coulomb_sim.c
+// Host simulation of the coulomb counter against a 2 Hz BMS that reports an
+// integer SoC. Checks that the counted SoC keeps moving between the BMS 1 %
+// steps instead of mirroring the BMS, and that the step corrections still
+// hold a miscalibrated current reading near the true charge.
+// Exit status is the number of failed checks.
+
+#include "coulomb.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#define SIM_DT_MS      500U         /* BMS_UPDATED_SIG rate */
+#define SIM_SAMPLES    7200U        /* one hour */
+#define SIM_CAP_MAH    50000U
+#define SIM_I_MA       3000         /* CC, about 10 min per percent */
+#define SIM_SOC0       40.3         /* true SoC at the start, % */
+
+static unsigned s_fail;
+
+#define CHECK(cond_) do { \
+    if (!(cond_)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond_); ++s_fail; } \
+} while (0)
+
+/* counted SoC in % with the resolution the counter really has */
+static double fine_pct(Coulomb const *c) {
+    return (double)c->pack_mAms * 100.0 / ((double)c->cap_mAh * 3600000.0);
+}
+
+/* One charge hour; gain scales the current the counter sees (shunt error). */
+static void run(char const *name, double gain) {
+    Coulomb c;
+    double truth = SIM_SOC0;
+    uint8_t bms = (uint8_t)lround(truth);
+    coulomb_start(&c, SIM_CAP_MAH, bms, 0U);
+
+    unsigned same = 0U, plateaus = 0U;
+    double lo = 1e9, hi = -1e9, span_min = 1e9, err_max = 0.0;
+    uint8_t steps = 0U;
+    for (uint32_t n = 0U; n < SIM_SAMPLES; ++n) {
+        uint32_t const now = n * SIM_DT_MS;
+        truth += (double)SIM_I_MA * SIM_DT_MS / 3600000.0 * 100.0 / SIM_CAP_MAH;
+        uint8_t const rep = (uint8_t)lround(truth);
+        coulomb_sample(&c, (int32_t)lround(SIM_I_MA * gain), 48000, now);
+        if (rep != bms) {
+            /* a plateau seen from edge to edge: how far did the count move on it */
+            if (steps > 0U) {
+                if (hi - lo < span_min) span_min = hi - lo;
+                ++plateaus;
+            }
+            ++steps;
+            lo = 1e9; hi = -1e9;
+        }
+        bms = rep;
+        coulomb_correct(&c, bms);
+
+        double const f = fine_pct(&c);
+        if (f < lo) lo = f;
+        if (f > hi) hi = f;
+        if (coulomb_soc_pct(&c) == bms) ++same;
+        /* settled after a few corrections: 4 steps remove ~2/3 of the error */
+        if (steps >= 4U && fabs(f - truth) > err_max) err_max = fabs(f - truth);
+    }
+    printf("%-10s  soc2==bms %4u/%u  plateaus %u  min move/plateau %.2f %%  max err %.2f %%\n",
+           name, same, SIM_SAMPLES, plateaus, span_min, err_max);
+
+    CHECK(plateaus >= 4U);
+    CHECK(span_min >= 0.8);      /* moves through the percent, not pinned to it */
+    CHECK(err_max <= 0.6);       /* gain error bounded by the step corrections */
+}
+
+int main(void) {
+    run("exact", 1.00);
+    run("shunt +5%", 1.05);
+    run("shunt -5%", 0.95);
+
+    /* a BMS recalibration jump pulls 1/COULOMB_CORR_DIV of the way, once */
+    Coulomb c;
+    coulomb_start(&c, SIM_CAP_MAH, 50U, 0U);
+    coulomb_correct(&c, 50U);
+    CHECK(coulomb_soc_pct(&c) == 50U);
+    coulomb_correct(&c, 58U);
+    CHECK(coulomb_soc_pct(&c) == 52U);
+    coulomb_correct(&c, 58U);
+    CHECK(coulomb_soc_pct(&c) == 52U);
+
+    if (s_fail == 0U) printf("coulomb_sim: OK\n");
+    return (int)s_fail;
+}
@@ -0,0 +1,89 @@
+// nex_emu_host.c
+// Host driver for the Nextion emulator: replays the byte stream ao_nextion.c
+// produces for a page change and a couple of refreshes, then checks the model
+// and the meters. Exit status is the number of failed checks.
+
+#include "nex_emu.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static unsigned s_fail;
+static unsigned s_page_evts;
+static uint8_t  s_last_page = 0xFFU;
+static uint32_t s_now_ms;
+
+#define CHECK(cond_) do { \
+    if (!(cond_)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond_); ++s_fail; } \
+} while (0)
+
+/* stands in for Nextion_OnRx() */
+static void on_rx(uint8_t const *buf, uint16_t len) {
+    if (len >= 2U && buf[0] == 0x66U) {
+        ++s_page_evts;
+        s_last_page = buf[1];
+    }
+}
+
+/* same framing as nex_send3(): text + 0xFF 0xFF 0xFF */
+static void send3(char const *s) {
+    static uint8_t const end[3] = { 0xFFU, 0xFFU, 0xFFU };
+    NexEmu_feed((uint8_t const *)s, (uint16_t)strlen(s), s_now_ms);
+    NexEmu_feed(end, 3U, s_now_ms);
+    s_now_ms += 2U;     /* ~20 bytes at 115200 Bd */
+}
+
+static void paint_main(char const *volt) {
+    char buf[64];
+    send3("pMain.tBattType.txt=\"SMART 400s\"");
+    send3("pMain.tRecHead.txt=\"Operational\"");
+    snprintf(buf, sizeof(buf), "pMain.tVolt.txt=\"%s\"", volt);
+    send3(buf);
+    send3("pMain.tErrors.txt=\"No Errors\"");
+    send3("vis pMain.pWarn,0");
+    send3("pMain.tPsu.bco=2016");
+    send3("pMain.tOutState.bco=63488");
+}
+
+int main(void) {
+    NexEmu_init(&on_rx);
+
+    /* controller-commanded page change: no 0x66 comes back */
+    send3("page pMain");
+    CHECK(NexEmu_page() == 2U);
+    CHECK(s_page_evts == 0U);
+    CHECK(!NexEmu_isConsistent());
+
+    paint_main("52.1 V");
+    CHECK(NexEmu_isConsistent());
+    CHECK(NexEmu_stats()->redundant == 0U);
+    CHECK(strcmp(NexEmu_getTxt("pMain.tVolt"), "52.1 V") == 0);
+    CHECK(NexEmu_getVal("pMain.pWarn", "vis") == 0);
+
+    /* one changed value in an otherwise identical refresh */
+    uint32_t const writes0 = NexEmu_stats()->writes;
+    paint_main("52.3 V");
+    CHECK(NexEmu_stats()->writes - writes0 == 7U);
+    CHECK(NexEmu_stats()->redundant == 6U);
+
+    /* writes for a page that is not shown */
+    send3("pDetails.tHVolt.txt=\"3.41\"");
+    CHECK(NexEmu_stats()->offpage == 1U);
+
+    /* touch navigation on the panel reports the new page */
+    NexEmu_gotoPage(3U);
+    CHECK(s_page_evts == (NEX_EMU_SENDME ? 1U : 0U));
+    CHECK(!NEX_EMU_SENDME || s_last_page == 3U);
+
+    send3("sendme");
+    CHECK(s_page_evts == (NEX_EMU_SENDME ? 2U : 1U));
+    CHECK(s_last_page == 3U);
+
+    send3("bogus");
+    CHECK(NexEmu_stats()->unknown == 1U);
+    CHECK(NexEmu_stats()->page_changes == 2U);
+
+    NexEmu_report(s_now_ms);
+    printf("%s (%u failed)\n", s_fail ? "FAILED" : "OK", s_fail);
+    return (int)s_fail;
+}
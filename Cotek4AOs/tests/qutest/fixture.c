@@ -0,0 +1,239 @@
+// fixture.c
+// Shared part of the host QUTest fixtures, see fixture.h.
+
+#include "fixture.h"
+#include "qs_port.h"
+#include "qs_pkg.h"          /* QS_processTestEvts_() */
+#include "app_channels.h"
+#include "can_app.h"
+#include "ao_input.h"
+#include "j1939_tp.h"
+
+#include <stdio.h>
+#include <string.h>
+
+Q_DEFINE_THIS_MODULE("fixture")
+
+/* ===== HAL stand-ins (hal/stm32f1xx_hal.h) ===== */
+DWT_Type host_dwt;
+uint32_t SystemCoreClock = 72000000U;
+
+/* HAL_GetTick(), moved by Fixture_advance(). Starts a second after boot, so
+ * the HMI rate limits (ui_ok_now_sum() in ao_controller.c) are already open. */
+static uint32_t l_ms = 1000U;
+
+uint32_t HAL_GetTick(void) { return l_ms; }
+void HAL_Delay(uint32_t ms) { (void)ms; }  /* blocking waits take no fixture time */
+
+/* ===== Peers that are not under test in any fixture ===== */
+bool     Input_estopActive(void)  { return false; }
+uint32_t Input_estopCycles(void)  { return 0U; }
+void     BSP_idleStats(BspIdleStats *out) { memset(out, 0, sizeof(*out)); }
+
+/* The CAN driver: identity requests show up as FIX_QS_CAN_TX */
+bool CANAPP_Send(uint32_t id, const uint8_t *data, uint8_t dlc) {
+    char line[40];
+    int n = snprintf(line, sizeof(line), "%08lX", (unsigned long)id);
+    for (uint8_t k = 0U; k < dlc && n > 0 && (size_t)n < sizeof(line) - 3U; ++k) {
+        n += snprintf(&line[n], sizeof(line) - (size_t)n, "%s%02X", (k == 0U) ? " " : "", data[k]);
+    }
+    QS_BEGIN_ID(FIX_QS_CAN_TX, 0U)
+        QS_STR(line);
+    QS_END()
+    return true;
+}
+
+/* ===== Signals: dictionary + names for the trace ===== */
+#ifdef ENABLE_BMS_SIM
+#define FIX_SIG_SIM(X_)  X_(SIM_TICK_SIG)
+#else
+#define FIX_SIG_SIM(X_)
+#endif
+#ifdef ENABLE_NEX_EMU
+#define FIX_SIG_NEX_EMU(X_)  X_(NEX_EMU_TICK_SIG)
+#else
+#define FIX_SIG_NEX_EMU(X_)
+#endif
+
+#define FIX_SIGNALS(X_) \
+    X_(CAN_RX_SIG) X_(BMS_UPDATED_SIG) X_(BMS_NO_BATTERY_SIG) X_(BMS_CONN_LOST_SIG) \
+    X_(TIMEOUT_SIG) X_(CHARGE_TIMEOUT_SIG) X_(PSU_OFF_WAIT_TO_SIG) X_(BMS_TICK_SIG) \
+    X_(BMS_WATCHDOG_TO_SIG) X_(LOST_HOLD_TO_SIG) FIX_SIG_SIM(X_) \
+    X_(BOOT_SIG) X_(NEX_READY_SIG) X_(NEX_REQ_SHOW_PAGE_SIG) X_(NEX_REQ_UPDATE_SUMMARY_SIG) \
+    X_(NEX_REQ_UPDATE_LIVE_SIG) X_(NEX_REQ_UPDATE_DETAILS_SIG) X_(NEX_REQ_UPDATE_PSU_SIG) \
+    X_(NEX_REQ_UPDATE_CELLS_SIG) X_(NEX_REQ_UPDATE_FAULTS_SIG) \
+    X_(PSU_REQ_SETPOINT_SIG) X_(PSU_REQ_OFF_SIG) X_(PSU_RSP_STATUS_SIG) \
+    X_(COTEK_STATUS_SIG) X_(COTEK_TICK_SIG) X_(COTEK_RAMP_SIG) X_(J1939_MSG_SIG) \
+    X_(BUTTON_PRESSED_SIG) X_(BUTTON_RELEASED_SIG) X_(BUTTON_LONG_PRESS_SIG) \
+    X_(INPUT_EDGE_SIG) X_(INPUT_SAMPLE_SIG) X_(ESTOP_SIG) X_(ESTOP_RELEASE_SIG) \
+    X_(HMI_SELECT_SIG) X_(FAULT_HIST_CLEAR_SIG) FIX_SIG_NEX_EMU(X_)
+
+static char const *sig_name(QSignal sig) {
+#define FIX_SIG_CASE(s_)  case s_: return #s_;
+    switch (sig) {
+        FIX_SIGNALS(FIX_SIG_CASE)
+        default: return "?";
+    }
+#undef FIX_SIG_CASE
+}
+
+/* The part of each payload the scripts check */
+static void describe(QEvt const *e, char *out, size_t len) {
+    out[0] = '\0';
+    switch (e->sig) {
+        case BMS_UPDATED_SIG: {
+            BmsTelemetryEvt const *be = (BmsTelemetryEvt const *)e;
+            snprintf(out, len, " ch=%u type=%04X V=%.1f soc=%u", (unsigned)be->ch,
+                     (unsigned)be->data.battery_type_code,
+                     (double)be->data.array_voltage_V, (unsigned)be->data.soc_percent);
+            break;
+        }
+        case NEX_REQ_SHOW_PAGE_SIG:
+            snprintf(out, len, " page=%u", (unsigned)((NextionPageEvt const *)e)->page);
+            break;
+        case NEX_REQ_UPDATE_SUMMARY_SIG: {
+            NextionSummaryEvt const *se = (NextionSummaryEvt const *)e;
+            snprintf(out, len, " class=%s charging=%u warn=%u reason=%s", se->classStr,
+                     (unsigned)se->charging, (unsigned)se->warnIcon, se->reason);
+            break;
+        }
+        case NEX_REQ_UPDATE_PSU_SIG: {
+            NextionPsuEvt const *pe = (NextionPsuEvt const *)e;
+            snprintf(out, len, " present=%u on=%u", (unsigned)pe->present, (unsigned)pe->output_on);
+            break;
+        }
+        case PSU_REQ_SETPOINT_SIG: {
+            PsuSetEvt const *pe = (PsuSetEvt const *)e;
+            snprintf(out, len, " %.2fV %.2fA", (double)pe->voltSet, (double)pe->currSet);
+            break;
+        }
+        case PSU_RSP_STATUS_SIG: {
+            CotekStatusEvt const *ce = (CotekStatusEvt const *)e;
+            snprintf(out, len, " present=%u on=%u", (unsigned)ce->present, (unsigned)ce->out_on);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/* ===== Dummy peers ===== */
+#define FIX_MAX_DUMMIES  8U
+static struct {
+    QActive const *ao;
+    char const    *name;
+} l_dummy[FIX_MAX_DUMMIES];
+static uint8_t l_nDummy;
+
+void Fixture_dummy(QActiveDummy *d, char const *name, uint_fast8_t prio) {
+    Q_REQUIRE_ID(100, l_nDummy < FIX_MAX_DUMMIES);
+    QActiveDummy_ctor(d);
+    l_dummy[l_nDummy].ao   = &d->super;
+    l_dummy[l_nDummy].name = name;
+    ++l_nDummy;
+    QS_obj_dict_pre_(d, name);       /* QS_OBJ_DICTIONARY() would name it "d" */
+    QACTIVE_START(&d->super, prio, (QEvt const **)0, 0U, (void *)0, 0U, (void *)0);
+}
+
+static char const *dummy_name(QActive const *ao) {
+    for (uint8_t k = 0U; k < l_nDummy; ++k) {
+        if (l_dummy[k].ao == ao) return l_dummy[k].name;
+    }
+    return (char const *)0;
+}
+
+/* ===== Clock ===== */
+static QSpyId const l_clock = { 0U };       /* sender of the QF ticks */
+
+/* ms per tick of each QF tick rate, as the SysTick handler in bsp.c */
+static uint8_t const k_rate_ms[BSP_NUM_RATES] = {
+    [BSP_RATE_BASE] = 1000U / BSP_TICKS_PER_SEC,
+    [BSP_RATE_FAST] = 1000U / BSP_FAST_TICKS_PER_SEC,
+    [BSP_RATE_SLOW] = 1000U / BSP_SLOW_TICKS_PER_SEC,
+};
+static uint16_t l_tickDiv[BSP_NUM_RATES];
+
+void Fixture_advance(uint32_t ms) {
+    for (; ms != 0U; --ms) {
+        ++l_ms;
+        for (uint_fast8_t r = 0U; r < BSP_NUM_RATES; ++r) {
+            if (++l_tickDiv[r] >= k_rate_ms[r]) {
+                l_tickDiv[r] = 0U;
+                QTIMEEVT_TICK_X(r, &l_clock);
+                QS_processTestEvts_();
+            }
+        }
+    }
+}
+
+bool Fixture_command(uint8_t cmdId, uint32_t param1, uint32_t param2, uint32_t param3) {
+    (void)param2; (void)param3;
+    switch (cmdId) {
+        case FIX_CMD_ADVANCE:
+            Fixture_advance(param1);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* ===== Start-up ===== */
+/* The four pools of main(), smallest blocks first: CAN, BMS, TP, UI */
+typedef union {
+    NextionSummaryEvt a; NextionDetailsEvt b; NextionCellsEvt c; NextionFaultsEvt d;
+} FixUiEvt;
+_Static_assert(BSP_NUM_POOLS == 4U, "one pool per QF_poolInit() call of main()");
+
+void Fixture_init(int argc, char *argv[]) {
+    static QSubscrList subscrSto[MAX_PUB_SIG];
+    static QF_MPOOL_EL(CanFrameEvt)     canSto[32];
+    static QF_MPOOL_EL(BmsTelemetryEvt) bmsSto[16];
+    static QF_MPOOL_EL(J1939MsgEvt)     tpSto[J1939_TP_MAX_SESSIONS + 2U];
+    static QF_MPOOL_EL(FixUiEvt)        uiSto[16];
+
+    QF_init();
+    Q_ALLEGE(QS_INIT((argc > 1) ? argv[1] : (void *)0));
+    QF_psInit(subscrSto, Q_DIM(subscrSto));
+    QF_poolInit(canSto, sizeof(canSto), sizeof(canSto[0]));
+    QF_poolInit(bmsSto, sizeof(bmsSto), sizeof(bmsSto[0]));
+    QF_poolInit(tpSto,  sizeof(tpSto),  sizeof(tpSto[0]));
+    QF_poolInit(uiSto,  sizeof(uiSto),  sizeof(uiSto[0]));
+
+#define FIX_SIG_DICT(s_)  QS_SIG_DICTIONARY(s_, (void *)0);
+    FIX_SIGNALS(FIX_SIG_DICT)
+#undef FIX_SIG_DICT
+    QS_OBJ_DICTIONARY(&l_clock);
+    QS_USR_DICTIONARY(BSP_QS_CAN_RX);
+    QS_USR_DICTIONARY(BSP_QS_PSU_READ);
+    QS_USR_DICTIONARY(FIX_QS_POST);
+    QS_USR_DICTIONARY(FIX_QS_CAN_TX);
+    QS_USR_DICTIONARY(FIX_QS_NEX_TX);
+    QS_ENUM_DICTIONARY(FIX_CMD_ADVANCE, QS_CMD);
+}
+
+/* ===== QUTest callbacks common to all fixtures ===== */
+void QS_onTestSetup(void) {
+}
+
+void QS_onTestTeardown(void) {
+}
+
+void QS_onTestEvt(QEvt *e) {
+    (void)e;
+}
+
+void QS_onTestPost(void const *sender, QActive *recipient, QEvt const *e, bool status) {
+    (void)sender; (void)status;
+    char const *to = dummy_name(recipient);
+    if (to == (char const *)0) {         /* the AO under test: its own trace is enough */
+        return;
+    }
+    char line[160];
+    int const n = snprintf(line, sizeof(line), "%s %s", to, sig_name(e->sig));
+    if (n > 0 && (size_t)n < sizeof(line)) {
+        describe(e, &line[n], sizeof(line) - (size_t)n);
+    }
+    QS_BEGIN_ID(FIX_QS_POST, 0U)
+        QS_STR(line);
+    QS_END()
+}
@@ -0,0 +1,44 @@
+// fixture.h
+// Shared part of the host QUTest fixtures (test_<ao>.c, one per AO): the
+// clock behind HAL_GetTick(), dummy peers that trace every event they are
+// sent, and the commands every script can use. The AO under test is the
+// real firmware source; its peers are QActiveDummy objects.
+
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+#include "qpc.h"
+#include "bsp.h"
+#include "app_signals.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Application records of the fixtures, after the BSP ones (bsp.h). Each
+ * carries one string, so the script matches whole lines. */
+enum FixtureQsRecords {
+    FIX_QS_POST = BSP_QS_PSU_READ + 1,  /* "<to> <signal> [payload]": event sent to a dummy */
+    FIX_QS_CAN_TX,                      /* "<id> <data>": CANAPP_Send()                     */
+    FIX_QS_NEX_TX,                      /* one Nextion command, without the FF FF FF        */
+};
+
+/* Commands every fixture understands; its own follow FIX_CMD_USER */
+enum FixtureCommands {
+    FIX_CMD_ADVANCE = 0,    /* param1 ms: 1 kHz SysTick, all three tick rates (bsp.c) */
+    FIX_CMD_USER,
+};
+
+/* QF, QS (argv[1] = qspy "host[:port]"), event pools, dictionaries */
+void Fixture_init(int argc, char *argv[]);
+
+/* Start a dummy peer; what it is sent shows up as FIX_QS_POST "<name> ..." */
+void Fixture_dummy(QActiveDummy *d, char const *name, uint_fast8_t prio);
+
+/* Run the clock forward: HAL_GetTick() plus the QF ticks due on the way,
+ * each tick's events dispatched before the next ms */
+void Fixture_advance(uint32_t ms);
+
+/* The common commands; false when cmdId belongs to the fixture */
+bool Fixture_command(uint8_t cmdId, uint32_t param1, uint32_t param2, uint32_t param3);
+
+#endif /* FIXTURE_H */
@@ -0,0 +1,34 @@
+// stm32f1xx_hal.h
+// Host stand-in for the STM32F1 HAL, just what the AO sources under test
+// touch. Time is the fixture's clock (fixture.c), I2C and CAN never reach
+// here (the Cotek emulator and CANAPP_Send stub sit in front of them).
+
+#ifndef __STM32F1xx_HAL_H
+#define __STM32F1xx_HAL_H
+
+#include <stdint.h>
+
+typedef enum {
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef struct { uint32_t Instance; } UART_HandleTypeDef;
+typedef struct { uint32_t Instance; } I2C_HandleTypeDef;
+typedef struct { uint32_t Instance; } CAN_HandleTypeDef;
+
+/* BSP_cycles() reads DWT->CYCCNT; it stays 0, so cycle latencies log 0 */
+typedef struct { volatile uint32_t CYCCNT; } DWT_Type;
+extern DWT_Type host_dwt;
+#define DWT  (&host_dwt)
+
+extern uint32_t SystemCoreClock;
+
+uint32_t HAL_GetTick(void);
+void     HAL_Delay(uint32_t ms);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData,
+                                    uint16_t Size, uint32_t Timeout);
+
+#endif /* __STM32F1xx_HAL_H */
@@ -0,0 +1,3 @@
+// stm32f1xx_hal_gpio.h
+// Host stand-in: everything the AO sources use lives in stm32f1xx_hal.h.
+#include "stm32f1xx_hal.h"
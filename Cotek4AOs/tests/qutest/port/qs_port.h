@@ -0,0 +1,20 @@
+// qs_port.h
+// QS port for the host QUTest fixtures: the arm-cm/qutest QP port with
+// 64-bit object and function pointers. Found before qpc/ports/arm-cm/qutest,
+// which supplies qp_port.h.
+
+#ifndef QS_PORT_H_
+#define QS_PORT_H_
+
+#define QS_TIME_SIZE     4U
+#define QS_CTR_SIZE      4U   /* TX buffer over 64 KB, see qs_host.c */
+#define QS_OBJ_PTR_SIZE  8U
+#define QS_FUN_PTR_SIZE  8U
+
+#ifndef QP_PORT_H_
+#include "qp_port.h"
+#endif
+
+#include "qs.h"
+
+#endif // QS_PORT_H_
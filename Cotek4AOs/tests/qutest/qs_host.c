@@ -0,0 +1,122 @@
+// qs_host.c
+// QS link of the host fixtures: a TCP client of qspy (started with -t),
+// which qutest drives. The target side of the posix QUTest port, reduced
+// to what the fixtures need.
+
+#include "qpc.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define QS_HOST_DEFAULT  "localhost"
+#define QS_PORT_DEFAULT  "6601"
+
+static int l_sock = -1;
+
+/* arg = "host[:port]" from the command line, NULL for localhost:6601 */
+uint8_t QS_onStartup(void const *arg) {
+    static uint8_t qsBuf[64U * 1024U];  /* a long ADVANCE traces a lot in one step */
+    static uint8_t qsRxBuf[2048];
+    QS_initBuf(qsBuf, sizeof(qsBuf));
+    QS_rxInitBuf(qsRxBuf, sizeof(qsRxBuf));
+
+    char host[64];
+    char const *port = QS_PORT_DEFAULT;
+    snprintf(host, sizeof(host), "%s", (arg != (void *)0) ? (char const *)arg : QS_HOST_DEFAULT);
+    char *colon = strchr(host, ':');
+    if (colon != (char *)0) {
+        *colon = '\0';
+        port = colon + 1;
+    }
+
+    struct addrinfo hints, *res = (struct addrinfo *)0;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &res) != 0) {
+        fprintf(stderr, "QS: cannot resolve %s:%s\n", host, port);
+        return 0U;
+    }
+    for (struct addrinfo *ai = res; ai != (struct addrinfo *)0; ai = ai->ai_next) {
+        l_sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (l_sock >= 0 && connect(l_sock, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        if (l_sock >= 0) {
+            close(l_sock);
+            l_sock = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (l_sock < 0) {
+        fprintf(stderr, "QS: no qspy at %s:%s (start it with -t)\n", host, port);
+        return 0U;
+    }
+    return 1U;
+}
+
+void QS_onCleanup(void) {
+    if (l_sock >= 0) {
+        close(l_sock);
+        l_sock = -1;
+    }
+}
+
+void QS_onFlush(void) {
+    uint16_t nBytes = 0xFFFFU;
+    uint8_t const *block;
+    while ((block = QS_getBlock(&nBytes)) != (uint8_t *)0) {
+        while (nBytes != 0U && l_sock >= 0) {
+            ssize_t const n = send(l_sock, block, nBytes, 0);
+            if (n <= 0) {
+                QS_onCleanup();
+                exit(1);
+            }
+            block  += n;
+            nBytes -= (uint16_t)n;
+        }
+        nBytes = 0xFFFFU;
+    }
+}
+
+/* qutest restarts the executable after a reset */
+void QS_onReset(void) {
+    QS_onCleanup();
+    exit(0);
+}
+
+/* Feed what qspy sent to the QS-RX parser until the script says continue */
+void QS_onTestLoop(void) {
+    QS_rxPriv_.inTestLoop = true;
+    while (QS_rxPriv_.inTestLoop) {
+        fd_set readSet;
+        FD_ZERO(&readSet);
+        FD_SET(l_sock, &readSet);
+        struct timeval tmo = { 0, 10000 };   /* 10 ms */
+        if (select(l_sock + 1, &readSet, (fd_set *)0, (fd_set *)0, &tmo) < 0) {
+            QS_onCleanup();
+            exit(1);
+        }
+        if (FD_ISSET(l_sock, &readSet)) {
+            uint8_t buf[256];
+            uint16_t room = QS_rxGetNfree();
+            ssize_t const n = recv(l_sock, buf, (room < sizeof(buf)) ? room : sizeof(buf), 0);
+            if (n <= 0) {                    /* qspy went away */
+                QS_onCleanup();
+                exit(0);
+            }
+            for (ssize_t k = 0; k < n; ++k) {
+                (void)QS_rxPut(buf[k]);
+            }
+        }
+        QS_rxParse();
+        QS_onFlush();
+    }
+    QS_rxPriv_.inTestLoop = true;
+}
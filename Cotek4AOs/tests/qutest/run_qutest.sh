@@ -0,0 +1,25 @@
+#!/bin/sh
+# run_qutest.sh <fixture> <script.py>
+# Runs one QUTest script against its host fixture: qspy in TCP mode for the
+# target, qutest (QTools) driving the script and restarting the fixture on
+# every test. Exits 77 (ctest: skipped) when QTools is not installed.
+# EXPERIMENTAL: not yet run against real QTools; ctest only registers it
+# with -DQUTEST_EXPERIMENTAL=ON (tests/CMakeLists.txt).
+
+fixture=$1
+script=$2
+
+for tool in qspy qutest; do
+    if ! command -v "$tool" >/dev/null 2>&1; then
+        echo "$tool not on PATH: skipping $(basename "$script")"
+        exit 77
+    fi
+done
+
+qspy -t >/dev/null &
+qspy_pid=$!
+trap 'kill $qspy_pid 2>/dev/null' EXIT INT TERM
+sleep 1                      # let qspy open its ports
+
+cd "$(dirname "$script")" || exit 1
+qutest -e"$fixture" -qlocalhost "$(basename "$script")"
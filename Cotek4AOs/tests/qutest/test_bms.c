@@ -0,0 +1,57 @@
+// test_bms.c
+// QUTest fixture for AO_Bms (bay 0). The Controller is a dummy subscribed
+// to the telemetry; CAN frames come in through CAN_CMD_FRAME, as the RX
+// interrupt would post them after routing by source address.
+
+#include "fixture.h"
+#include "bms_app.h"
+#include "app_channels.h"
+
+#include <string.h>
+
+static QActiveDummy l_ctlDummy;
+
+QActive *AO_ControllerCh[APP_NUM_CHANNELS] = { &l_ctlDummy.super };
+
+enum {
+    BMS_CMD_FRAME = FIX_CMD_USER, /* param1 29-bit id, param2 data[0..3], param3 data[4..7] (BE) */
+};
+
+static void post_frame(uint32_t id, uint32_t hi, uint32_t lo) {
+    CanFrameEvt *ce = Q_NEW(CanFrameEvt, CAN_RX_SIG);
+    ce->id     = id;
+    ce->dlc    = 8U;
+    ce->isExt  = 1U;
+    ce->rx_cyc = BSP_cycles();
+    for (uint8_t k = 0U; k < 4U; ++k) {
+        ce->data[k]      = (uint8_t)(hi >> (24U - 8U * k));
+        ce->data[k + 4U] = (uint8_t)(lo >> (24U - 8U * k));
+    }
+    QACTIVE_POST(AO_BmsCh[0], &ce->super, &l_ctlDummy.super);
+}
+
+void QS_onCommand(uint8_t cmdId, uint32_t param1, uint32_t param2, uint32_t param3) {
+    if (Fixture_command(cmdId, param1, param2, param3)) {
+        return;
+    }
+    switch (cmdId) {
+        case BMS_CMD_FRAME: post_frame(param1, param2, param3); break;
+        default: break;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static QEvt const *bmsQueueSto[16];
+
+    Fixture_init(argc, argv);
+    QS_ENUM_DICTIONARY(BMS_CMD_FRAME, QS_CMD);
+
+    Fixture_dummy(&l_ctlDummy, "ctl", APP_PRIO_CTL(0U));
+    QActive_subscribe(&l_ctlDummy.super, BMS_UPDATED_SIG);
+
+    BmsAO_ctor();
+    QACTIVE_START(AO_BmsCh[0], APP_PRIO_BMS(0U),
+                  bmsQueueSto, Q_DIM(bmsQueueSto), (void *)0, 0U, (void *)0);
+
+    return QF_run();
+}
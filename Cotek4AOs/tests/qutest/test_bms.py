@@ -0,0 +1,75 @@
+# test_bms.py
+# EXPERIMENTAL: not yet run against real QTools (see run_qutest.sh).
+# QUTest script for AO_Bms, bay 0 (fixture: test_bms.c).
+# Run by run_qutest.sh; every test starts from a fresh target, no pack seen.
+
+# Frames, as (id, data[0..3], data[4..7]) big-endian
+PACK_400S = (0x18070800, 0x98583C00, 0)   # 400s pack V/SOC: 46.8 V, 60 %
+ARRAY_500 = (0x18FF0700, 0x01D43C00, 0)   # 500s HYP array:  46.8 V, 60 %
+
+ID_REQ_400 = "@timestamp FIX_QS_CAN_TX 18EAFFF9 000400"
+
+def on_reset():
+    glb_filter(GRP_UA)
+
+def frame(f):
+    command("BMS_CMD_FRAME", f[0], f[1], f[2])
+
+def advance(ms):
+    command("FIX_CMD_ADVANCE", ms)
+
+# ----------------------------------------------------------------------------
+test("No pack: BMS_NO_BATTERY_SIG at the 2 Hz publish rate")
+advance(500)
+expect("@timestamp FIX_QS_POST ctl BMS_NO_BATTERY_SIG")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+# ----------------------------------------------------------------------------
+test("Battery insert: identity request, then published telemetry")
+frame(PACK_400S)
+expect(ID_REQ_400)
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+advance(500)
+expect(ID_REQ_400)
+expect(ID_REQ_400)
+expect("@timestamp FIX_QS_POST ctl BMS_UPDATED_SIG ch=0 type=0400 V=46.8 soc=60")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+# ----------------------------------------------------------------------------
+test("Family lock: a stray 400s frame does not move a locked 500s pack")
+frame(ARRAY_500)
+expect("@timestamp FIX_QS_CAN_TX 18EAFFF9 40FF00")
+expect("@timestamp FIX_QS_CAN_TX 18EAFFF9 19FF00")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+frame(ARRAY_500)                          # second strong ID: locked
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+frame(PACK_400S)
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+advance(500)
+expect("@timestamp FIX_QS_CAN_TX 18EAFFF9 40FF00")
+expect("@timestamp FIX_QS_CAN_TX 18EAFFF9 19FF00")
+expect("@timestamp FIX_QS_CAN_TX 18EAFFF9 40FF00")
+expect("@timestamp FIX_QS_CAN_TX 18EAFFF9 19FF00")
+expect("@timestamp FIX_QS_POST ctl BMS_UPDATED_SIG ch=0 type=0500 V=46.8 soc=60")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+# ----------------------------------------------------------------------------
+test("Comms loss: BMS_CONN_LOST_SIG on the first 10 Hz tick past 1500 ms")
+frame(PACK_400S)
+expect(ID_REQ_400)
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+advance(1599)                             # last tick at 1500 ms: not yet
+expect(ID_REQ_400)
+expect(ID_REQ_400)
+expect("@timestamp FIX_QS_POST ctl BMS_UPDATED_SIG ch=0 type=0400 V=46.8 soc=60")
+expect(ID_REQ_400)
+expect(ID_REQ_400)
+expect("@timestamp FIX_QS_POST ctl BMS_UPDATED_SIG ch=0 type=0400 V=46.8 soc=60")
+expect("@timestamp FIX_QS_POST ctl BMS_UPDATED_SIG ch=0 type=0400 V=46.8 soc=60")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+advance(1)
+expect("@timestamp FIX_QS_POST ctl BMS_CONN_LOST_SIG")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+advance(500)                              # snapshot wiped: no pack again
+expect("@timestamp FIX_QS_POST ctl BMS_NO_BATTERY_SIG")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
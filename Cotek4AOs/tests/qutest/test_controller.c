@@ -0,0 +1,90 @@
+// test_controller.c
+// QUTest fixture for AO_Controller (bay 0). The PSU and the panel are dummies;
+// telemetry and PSU status come in through commands, the rest is posted by
+// test_controller.py.
+
+#include "fixture.h"
+#include "ao_controller.h"
+#include "ao_cotek.h"
+#include "ao_nextion.h"
+#include "app_channels.h"
+#include "bms_debug.h"
+
+#include <string.h>
+
+static QActiveDummy l_psuDummy;
+static QActiveDummy l_nexDummy;
+static QActiveDummy l_bmsDummy;     /* publisher of the telemetry */
+
+QActive *AO_CotekCh[APP_NUM_CHANNELS] = { &l_psuDummy.super };
+QActive *const AO_Nextion = &l_nexDummy.super;
+
+/* Cotek_isPresentCh() of ao_cotek.c, set by CTL_CMD_PSU */
+static uint8_t l_psuPresent;
+uint8_t Cotek_isPresentCh(uint8_t ch) { (void)ch; return l_psuPresent; }
+
+enum {
+    CTL_CMD_BMS = FIX_CMD_USER,   /* param1 pack (CtlPack), param2 hottest sensor degC */
+    CTL_CMD_PSU,                  /* param1 present, param2 output on */
+};
+
+/* Telemetry presets of CTL_CMD_BMS */
+enum CtlPack {
+    CTL_PACK_400S,                /* 12s 400s at 3.9 V/cell: Operational, CC charge */
+    CTL_PACK_UNKNOWN,             /* family without a classification rule */
+};
+
+static void post_bms(uint32_t pack, uint32_t temp_C) {
+    BmsTelemetryEvt *be = Q_NEW(BmsTelemetryEvt, BMS_UPDATED_SIG);
+    memset(&be->data, 0, sizeof(be->data));
+    be->ch = 0U;
+    be->data.battery_type_code = (pack == CTL_PACK_400S) ? 0x0400U : 0x0700U;
+    be->data.high_cell_V       = 3.92f;
+    be->data.low_cell_V        = 3.88f;
+    be->data.array_voltage_V   = 46.8f;
+    be->data.soc_percent       = 60U;
+    be->data.sys_temp_high_C   = (float)temp_C;
+    be->data.sys_temp_low_C    = (float)temp_C;
+    last_bms_ms[0] = HAL_GetTick();           /* what bms_on_frame() stamps per frame */
+    QACTIVE_PUBLISH(&be->super, &l_bmsDummy.super);
+}
+
+static void post_psu(uint32_t present, uint32_t on) {
+    CotekStatusEvt *se = Q_NEW(CotekStatusEvt, PSU_RSP_STATUS_SIG);
+    se->present = (uint8_t)present;
+    se->out_on  = (uint8_t)on;
+    se->v_out   = on ? 47.5f : 0.0f;
+    se->i_out   = on ? 3.0f : 0.0f;
+    se->t_out   = 30.0f;
+    l_psuPresent = (uint8_t)present;
+    QACTIVE_POST(AO_ControllerCh[0], &se->super, &l_psuDummy.super);
+}
+
+void QS_onCommand(uint8_t cmdId, uint32_t param1, uint32_t param2, uint32_t param3) {
+    if (Fixture_command(cmdId, param1, param2, param3)) {
+        return;
+    }
+    switch (cmdId) {
+        case CTL_CMD_BMS: post_bms(param1, param2); break;
+        case CTL_CMD_PSU: post_psu(param1, param2); break;
+        default: break;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static QEvt const *ctlQueueSto[16];
+
+    Fixture_init(argc, argv);
+    QS_ENUM_DICTIONARY(CTL_CMD_BMS, QS_CMD);
+    QS_ENUM_DICTIONARY(CTL_CMD_PSU, QS_CMD);
+
+    Fixture_dummy(&l_psuDummy, "psu", APP_PRIO_COTEK(0U));
+    Fixture_dummy(&l_nexDummy, "nex", APP_PRIO_NEXTION);
+    Fixture_dummy(&l_bmsDummy, "bms", APP_PRIO_BMS(0U));
+
+    ControllerAO_ctor();
+    QACTIVE_START(AO_ControllerCh[0], APP_PRIO_CTL(0U),
+                  ctlQueueSto, Q_DIM(ctlQueueSto), (void *)0, 0U, (void *)0);
+
+    return QF_run();
+}
@@ -0,0 +1,109 @@
+# test_controller.py
+# EXPERIMENTAL: not yet run against real QTools (see run_qutest.sh).
+# QUTest script for AO_Controller, bay 0 (fixture: test_controller.c).
+# Run by run_qutest.sh; every test starts from a fresh target in Ctl_wait.
+
+# enum CtlPack of the fixture
+CTL_PACK_400S    = 0
+CTL_PACK_UNKNOWN = 1
+
+def on_reset():
+    glb_filter(GRP_UA)
+    current_obj(OBJ_AO, "l_ctl[0]")
+
+# Telemetry of a 12s 400s pack at 25 C arrives, page 2 comes up
+def insert_400s():
+    command("CTL_CMD_BMS", CTL_PACK_400S, 25)
+    expect("@timestamp FIX_QS_POST nex NEX_REQ_SHOW_PAGE_SIG page=2")
+    expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Batt Operat* charging=0 warn=0 reason=")
+    expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_PSU_SIG present=0 on=0")
+    expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Batt Operat* charging=0 warn=0 reason=BMS updated")
+    expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_DETAILS_SIG")
+    expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+# PSU reports present and off
+def psu_idle():
+    command("CTL_CMD_PSU", 1, 0)
+    expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_PSU_SIG present=1 on=0")
+    expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+# Run the fixture clock; 200 ms also clears the 120 ms summary rate limit
+def advance(ms):
+    command("FIX_CMD_ADVANCE", ms)
+    expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+def start_charge():
+    post("BUTTON_PRESSED_SIG")
+    expect("@timestamp FIX_QS_POST psu PSU_REQ_SETPOINT_SIG 48.00V 3.00A")
+    expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Batt Operat* charging=1 warn=0 reason=charging CC")
+    expect("@timestamp Trg-Done QS_RX_EVENT")
+
+# ----------------------------------------------------------------------------
+test("Battery insert: page 2, summary and details")
+insert_400s()
+
+# ----------------------------------------------------------------------------
+test("Unknown family: the button does not start a charge")
+command("CTL_CMD_BMS", CTL_PACK_UNKNOWN, 25)
+expect("@timestamp FIX_QS_POST nex NEX_REQ_SHOW_PAGE_SIG page=2")
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Unknown charging=0 warn=0 reason=")
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_PSU_SIG present=0 on=0")
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Unknown charging=0 warn=0 reason=BMS updated")
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_DETAILS_SIG")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+psu_idle()
+advance(200)
+post("BUTTON_PRESSED_SIG")
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Unknown charging=0 warn=0 reason=Unknown status * cannot start")
+expect("@timestamp Trg-Done QS_RX_EVENT")
+
+# ----------------------------------------------------------------------------
+test("PSU missing: no setpoint")
+insert_400s()
+advance(200)
+post("BUTTON_PRESSED_SIG")
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Batt Operat* charging=0 warn=0 reason=PSU not present/error")
+expect("@timestamp Trg-Done QS_RX_EVENT")
+
+# ----------------------------------------------------------------------------
+test("Charge start: CC setpoint of the 400s profile")
+insert_400s()
+psu_idle()
+advance(200)
+start_charge()
+
+# ----------------------------------------------------------------------------
+test("Over-temp: PSU off above 35 C")
+insert_400s()
+psu_idle()
+advance(200)
+start_charge()
+advance(200)
+command("CTL_CMD_BMS", CTL_PACK_400S, 40)
+expect("@timestamp FIX_QS_POST psu PSU_REQ_OFF_SIG")
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Batt Operat* charging=0 warn=0 reason=Stopped: temp > 35C")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+# ----------------------------------------------------------------------------
+test("Comms loss: PSU off in the same step, retried after 200 fast ticks")
+insert_400s()
+psu_idle()
+advance(200)
+start_charge()
+advance(200)
+post("BMS_CONN_LOST_SIG")
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Unknown charging=0 warn=0 reason=Stopped: BMS lost")
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Comms Lost! charging=0 warn=1 reason=Check the battery connection")
+expect("@timestamp FIX_QS_POST psu PSU_REQ_OFF_SIG")    # Ctl_charge
+expect("@timestamp FIX_QS_POST psu PSU_REQ_OFF_SIG")    # Ctl_poweringDown entry
+expect("@timestamp Trg-Done QS_RX_EVENT")
+# 0 ticks from BMS_CONN_LOST_SIG to PSU_REQ_OFF_SIG; the retry is due after
+# BSP_FAST_TICKS_PER_SEC/5 fast ticks (1 ms each), not one earlier
+advance(199)
+command("FIX_CMD_ADVANCE", 1)
+expect("@timestamp FIX_QS_POST psu PSU_REQ_OFF_SIG")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+command("CTL_CMD_PSU", 1, 0)
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_PSU_SIG present=1 on=0")
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_SUMMARY_SIG class=Unknown charging=0 warn=0 reason=power off confirmed")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
@@ -0,0 +1,46 @@
+// test_cotek.c
+// QUTest fixture for AO_Cotek (bay 0) on the register-level emulator
+// (cotek_emu.c, ENABLE_COTEK_EMU). The Controller and the panel are dummies;
+// setpoints and OFF are posted by test_cotek.py.
+
+#include "fixture.h"
+#include "ao_cotek.h"
+#include "ao_nextion.h"
+#include "app_channels.h"
+#include "cotek_emu.h"
+
+static QActiveDummy l_ctlDummy;
+static QActiveDummy l_nexDummy;
+
+QActive *AO_ControllerCh[APP_NUM_CHANNELS] = { &l_ctlDummy.super };
+QActive *const AO_Nextion = &l_nexDummy.super;
+
+enum {
+    COTEK_CMD_PLUG = FIX_CMD_USER,  /* param1 0: supply unplugged, 1: plugged in */
+};
+
+void QS_onCommand(uint8_t cmdId, uint32_t param1, uint32_t param2, uint32_t param3) {
+    if (Fixture_command(cmdId, param1, param2, param3)) {
+        return;
+    }
+    switch (cmdId) {
+        case COTEK_CMD_PLUG: CotekEmu_cfg()->present = (param1 != 0U); break;
+        default: break;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static QEvt const *psuQueueSto[16];
+
+    Fixture_init(argc, argv);
+    QS_ENUM_DICTIONARY(COTEK_CMD_PLUG, QS_CMD);
+
+    Fixture_dummy(&l_ctlDummy, "ctl", APP_PRIO_CTL(0U));
+    Fixture_dummy(&l_nexDummy, "nex", APP_PRIO_NEXTION);
+
+    CotekAO_ctor();
+    QACTIVE_START(AO_CotekCh[0], APP_PRIO_COTEK(0U),
+                  psuQueueSto, Q_DIM(psuQueueSto), (void *)0, 0U, (void *)0);
+
+    return QF_run();
+}
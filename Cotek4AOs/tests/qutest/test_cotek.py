@@ -0,0 +1,63 @@
+# test_cotek.py
+# EXPERIMENTAL: not yet run against real QTools (see run_qutest.sh).
+# QUTest script for AO_Cotek, bay 0, on the emulated supply (fixture:
+# test_cotek.c). Run by run_qutest.sh; every test starts from a fresh target
+# with the supply plugged in and not yet polled.
+
+PSU_READ = "@timestamp BSP_QS_PSU_READ *"   # raw registers, one per 500 ms poll
+
+def on_reset():
+    glb_filter(GRP_UA)
+    current_obj(OBJ_AO, "l_psu[0]")
+
+def poll(*lines):
+    command("FIX_CMD_ADVANCE", 500)
+    expect(PSU_READ)
+    for l in lines:
+        expect("@timestamp FIX_QS_POST " + l)
+    expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+def found():
+    poll("nex NEX_REQ_UPDATE_PSU_SIG present=1 on=0",
+         "ctl PSU_RSP_STATUS_SIG present=1 on=0")
+
+# ----------------------------------------------------------------------------
+test("Supply found on the first poll, reported once")
+found()
+poll()
+
+# ----------------------------------------------------------------------------
+test("Charge start: output on at once, current ramps from zero")
+found()
+post("PSU_REQ_SETPOINT_SIG", pack("<ff", 48.0, 3.0))
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_PSU_SIG present=1 on=1")
+expect("@timestamp Trg-Done QS_RX_EVENT")
+poll("nex NEX_REQ_UPDATE_PSU_SIG present=1 on=1",
+     "ctl PSU_RSP_STATUS_SIG present=1 on=1")
+
+# ----------------------------------------------------------------------------
+test("Off: the next poll reads the output off")
+found()
+post("PSU_REQ_SETPOINT_SIG", pack("<ff", 48.0, 3.0))
+expect("@timestamp FIX_QS_POST nex NEX_REQ_UPDATE_PSU_SIG present=1 on=1")
+expect("@timestamp Trg-Done QS_RX_EVENT")
+poll("nex NEX_REQ_UPDATE_PSU_SIG present=1 on=1",
+     "ctl PSU_RSP_STATUS_SIG present=1 on=1")
+post("PSU_REQ_OFF_SIG")
+expect("@timestamp Trg-Done QS_RX_EVENT")
+poll("nex NEX_REQ_UPDATE_PSU_SIG present=1 on=0",
+     "ctl PSU_RSP_STATUS_SIG present=1 on=0")
+
+# ----------------------------------------------------------------------------
+test("PSU missing: gone after 1000 ms without a reply, setpoints refused")
+found()
+command("COTEK_CMD_PLUG", 0)
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+poll()
+poll("nex NEX_REQ_UPDATE_PSU_SIG present=0 on=0",
+     "ctl PSU_RSP_STATUS_SIG present=0 on=0")
+post("PSU_REQ_SETPOINT_SIG", pack("<ff", 48.0, 3.0))
+expect("@timestamp Trg-Done QS_RX_EVENT")
+command("COTEK_CMD_PLUG", 1)
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+found()
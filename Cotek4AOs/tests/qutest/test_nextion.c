@@ -0,0 +1,118 @@
+// test_nextion.c
+// QUTest fixture for AO_Nextion. The Controller is a dummy; every command
+// sent to the panel shows up as FIX_QS_NEX_TX, touch events come in through
+// NEX_CMD_RX as the UART RX callback would hand them over.
+
+#include "fixture.h"
+#include "ao_nextion.h"
+#include "app_channels.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static QActiveDummy l_ctlDummy;
+
+QActive *AO_ControllerCh[APP_NUM_CHANNELS] = { &l_ctlDummy.super };
+
+/* USART3: bytes collect up to the FF FF FF terminator, one record per command */
+UART_HandleTypeDef huart3;
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData,
+                                    uint16_t Size, uint32_t Timeout) {
+    static char    cmd[160];
+    static uint8_t len, ends;
+    (void)huart; (void)Timeout;
+    for (uint16_t k = 0U; k < Size; ++k) {
+        if (pData[k] == 0xFFU) {
+            if (++ends == 3U) {
+                cmd[len] = '\0';
+                QS_BEGIN_ID(FIX_QS_NEX_TX, 0U)
+                    QS_STR(cmd);
+                QS_END()
+                len  = 0U;
+                ends = 0U;
+            }
+        } else if (len < sizeof(cmd) - 1U) {
+            cmd[len++] = (char)pData[k];
+        }
+    }
+    return HAL_OK;
+}
+
+enum {
+    NEX_CMD_SUMMARY = FIX_CMD_USER, /* param1 summary preset (NexSummary) */
+    NEX_CMD_PSU,                    /* param1 present, param2 output on   */
+    NEX_CMD_RX,                     /* param1 up to 4 bytes, LSB first; param2 length */
+};
+
+/* Summary presets of NEX_CMD_SUMMARY, as AO_Controller fills them */
+enum NexSummary {
+    NEX_SUM_400S_READY,             /* pack identified, ready to charge */
+    NEX_SUM_COMMS_LOST,             /* BMS gone: warning icon on        */
+};
+
+static void post_summary(uint32_t preset) {
+    NextionSummaryEvt *se = Q_NEW(NextionSummaryEvt, NEX_REQ_UPDATE_SUMMARY_SIG);
+    memset((uint8_t *)se + sizeof(QEvt), 0, sizeof(*se) - sizeof(QEvt));
+    if (preset == NEX_SUM_400S_READY) {
+        snprintf(se->classStr, sizeof(se->classStr), "Operational");
+        snprintf(se->battTypeStr, sizeof(se->battTypeStr), "400s");
+        se->typeColor565  = 2016U;
+        se->classColor565 = 2016U;
+        se->packV         = 46.8f;
+        snprintf(se->reason, sizeof(se->reason), "ready to charge");
+    } else {
+        snprintf(se->classStr, sizeof(se->classStr), "Comms Lost!");
+        se->classColor565 = 63488U;
+        se->warnIcon      = 1U;
+        snprintf(se->reason, sizeof(se->reason), "Check the battery connection");
+    }
+    QACTIVE_POST(AO_Nextion, &se->super, &l_ctlDummy.super);
+}
+
+static void post_psu(uint32_t present, uint32_t on) {
+    NextionPsuEvt *pe = Q_NEW(NextionPsuEvt, NEX_REQ_UPDATE_PSU_SIG);
+    pe->present   = (uint8_t)present;
+    pe->output_on = (uint8_t)on;
+    pe->v_out     = on ? 48.0f : 0.0f;
+    pe->i_out     = 0.0f;
+    pe->temp_C    = 30.0f;
+    QACTIVE_POST(AO_Nextion, &pe->super, &l_ctlDummy.super);
+}
+
+static void rx(uint32_t bytes, uint32_t len) {
+    uint8_t buf[4];
+    for (uint8_t k = 0U; k < sizeof(buf); ++k) {
+        buf[k] = (uint8_t)(bytes >> (8U * k));
+    }
+    Nextion_OnRx(buf, (uint16_t)((len < sizeof(buf)) ? len : sizeof(buf)));
+}
+
+void QS_onCommand(uint8_t cmdId, uint32_t param1, uint32_t param2, uint32_t param3) {
+    if (Fixture_command(cmdId, param1, param2, param3)) {
+        return;
+    }
+    switch (cmdId) {
+        case NEX_CMD_SUMMARY: post_summary(param1);  break;
+        case NEX_CMD_PSU:     post_psu(param1, param2); break;
+        case NEX_CMD_RX:      rx(param1, param2);    break;
+        default: break;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static QEvt const *nexQueueSto[16];
+
+    Fixture_init(argc, argv);
+    QS_ENUM_DICTIONARY(NEX_CMD_SUMMARY, QS_CMD);
+    QS_ENUM_DICTIONARY(NEX_CMD_PSU, QS_CMD);
+    QS_ENUM_DICTIONARY(NEX_CMD_RX, QS_CMD);
+
+    Fixture_dummy(&l_ctlDummy, "ctl", APP_PRIO_CTL(0U));
+
+    NextionAO_ctor();
+    QACTIVE_START(AO_Nextion, APP_PRIO_NEXTION,
+                  nexQueueSto, Q_DIM(nexQueueSto), (void *)0, 0U, (void *)0);
+
+    return QF_run();
+}
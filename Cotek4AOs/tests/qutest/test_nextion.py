@@ -0,0 +1,81 @@
+# test_nextion.py
+# EXPERIMENTAL: not yet run against real QTools (see run_qutest.sh).
+# QUTest script for AO_Nextion (fixture: test_nextion.c).
+# Run by run_qutest.sh; every test starts from a fresh target.
+
+# enum NexSummary of the fixture
+NEX_SUM_400S_READY = 0
+NEX_SUM_COMMS_LOST = 1
+
+def on_reset():
+    glb_filter(GRP_UA)
+    current_obj(OBJ_AO, "l_nex")
+
+def tx(cmd):
+    expect("@timestamp FIX_QS_NEX_TX " + cmd)
+
+# ----------------------------------------------------------------------------
+test("Battery insert: pMain with the 400s pack")
+post("NEX_REQ_SHOW_PAGE_SIG", pack("<B", 2))
+tx("page pMain")
+tx("vis pMain.pWarn,0")
+tx("ref pMain.pWarn")
+expect("@timestamp Trg-Done QS_RX_EVENT")
+command("NEX_CMD_SUMMARY", NEX_SUM_400S_READY)
+tx('pMain.tBattType.txt="Battery: 400s"')
+tx("pMain.rTypeBar.bco=2016")
+tx('pMain.tRecHead.txt="Operational"')
+tx("pMain.tRecHead.pco=2016")
+tx("ref pMain.tRecHead")
+tx('pMain.tVolt.txt="46.80 V"')
+tx('pMain.tErrors.txt="None"')
+tx("vis pMain.pWarn,0")
+tx("ref pMain.pWarn")
+tx('pMain.tRecReason.txt="ready to charge"')
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+# ----------------------------------------------------------------------------
+test("Comms loss: warning icon on, no battery type")
+command("NEX_CMD_SUMMARY", NEX_SUM_COMMS_LOST)
+tx('pMain.tRecHead.txt="Comms Lost!"')
+tx("pMain.tRecHead.pco=63488")
+tx("ref pMain.tRecHead")
+tx('pMain.tVolt.txt="0.00 V"')
+tx('pMain.tErrors.txt="None"')
+tx("vis pMain.pWarn,1")
+tx("ref pMain.pWarn")
+tx('pMain.tRecReason.txt="Check the battery connection"')
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+# ----------------------------------------------------------------------------
+test("PSU missing: PSU and output groups red")
+command("NEX_CMD_PSU", 0, 0)
+tx('pMain.tPsu.txt="PSU: Missing"')
+tx('pMain.tOutState.txt="Output: OFF"')
+tx('pMain.tOutV.txt="Vout: 0.0 V"')
+tx('pMain.tOutI.txt="Iout: 0.0 A"')
+tx('pMain.tOutT.txt="Temp: 30 C"')
+tx("pMain.tPsu.bco=63488")
+tx("pMain.tOutState.bco=63488")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+# ----------------------------------------------------------------------------
+test("Charge start: output ON, both groups green")
+command("NEX_CMD_PSU", 1, 1)
+tx('pMain.tPsu.txt="PSU: Detected"')
+tx('pMain.tOutState.txt="Output: ON"')
+tx('pMain.tOutV.txt="Vout: 48.0 V"')
+tx('pMain.tOutI.txt="Iout: 0.0 A"')
+tx('pMain.tOutT.txt="Temp: 30 C"')
+tx("pMain.tPsu.bco=2016")
+tx("pMain.tOutState.bco=2016")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+
+# ----------------------------------------------------------------------------
+test("Touch: page change and fault clear go to the shown bay's Controller")
+command("NEX_CMD_RX", 0x0366, 2)          # 66 03: page 3 (pDetails)
+expect("@timestamp FIX_QS_POST ctl NEX_REQ_SHOW_PAGE_SIG page=3")
+expect("@timestamp Trg-Done QS_RX_COMMAND")
+command("NEX_CMD_RX", 0x01150565, 4)      # 65 05 15 01: bClear pressed
+expect("@timestamp FIX_QS_POST ctl FAULT_HIST_CLEAR_SIG")
+expect("@timestamp Trg-Done QS_RX_COMMAND")